@@ -0,0 +1,119 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2017 - 2021, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+-- Vertex
+
+#version 430 core
+
+in vec2 vertexPosition;
+in vec2 vertexTexCoord;
+out vec2 st;
+
+void main() {
+    st = vertexTexCoord;
+    gl_Position = vec4(vertexPosition, 0., 1.);
+}
+
+
+-- Fragment.Seed
+
+#version 430 core
+
+// Jump flooding seeds: xy stores the nearest occluder pixel, zw the nearest free pixel (negative: unknown)
+uniform sampler2D inputTexture; // Occluder mask
+out vec4 fragColor;
+
+void main() {
+    vec2 pixel = gl_FragCoord.xy;
+    bool occluder = texelFetch(inputTexture, ivec2(gl_FragCoord.xy), 0).a > 0.5;
+    fragColor = occluder ? vec4(pixel, -1.0, -1.0) : vec4(-1.0, -1.0, pixel);
+}
+
+
+-- Fragment.JumpFlood
+
+#version 430 core
+
+uniform sampler2D inputTexture; // Seeds of the last pass
+uniform int stepSize;
+out vec4 fragColor;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(inputTexture, 0);
+    vec2 position = gl_FragCoord.xy;
+    vec4 nearest = vec4(-1.0);
+    float nearestOccluderDist = 1e20, nearestFreeDist = 1e20;
+
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            ivec2 samplePixel = pixel + ivec2(x, y) * stepSize;
+            if (any(lessThan(samplePixel, ivec2(0))) || any(greaterThanEqual(samplePixel, size))) {
+                continue;
+            }
+            vec4 seeds = texelFetch(inputTexture, samplePixel, 0);
+            if (seeds.x >= 0.0) {
+                vec2 diff = seeds.xy - position;
+                float dist = dot(diff, diff);
+                if (dist < nearestOccluderDist) {
+                    nearestOccluderDist = dist;
+                    nearest.xy = seeds.xy;
+                }
+            }
+            if (seeds.z >= 0.0) {
+                vec2 diff = seeds.zw - position;
+                float dist = dot(diff, diff);
+                if (dist < nearestFreeDist) {
+                    nearestFreeDist = dist;
+                    nearest.zw = seeds.zw;
+                }
+            }
+        }
+    }
+
+    fragColor = nearest;
+}
+
+
+-- Fragment.Distance
+
+#version 430 core
+
+uniform sampler2D inputTexture; // Result of the jump flooding
+uniform float worldPerPixel;
+out vec4 fragColor;
+
+void main() {
+    vec4 seeds = texelFetch(inputTexture, ivec2(gl_FragCoord.xy), 0);
+    vec2 position = gl_FragCoord.xy;
+    float occluderDist = seeds.x >= 0.0 ? length(seeds.xy - position) : 1e6;
+    float freeDist = seeds.z >= 0.0 ? length(seeds.zw - position) : 1e6;
+    // Negative inside of occluders. The seeds are pixel centers, so the boundary lies half a pixel closer.
+    float signedDist = occluderDist > 0.0 ? occluderDist - 0.5 : 0.5 - freeDist;
+    fragColor = vec4(signedDist * worldPerPixel, 0.0, 0.0, 1.0);
+}
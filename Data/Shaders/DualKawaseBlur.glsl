@@ -0,0 +1,106 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2020 - 2021, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+-- Compute.Downsample
+
+#version 430 core
+
+#define TILE_SIZE 16
+layout(local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+uniform sampler2D inputTexture;
+layout(rgba16f, binding = 0) writeonly uniform image2D outputImage;
+
+// Input texels read by the work group: Each output reads a 4x4 footprint, neighboring footprints overlap by two texels
+#define SHARED_SIZE (2 * TILE_SIZE + 2)
+shared vec3 tile[SHARED_SIZE][SHARED_SIZE];
+
+void main() {
+    ivec2 inputSize = textureSize(inputTexture, 0);
+    ivec2 tileOrigin = ivec2(gl_WorkGroupID.xy) * (2 * TILE_SIZE) - 1;
+    for (int i = int(gl_LocalInvocationIndex); i < SHARED_SIZE * SHARED_SIZE; i += TILE_SIZE * TILE_SIZE) {
+        ivec2 sharedPos = ivec2(i % SHARED_SIZE, i / SHARED_SIZE);
+        ivec2 texelPos = clamp(tileOrigin + sharedPos, ivec2(0), inputSize - 1);
+        tile[sharedPos.y][sharedPos.x] = texelFetch(inputTexture, texelPos, 0).rgb;
+    }
+    barrier();
+
+    ivec2 outputPos = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(outputPos, imageSize(outputImage)))) {
+        return;
+    }
+
+    // Dual filter downsampling: Four times the bilinear sample at the center plus the bilinear samples at the four
+    // corners one input texel away, divided by eight. Resolved to texels, the inner 2x2 texels of the footprint have
+    // the weight 5/32 and the twelve outer ones 1/32.
+    ivec2 base = 2 * ivec2(gl_LocalInvocationID.xy);
+    vec3 sum = vec3(0.0);
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            bool inner = x > 0 && x < 3 && y > 0 && y < 3;
+            sum += tile[base.y + y][base.x + x] * (inner ? 5.0 : 1.0);
+        }
+    }
+    imageStore(outputImage, outputPos, vec4(sum / 32.0, 1.0));
+}
+
+
+-- Compute.Upsample
+
+#version 430 core
+
+#ifndef OUTPUT_FORMAT
+#define OUTPUT_FORMAT rgba16f
+#endif
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+uniform sampler2D inputTexture; // The next coarser level
+uniform float offset; // Scales the tap distance (1: Standard dual filter)
+layout(OUTPUT_FORMAT, binding = 0) writeonly uniform image2D outputImage;
+
+void main() {
+    ivec2 outputPos = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 outputSize = imageSize(outputImage);
+    if (any(greaterThanEqual(outputPos, outputSize))) {
+        return;
+    }
+
+    // Dual filter upsampling: Four bilinear taps at the edges (weight 1) and four on the diagonals (weight 2)
+    vec2 uv = (vec2(outputPos) + 0.5) / vec2(outputSize);
+    vec2 d = offset / vec2(outputSize);
+    vec3 sum = texture(inputTexture, uv + vec2(-2.0 * d.x, 0.0)).rgb;
+    sum += texture(inputTexture, uv + vec2(2.0 * d.x, 0.0)).rgb;
+    sum += texture(inputTexture, uv + vec2(0.0, -2.0 * d.y)).rgb;
+    sum += texture(inputTexture, uv + vec2(0.0, 2.0 * d.y)).rgb;
+    sum += texture(inputTexture, uv + vec2(-d.x, d.y)).rgb * 2.0;
+    sum += texture(inputTexture, uv + vec2(d.x, d.y)).rgb * 2.0;
+    sum += texture(inputTexture, uv + vec2(-d.x, -d.y)).rgb * 2.0;
+    sum += texture(inputTexture, uv + vec2(d.x, -d.y)).rgb * 2.0;
+    imageStore(outputImage, outputPos, vec4(sum / 12.0, 1.0));
+}
@@ -52,6 +52,14 @@ out vec4 fragColor;
 void main() {
     vec4 textureColorRgba = texture(inputTexture, st).rgba;
     vec3 textureColorRgb = textureColorRgba.rgb;
-    vec3 light = clamp(texture(lightTexture, st).rgb + ambientLight.rgb, 0.0, 1.0);
+    vec3 light = texture(lightTexture, st).rgb + ambientLight.rgb;
+#ifdef HDR_LIGHT
+    // Float light buffers aren't clamped. Compress the light above the knee smoothly towards 1 instead of clipping.
+    const float knee = 0.75;
+    vec3 excess = max(light - knee, 0.0);
+    light = min(light, knee) + (1.0 - knee) * (1.0 - exp(-excess / (1.0 - knee)));
+#else
+    light = clamp(light, 0.0, 1.0);
+#endif
     fragColor = vec4(textureColorRgb * light, textureColorRgba.a);
 }
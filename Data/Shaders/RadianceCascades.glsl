@@ -0,0 +1,159 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2017 - 2021, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+-- Vertex
+
+#version 430 core
+
+in vec2 vertexPosition;
+in vec2 vertexTexCoord;
+out vec2 st;
+
+void main() {
+    st = vertexTexCoord;
+    gl_Position = vec4(vertexPosition, 0., 1.);
+}
+
+
+-- Fragment.Cascade
+
+#version 430 core
+
+// Cascade i has probes every 2^(i+1) pixels with 4^(i+1) directions each. Every probe owns a block of
+// 2^(i+1) x 2^(i+1) texels, one per direction, so all cascades have the same number of texels.
+// The rays of cascade i cover the distances [l0 * (4^i - 1) / 3, l0 * (4^(i+1) - 1) / 3) from the probe.
+// rgb: Radiance, a: Transmittance (1 if the ray interval hit nothing)
+
+uniform sampler2D inputTexture; // Signed distance field of the emitters and occluders in world units
+uniform sampler2D emissionTexture;
+uniform sampler2D upperCascadeTexture;
+uniform int cascadeIndex;
+uniform bool hasUpperCascade;
+uniform vec2 renderSize;
+uniform float worldPerPixel;
+uniform float baseInterval; // l0 in pixels
+out vec4 fragColor;
+
+const float PI = 3.1415926535897;
+const int MAX_STEPS = 32;
+
+vec4 traceInterval(vec2 origin, vec2 direction, float startDist, float endDist) {
+    float t = startDist;
+    for (int i = 0; i < MAX_STEPS && t < endDist; i++) {
+        vec2 position = origin + t * direction;
+        if (any(lessThan(position, vec2(0.0))) || any(greaterThanEqual(position, renderSize))) {
+            // Nothing emits light outside of the screen
+            return vec4(0.0, 0.0, 0.0, 0.0);
+        }
+        float dist = texture(inputTexture, position / renderSize).r / worldPerPixel;
+        if (dist < 0.5) {
+            return vec4(texture(emissionTexture, position / renderSize).rgb, 0.0);
+        }
+        t += dist;
+    }
+    return vec4(0.0, 0.0, 0.0, 1.0);
+}
+
+vec4 fetchUpperProbe(ivec2 probe, int directionIdx, int upperBlockSize) {
+    // The four directions of the upper cascade subdividing the direction of this cascade
+    vec4 radiance = vec4(0.0);
+    for (int i = 0; i < 4; i++) {
+        int upperDirectionIdx = directionIdx * 4 + i;
+        ivec2 directionTexel = ivec2(upperDirectionIdx % upperBlockSize, upperDirectionIdx / upperBlockSize);
+        radiance += texelFetch(upperCascadeTexture, probe * upperBlockSize + directionTexel, 0);
+    }
+    return radiance * 0.25;
+}
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    int blockSize = 2 << cascadeIndex;
+    ivec2 probe = texel / blockSize;
+    ivec2 directionTexel = texel % blockSize;
+    int directionIdx = directionTexel.y * blockSize + directionTexel.x;
+    int numDirections = blockSize * blockSize;
+
+    vec2 probeCenter = (vec2(probe) + 0.5) * float(blockSize);
+    float angle = (float(directionIdx) + 0.5) / float(numDirections) * 2.0 * PI;
+    vec2 direction = vec2(cos(angle), sin(angle));
+    float scale = pow(4.0, float(cascadeIndex));
+    float startDist = baseInterval * (scale - 1.0) / 3.0;
+    float endDist = baseInterval * (4.0 * scale - 1.0) / 3.0;
+    vec4 radiance = traceInterval(probeCenter, direction, startDist, endDist);
+
+    // Merge with the bilinearly interpolated probes of the upper cascade if nothing was hit
+    if (hasUpperCascade && radiance.a > 0.0) {
+        int upperBlockSize = blockSize * 2;
+        ivec2 numUpperProbes = textureSize(upperCascadeTexture, 0) / upperBlockSize;
+        vec2 upperProbePosition = probeCenter / float(upperBlockSize) - 0.5;
+        ivec2 baseProbe = ivec2(floor(upperProbePosition));
+        vec2 weights = fract(upperProbePosition);
+        vec4 upperRadiance = vec4(0.0);
+        for (int y = 0; y < 2; y++) {
+            for (int x = 0; x < 2; x++) {
+                ivec2 upperProbe = clamp(baseProbe + ivec2(x, y), ivec2(0), numUpperProbes - 1);
+                float weight = (x == 0 ? 1.0 - weights.x : weights.x) * (y == 0 ? 1.0 - weights.y : weights.y);
+                upperRadiance += weight * fetchUpperProbe(upperProbe, directionIdx, upperBlockSize);
+            }
+        }
+        radiance.rgb += radiance.a * upperRadiance.rgb;
+        radiance.a *= upperRadiance.a;
+    }
+
+    fragColor = radiance;
+}
+
+
+-- Fragment.Fluence
+
+#version 430 core
+
+uniform sampler2D inputTexture; // Cascade 0
+uniform float intensity;
+out vec4 fragColor;
+
+void main() {
+    // Bilinear interpolation of the probes of cascade 0 (every 2 pixels, 4 directions)
+    ivec2 numProbes = textureSize(inputTexture, 0) / 2;
+    vec2 probePosition = gl_FragCoord.xy / 2.0 - 0.5;
+    ivec2 baseProbe = ivec2(floor(probePosition));
+    vec2 weights = fract(probePosition);
+    vec3 radiance = vec3(0.0);
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+            ivec2 probe = clamp(baseProbe + ivec2(x, y), ivec2(0), numProbes - 1);
+            float weight = (x == 0 ? 1.0 - weights.x : weights.x) * (y == 0 ? 1.0 - weights.y : weights.y);
+            vec3 probeRadiance = texelFetch(inputTexture, probe * 2, 0).rgb
+                    + texelFetch(inputTexture, probe * 2 + ivec2(1, 0), 0).rgb
+                    + texelFetch(inputTexture, probe * 2 + ivec2(0, 1), 0).rgb
+                    + texelFetch(inputTexture, probe * 2 + ivec2(1, 1), 0).rgb;
+            radiance += weight * 0.25 * probeRadiance;
+        }
+    }
+    fragColor = vec4(radiance * intensity, 1.0);
+}
@@ -44,7 +44,12 @@ void main() {
 #version 430 core
 
 uniform sampler2DMS inputTexture;
+#ifdef NUM_SAMPLES
+// Specialized variant, the sample loop has a constant trip count
+const int numSamples = NUM_SAMPLES;
+#else
 uniform int numSamples;
+#endif
 in vec2 fragTexCoord;
 out vec4 fragColor;
 
@@ -61,9 +66,14 @@ void main() {
     }
     color /= float(numSamples);
     //fragColor = vec4(color.rgb, color.a);
+#ifdef LINEAR_RESOLVE
+    // Light is additive, i.e., samples without alpha are unlit and not transparent
+    fragColor = totalSum / float(numSamples);
+#else
     if (color.a > 1.0 / 256.0) {
         fragColor = vec4(color.rgb / color.a, color.a);
     } else {
         fragColor = totalSum / float(numSamples);
     }
+#endif
 }
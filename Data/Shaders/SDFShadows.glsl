@@ -0,0 +1,123 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2017 - 2021, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+-- Vertex
+
+#version 430 core
+
+in vec2 vertexPosition;
+in vec2 vertexTexCoord;
+out vec2 st;
+
+void main() {
+    st = vertexTexCoord;
+    gl_Position = vec4(vertexPosition, 0., 1.);
+}
+
+
+-- Fragment.Lighting
+
+#version 430 core
+
+struct LightData {
+    vec2 position;
+    float radius;
+    float padding;
+    vec4 color;
+};
+
+layout(std430, binding = 2) readonly buffer LightBuffer {
+    LightData lights[];
+};
+
+uniform sampler2D inputTexture; // Signed distance field in world units
+uniform int numLights;
+uniform vec2 worldMin;
+uniform vec2 worldSize;
+uniform float worldPerPixel;
+uniform float softness; // Larger values give sharper penumbrae
+in vec2 st;
+out vec4 fragColor;
+
+const int MAX_STEPS = 64;
+
+float sceneDistance(vec2 position) {
+    return texture(inputTexture, (position - worldMin) / worldSize).r;
+}
+
+// Sphere tracing towards the light. The closest miss relative to the traveled distance approximates a cone test.
+float traceShadow(vec2 position, vec2 lightPosition) {
+    vec2 toLight = lightPosition - position;
+    float lightDist = length(toLight);
+    if (lightDist < worldPerPixel) {
+        return 1.0;
+    }
+    vec2 direction = toLight / lightDist;
+
+    // Leave the occluder the pixel lies in. Like in the other light managers, only the edges facing away from the
+    // light cast shadows, so occluders don't shadow themselves.
+    float t = 0.0;
+    for (int i = 0; i < MAX_STEPS; i++) {
+        float dist = sceneDistance(position + t * direction);
+        if (dist > 0.0) {
+            break;
+        }
+        t += max(-dist, worldPerPixel);
+    }
+    float startT = t;
+    // The distance right at the surface is below the hit threshold, which would darken a rim around every occluder
+    t += worldPerPixel;
+
+    float visibility = 1.0;
+    for (int i = 0; i < MAX_STEPS && t < lightDist; i++) {
+        float dist = sceneDistance(position + t * direction);
+        if (dist < 0.5 * worldPerPixel) {
+            return 0.0;
+        }
+        visibility = min(visibility, softness * dist / max(t - startT, worldPerPixel));
+        t += dist;
+    }
+    return clamp(visibility, 0.0, 1.0);
+}
+
+void main() {
+    vec2 position = worldMin + st * worldSize;
+    vec3 light = vec3(0.0);
+    for (int i = 0; i < numLights; i++) {
+#ifdef LIGHT_ATTENUATION
+        float falloff = max(1.0 - length(position - lights[i].position) / lights[i].radius, 0.0);
+        if (falloff <= 0.0) {
+            continue;
+        }
+        light += lights[i].color.rgb * (falloff * falloff) * traceShadow(position, lights[i].position);
+#else
+        light += lights[i].color.rgb * traceShadow(position, lights[i].position);
+#endif
+    }
+    fragColor = vec4(light, 1.0);
+}
@@ -43,10 +43,15 @@ void main() {
 
 #version 430 core
 
-uniform sampler2DArray depthMap;
+uniform sampler2DArray depthMap; // Shadow atlas
+uniform vec2 atlasSize;
+uniform vec3 atlasRegion; // x offset, width and row of the region of the light (in texels)
 uniform vec2 lightpos;
 uniform vec4 lightColor;
 uniform float farPlaneDist;
+#ifdef LIGHT_ATTENUATION
+uniform float lightRadius;
+#endif
 in vec2 fragPosWorld;
 out vec4 fragColor;
 
@@ -72,17 +77,27 @@ float getFragmentDepth(vec2 fragPosLight) {
     float angle = atan(fragPosLight.y, fragPosLight.x);
     int index = int(mod(floor((angle + 11.0/6.0*PI)/(2.0/3.0*PI)), 3.0));
     float xCoord = getShadowMapCoordinate(index, fragPosLight);
-    float depth = texture(depthMap, vec3(xCoord, 0.0, float(index))).r * farPlaneDist;
+    // Don't filter across the border to the neighboring region
+    float xTexel = atlasRegion.x + clamp(xCoord * atlasRegion.y, 0.5, atlasRegion.y - 0.5);
+    vec2 atlasCoord = vec2(xTexel, atlasRegion.z + 0.5) / atlasSize;
+    float depth = texture(depthMap, vec3(atlasCoord, float(index))).r * farPlaneDist;
     return depth;
 }
 
-const float BIAS = 0.002;
+// Specialized by the application depending on the precision of the depth format
+#ifndef SHADOW_BIAS
+#define SHADOW_BIAS 0.002
+#endif
 
 void main() {
     float fragDist = length(fragPosWorld - lightpos);
     float occlusionDepth = getFragmentDepth(fragPosWorld - lightpos);
     vec4 color = lightColor;
-    if (fragDist > occlusionDepth - BIAS) {
+#ifdef LIGHT_ATTENUATION
+    float falloff = max(1.0 - fragDist / lightRadius, 0.0);
+    color.rgb *= falloff * falloff;
+#endif
+    if (fragDist > occlusionDepth - SHADOW_BIAS) {
         color = vec4(0.0, 0.0, 0.0, 1.0);
     }
     fragColor = color;
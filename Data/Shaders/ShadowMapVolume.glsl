@@ -41,16 +41,28 @@ void main() {
 
 #version 430 core
 
-layout(lines) in;
+// One invocation per light of the batch, each light renders to its own viewport in the shadow atlas
+#ifndef MAX_LIGHTS_PER_PASS
+#define MAX_LIGHTS_PER_PASS 16
+#endif
+layout(lines, invocations = MAX_LIGHTS_PER_PASS) in;
 // vertices: 4 * 3 = quad * cameras
 layout(triangle_strip, max_vertices = 12) out;
 
-uniform vec2 lightpos;
-uniform mat4 camViewProjMatrices[3]; 
+uniform int numLights;
+uniform vec2 lightPositions[MAX_LIGHTS_PER_PASS];
+uniform mat4 camViewProjMatrices[3]; // Light at the origin
 
 out vec2 fragPos;
+flat out vec2 fragLightPos;
 
 void main() {
+    if (gl_InvocationID >= numLights) {
+        return;
+    }
+    vec2 lightpos = lightPositions[gl_InvocationID];
+    vec4 lightOffset = vec4(lightpos, 0.0, 0.0);
+
     vec2 pt0 = gl_in[0].gl_Position.xy;
     vec2 pt1 = gl_in[1].gl_Position.xy;
     vec2 offsetvec = pt1 - pt0;
@@ -62,6 +74,7 @@ void main() {
         // Iterate over all three triangle camera views
         for(int face = 0; face < 3; ++face) {
             gl_Layer = face;
+            gl_ViewportIndex = gl_InvocationID;
             mat4 vpMatrix = camViewProjMatrices[face];
             
             vec4 dirUp = vec4(0.0, 0.0, 1.0, 0.0);
@@ -96,16 +109,20 @@ void main() {
 
             // Works on NVIDIA & Intel GPUs
             fragPos = gl_in[0].gl_Position.xy;
-            gl_Position = vpMatrix * (gl_in[0].gl_Position + dirUp);
+            fragLightPos = lightpos;
+            gl_Position = vpMatrix * (gl_in[0].gl_Position + dirUp - lightOffset);
             EmitVertex();
             fragPos = gl_in[1].gl_Position.xy;
-            gl_Position = vpMatrix * (gl_in[1].gl_Position + dirUp);
+            fragLightPos = lightpos;
+            gl_Position = vpMatrix * (gl_in[1].gl_Position + dirUp - lightOffset);
             EmitVertex();
             fragPos = gl_in[0].gl_Position.xy;
-            gl_Position = vpMatrix * (gl_in[0].gl_Position + dirDown);
+            fragLightPos = lightpos;
+            gl_Position = vpMatrix * (gl_in[0].gl_Position + dirDown - lightOffset);
             EmitVertex();
             fragPos = gl_in[1].gl_Position.xy;
-            gl_Position = vpMatrix * (gl_in[1].gl_Position + dirDown);
+            fragLightPos = lightpos;
+            gl_Position = vpMatrix * (gl_in[1].gl_Position + dirDown - lightOffset);
             EmitVertex();
             EndPrimitive();
         }
@@ -118,15 +135,12 @@ void main() {
 #version 430 core
 
 in vec2 fragPos;
-in float currLayer;
+flat in vec2 fragLightPos;
 
-uniform vec2 lightpos;
 uniform float farPlaneDist;
-uniform int lightnum;
-uniform vec3 texsize; // in pixels
 
 void main() {
-    float lightDistance = length(fragPos - lightpos);
+    float lightDistance = length(fragPos - fragLightPos);
     lightDistance = clamp(lightDistance / farPlaneDist, 0.0, 1.0); // Map to [0;1]
     gl_FragDepth = lightDistance;
 }
@@ -0,0 +1,86 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2020 - 2021, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+-- Vertex
+
+#version 430 core
+
+// Corner of the screen in normalized device coordinates
+in vec2 vertexPosition;
+uniform mat4 viewProjMatrix; // Current frame, without the jitter
+uniform mat4 invViewProjMatrix;
+uniform mat4 prevViewProjMatrix;
+out vec4 prevClipPos;
+
+void main() {
+    // The scene lies in the plane z = 0, so the view ray through the corner is intersected with it
+    vec4 nearPoint = invViewProjMatrix * vec4(vertexPosition, -1.0, 1.0);
+    vec4 farPoint = invViewProjMatrix * vec4(vertexPosition, 1.0, 1.0);
+    nearPoint /= nearPoint.w;
+    farPoint /= farPoint.w;
+    vec3 worldPos = mix(nearPoint.xyz, farPoint.xyz, nearPoint.z / (nearPoint.z - farPoint.z));
+    // Interpolated perspective-correctly, as gl_Position has the same w
+    prevClipPos = prevViewProjMatrix * vec4(worldPos, 1.0);
+    gl_Position = viewProjMatrix * vec4(worldPos, 1.0);
+}
+
+-- Fragment
+
+#version 430 core
+
+uniform sampler2D currentTexture; // Light of the current (jittered) frame
+uniform sampler2D historyTexture;
+uniform float blendFactor; // Weight of the current frame
+uniform bool historyValid;
+in vec4 prevClipPos;
+out vec4 fragColor;
+
+void main() {
+    ivec2 size = textureSize(currentTexture, 0);
+    ivec2 iCoords = ivec2(gl_FragCoord.xy);
+    vec4 current = texelFetch(currentTexture, iCoords, 0);
+
+    // The history is clamped to the range of the 3x3 neighborhood, so lights and shadows that moved don't ghost
+    vec4 neighborhoodMin = current;
+    vec4 neighborhoodMax = current;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            vec4 neighbor = texelFetch(currentTexture, clamp(iCoords + ivec2(x, y), ivec2(0), size - 1), 0);
+            neighborhoodMin = min(neighborhoodMin, neighbor);
+            neighborhoodMax = max(neighborhoodMax, neighbor);
+        }
+    }
+
+    vec2 prevTexCoord = prevClipPos.xy / prevClipPos.w * 0.5 + 0.5;
+    if (!historyValid || any(lessThan(prevTexCoord, vec2(0.0))) || any(greaterThan(prevTexCoord, vec2(1.0)))) {
+        fragColor = current;
+        return;
+    }
+    vec4 history = clamp(texture(historyTexture, prevTexCoord), neighborhoodMin, neighborhoodMax);
+    fragColor = mix(history, current, blendFactor);
+}
@@ -86,5 +86,5 @@ void main() {
 out vec4 fragColor;
 
 void main() {
-    fragColor = vec4(1.0, 1.0, 1.0, 1.0);
+    fragColor = vec4(0.0, 0.0, 0.0, 0.0);
 }
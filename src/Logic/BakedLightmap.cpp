@@ -0,0 +1,195 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstring>
+#include <cmath>
+#include <fstream>
+#include <GL/glew.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <Graphics/Renderer.hpp>
+#include <Graphics/OpenGL/Texture.hpp>
+#include <Math/Geometry/MatrixUtil.hpp>
+#include <Utils/File/Logfile.hpp>
+
+#include "LightManagerInterface.hpp"
+#include "BakedLightmap.hpp"
+
+static const char BAKED_LIGHTMAP_MAGIC[4] = { 'L', 'M', 'A', 'P' };
+static const uint32_t BAKED_LIGHTMAP_VERSION = 1;
+
+static void lightToBakedLight(VolumeLightPtr &light, BakedLightmapLight &bakedLight) {
+    sgl::Color color = light->getColor();
+    bakedLight.position[0] = light->getPosition().x;
+    bakedLight.position[1] = light->getPosition().y;
+    bakedLight.radius = light->getRadius();
+    bakedLight.color[0] = color.getR();
+    bakedLight.color[1] = color.getG();
+    bakedLight.color[2] = color.getB();
+    bakedLight.color[3] = color.getA();
+}
+
+bool BakedLightmap::bake(
+        const std::string &filename, LightManagerInterface *lightManager, std::function<void()> renderfun,
+        sgl::CameraPtr camera, float texelsPerUnit) {
+    // Keep the aspect ratio of the camera so that its projection can be reused for the baked area
+    sgl::AABB2 camRect = camera->getAABB2(0.0f);
+    int width = std::max(int(std::ceil(camRect.getWidth() * texelsPerUnit)), 1);
+    int height = std::max(int(std::ceil(camRect.getHeight() * texelsPerUnit)), 1);
+
+    lightManager->setRenderResolution(width, height);
+    glViewport(0, 0, width, height);
+    lightManager->beginRenderLightmap();
+    lightManager->renderLightmap(renderfun);
+    lightManager->endRenderLightmap();
+
+    BakedLightmapHeader header;
+    memcpy(header.magic, BAKED_LIGHTMAP_MAGIC, sizeof(header.magic));
+    header.version = BAKED_LIGHTMAP_VERSION;
+    header.width = width;
+    header.height = height;
+    header.worldRectMin[0] = camRect.min.x;
+    header.worldRectMin[1] = camRect.min.y;
+    header.worldRectMax[0] = camRect.max.x;
+    header.worldRectMax[1] = camRect.max.y;
+
+    std::vector<BakedLightmapLight> bakedLights;
+    for (VolumeLightPtr &light : lightManager->getLights()) {
+        BakedLightmapLight bakedLight;
+        lightToBakedLight(light, bakedLight);
+        bakedLights.push_back(bakedLight);
+    }
+    header.numLights = bakedLights.size();
+
+    std::vector<uint8_t> texels(width * height * 4);
+    sgl::TextureGL *lightTexture = static_cast<sgl::TextureGL*>(lightManager->getLightTexture().get());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, lightTexture->getTexture());
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, &texels.front());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    lightManager->setRenderResolution(0, 0);
+
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in BakedLightmap::bake: Couldn't open file \""
+                + filename + "\" for writing.");
+        return false;
+    }
+    file.write((const char*)&header, sizeof(header));
+    if (!bakedLights.empty()) {
+        file.write((const char*)&bakedLights.front(), sizeof(BakedLightmapLight) * bakedLights.size());
+    }
+    file.write((const char*)&texels.front(), texels.size());
+    file.close();
+    return true;
+}
+
+BakedLightmapPtr BakedLightmap::load(const std::string &filename) {
+    BakedLightmapPtr lightmap;
+    try {
+        boost::interprocess::file_mapping mapping(filename.c_str(), boost::interprocess::read_only);
+        boost::interprocess::mapped_region region(mapping, boost::interprocess::read_only);
+        const uint8_t *data = static_cast<const uint8_t*>(region.get_address());
+        size_t dataSize = region.get_size();
+
+        if (dataSize < sizeof(BakedLightmapHeader)) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in BakedLightmap::load: Invalid file \""
+                    + filename + "\".");
+            return lightmap;
+        }
+        BakedLightmapHeader header;
+        memcpy(&header, data, sizeof(BakedLightmapHeader));
+        size_t lightsSize = sizeof(BakedLightmapLight) * header.numLights;
+        size_t texelsSize = size_t(header.width) * size_t(header.height) * 4;
+        if (memcmp(header.magic, BAKED_LIGHTMAP_MAGIC, sizeof(header.magic)) != 0
+                || header.version != BAKED_LIGHTMAP_VERSION
+                || dataSize < sizeof(BakedLightmapHeader) + lightsSize + texelsSize) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in BakedLightmap::load: Invalid file \""
+                    + filename + "\".");
+            return lightmap;
+        }
+
+        lightmap = BakedLightmapPtr(new BakedLightmap);
+        lightmap->worldRect = sgl::AABB2(
+                glm::vec2(header.worldRectMin[0], header.worldRectMin[1]),
+                glm::vec2(header.worldRectMax[0], header.worldRectMax[1]));
+        lightmap->bakedLights.resize(header.numLights);
+        if (header.numLights > 0) {
+            memcpy(&lightmap->bakedLights.front(), data + sizeof(BakedLightmapHeader), lightsSize);
+        }
+
+        // Upload directly from the mapped memory
+        lightmap->texture = sgl::TextureManager->createEmptyTexture(header.width, header.height);
+        sgl::TextureGL *textureGL = static_cast<sgl::TextureGL*>(lightmap->texture.get());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D, textureGL->getTexture());
+        glTexSubImage2D(
+                GL_TEXTURE_2D, 0, 0, 0, header.width, header.height, GL_RGBA, GL_UNSIGNED_BYTE,
+                data + sizeof(BakedLightmapHeader) + lightsSize);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    } catch (boost::interprocess::interprocess_exception &e) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in BakedLightmap::load: Couldn't map file \""
+                + filename + "\": " + e.what());
+        return BakedLightmapPtr();
+    }
+    return lightmap;
+}
+
+bool BakedLightmap::matchesLights(std::vector<VolumeLightPtr> &lights) {
+    size_t bakedLightIdx = 0;
+    for (VolumeLightPtr &light : lights) {
+        if (!light->isStatic()) {
+            continue;
+        }
+        if (bakedLightIdx >= bakedLights.size()) {
+            return false;
+        }
+        BakedLightmapLight currentLight;
+        lightToBakedLight(light, currentLight);
+        if (memcmp(&currentLight, &bakedLights.at(bakedLightIdx), sizeof(BakedLightmapLight)) != 0) {
+            return false;
+        }
+        bakedLightIdx++;
+    }
+    return bakedLightIdx == bakedLights.size();
+}
+
+void BakedLightmap::render(sgl::CameraPtr camera) {
+    sgl::Renderer->setBlendMode(sgl::BLEND_OVERWRITE);
+    sgl::Renderer->setProjectionMatrix(camera->getProjectionMatrix());
+    sgl::Renderer->setViewMatrix(camera->getViewMatrix());
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+    sgl::Renderer->blitTexture(texture, worldRect);
+}
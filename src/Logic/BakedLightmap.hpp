@@ -0,0 +1,99 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOGIC_BAKEDLIGHTMAP_HPP_
+#define LOGIC_BAKEDLIGHTMAP_HPP_
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <boost/shared_ptr.hpp>
+#include <glm/glm.hpp>
+#include <Math/Geometry/AABB2.hpp>
+#include <Graphics/Texture/TextureManager.hpp>
+#include <Graphics/Scene/Camera.hpp>
+#include "VolumeLight.hpp"
+
+class LightManagerInterface;
+class BakedLightmap;
+typedef boost::shared_ptr<BakedLightmap> BakedLightmapPtr;
+
+/**
+ * File layout: BakedLightmapHeader, header.numLights * BakedLightmapLight, width * height RGBA8 texels.
+ * The texels cover the world space rectangle stored in the header (first row at worldRectMin.y).
+ */
+struct BakedLightmapHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width, height;
+    float worldRectMin[2], worldRectMax[2];
+    uint32_t numLights;
+};
+
+struct BakedLightmapLight {
+    float position[2];
+    float radius;
+    uint8_t color[4];
+};
+
+/**
+ * Precomputed lighting of the static lights of a scene.
+ */
+class BakedLightmap {
+public:
+    /**
+     * Renders the static lights with the passed light manager (which must not contain any other lights) and writes
+     * the result to the specified file. The baked area is the area visible by the camera.
+     */
+    static bool bake(
+            const std::string &filename, LightManagerInterface *lightManager, std::function<void()> renderfun,
+            sgl::CameraPtr camera, float texelsPerUnit);
+    // Memory-maps the file and uploads the texels to a texture. Returns an empty pointer on failure.
+    static BakedLightmapPtr load(const std::string &filename);
+
+    // The baked lighting can only be used as long as the static lights still match the baked ones
+    bool matchesLights(std::vector<VolumeLightPtr> &lights);
+    // Renders the baked lighting to the currently bound render target
+    void render(sgl::CameraPtr camera);
+
+    inline sgl::TexturePtr getTexture() { return texture; }
+    inline const sgl::AABB2 &getWorldRect() { return worldRect; }
+    inline size_t getNumBakedLights() { return bakedLights.size(); }
+
+private:
+    sgl::TexturePtr texture;
+    sgl::AABB2 worldRect;
+    std::vector<BakedLightmapLight> bakedLights;
+};
+
+#endif /* LOGIC_BAKEDLIGHTMAP_HPP_ */
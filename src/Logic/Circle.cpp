@@ -46,7 +46,6 @@ CirclePrimitive::CirclePrimitive(
     vertices = edges;
 
     plainShader = _plainShader;
-    edgeShader = _edgeShader;
 
     circleData = sgl::ShaderManager->createShaderAttributes(plainShader);
     sgl::GeometryBufferPtr geometryBuffer = sgl::Renderer->createGeometryBuffer(
@@ -54,23 +53,11 @@ CirclePrimitive::CirclePrimitive(
     circleData->addGeometryBuffer(geometryBuffer, "vertexPosition", sgl::ATTRIB_FLOAT, 2);
     circleData->setVertexMode(sgl::VERTEX_MODE_TRIANGLE_FAN);
 
-    edgeData = sgl::ShaderManager->createShaderAttributes(edgeShader);
-    geometryBuffer = sgl::Renderer->createGeometryBuffer(sizeof(glm::vec2)*edges.size(), &edges.front());
-    edgeData->addGeometryBuffer(geometryBuffer, "vertexPosition", sgl::ATTRIB_FLOAT, 2);
-    edgeData->setVertexMode(sgl::VERTEX_MODE_LINE_LOOP);
+    createEdgeLods(_edgeShader);
 }
 
-void CirclePrimitive::setEdgeShader(sgl::ShaderProgramPtr _edgeShader) {
-    edgeData = edgeData->copy(_edgeShader);
-}
-
-void CirclePrimitive::render() {
-    sgl::Renderer->setModelMatrix(sgl::matrixTranslation(position)*specialTransform);
-    plainShader->setUniform("color", sgl::Color(60, 60, 60));
+void CirclePrimitive::renderFilled(const sgl::Color &fillColor) {
+    sgl::Renderer->setModelMatrix(getTransform());
+    plainShader->setUniform("color", fillColor);
     sgl::Renderer->render(circleData);
 }
-
-void CirclePrimitive::renderEdges() {
-    sgl::Renderer->setModelMatrix(sgl::matrixTranslation(position)*specialTransform);
-    sgl::Renderer->render(edgeData);
-}
@@ -39,7 +39,6 @@ Cube::Cube(
         const glm::mat4 &_specialTransform) {
     specialTransform = _specialTransform;
     plainShader = _plainShader;
-    edgeShader = _edgeShader;
     edges = {
             glm::vec2(-extent.x, -extent.y),
             glm::vec2(extent.x, -extent.y),
@@ -59,23 +58,11 @@ Cube::Cube(
     cubeData->addGeometryBuffer(geometryBuffer, "vertexPosition", sgl::ATTRIB_FLOAT, 2);
     cubeData->setVertexMode(sgl::VERTEX_MODE_TRIANGLE_STRIP);
 
-    edgeData = sgl::ShaderManager->createShaderAttributes(edgeShader);
-    geometryBuffer = sgl::Renderer->createGeometryBuffer(sizeof(glm::vec2)*edges.size(), &edges.front());
-    edgeData->addGeometryBuffer(geometryBuffer, "vertexPosition", sgl::ATTRIB_FLOAT, 2);
-    edgeData->setVertexMode(sgl::VERTEX_MODE_LINE_LOOP);
+    createEdgeLods(_edgeShader);
 }
 
-void Cube::setEdgeShader(sgl::ShaderProgramPtr _edgeShader) {
-    edgeData = edgeData->copy(_edgeShader);
-}
-
-void Cube::render() {
-    sgl::Renderer->setModelMatrix(sgl::matrixTranslation(position)*specialTransform);
-    plainShader->setUniform("color", sgl::Color(60, 60, 60));
+void Cube::renderFilled(const sgl::Color &fillColor) {
+    sgl::Renderer->setModelMatrix(getTransform());
+    plainShader->setUniform("color", fillColor);
     sgl::Renderer->render(cubeData);
 }
-
-void Cube::renderEdges() {
-    sgl::Renderer->setModelMatrix(sgl::matrixTranslation(position)*specialTransform);
-    sgl::Renderer->render(edgeData);
-}
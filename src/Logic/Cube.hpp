@@ -45,20 +45,12 @@ public:
     Cube(
             sgl::ShaderProgramPtr _plainShader, sgl::ShaderProgramPtr _edgeShader,
             const glm::vec2 &extent, const glm::mat4 &_specialTransform = sgl::matrixIdentity());
-    inline void setPosition(const glm::vec2 &pos) { position = pos; }
-    void render();
-    void renderEdges();
-    void setEdgeShader(sgl::ShaderProgramPtr _edgeShader);
+    void renderFilled(const sgl::Color &fillColor);
 
 private:
     sgl::ShaderProgramPtr plainShader;
-    sgl::ShaderProgramPtr edgeShader;
     sgl::ShaderAttributesPtr cubeData;
-    sgl::ShaderAttributesPtr edgeData;
     std::vector<glm::vec2> vertices;
-    std::vector<glm::vec2> edges;
-    glm::vec2 position;
-    glm::mat4 specialTransform;
 };
 
 
@@ -0,0 +1,108 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <GL/glew.h>
+
+#include <Graphics/Renderer.hpp>
+#include <Graphics/Texture/TextureManager.hpp>
+#include <Math/Geometry/MatrixUtil.hpp>
+
+#include "Utils/Profiler.hpp"
+#include "Utils/ShaderCache.hpp"
+#include "DistanceField.hpp"
+
+DistanceField::DistanceField() {
+    seedShader = ShaderCache::get()->getShaderProgram({"DistanceField.Vertex", "DistanceField.Fragment.Seed"});
+    jumpFloodShader = ShaderCache::get()->getShaderProgram(
+            {"DistanceField.Vertex", "DistanceField.Fragment.JumpFlood"});
+    distanceShader = ShaderCache::get()->getShaderProgram(
+            {"DistanceField.Vertex", "DistanceField.Fragment.Distance"});
+}
+
+void DistanceField::onResolutionChanged(int width, int height) {
+    this->width = width;
+    this->height = height;
+
+    // Pixel coordinates of the nearest seeds need full float precision
+    sgl::TextureSettings seedSettings(
+            sgl::TEXTURE_2D, GL_NEAREST, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+    seedSettings.internalFormat = GL_RGBA32F;
+    seedSettings.pixelFormat = GL_RGBA;
+    seedSettings.pixelType = GL_FLOAT;
+    for (int i = 0; i < 2; i++) {
+        jumpFloodFBOs[i] = sgl::Renderer->createFBO();
+        jumpFloodTextures[i] = sgl::TextureManager->createEmptyTexture(width, height, seedSettings);
+        jumpFloodFBOs[i]->bindTexture(jumpFloodTextures[i]);
+    }
+
+    sgl::TextureSettings distanceSettings(
+            sgl::TEXTURE_2D, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+    distanceSettings.internalFormat = GL_R32F;
+    distanceSettings.pixelFormat = GL_RED;
+    distanceSettings.pixelType = GL_FLOAT;
+    distanceFBO = sgl::Renderer->createFBO();
+    distanceTex = sgl::TextureManager->createEmptyTexture(width, height, distanceSettings);
+    distanceFBO->bindTexture(distanceTex);
+}
+
+void DistanceField::build(sgl::TexturePtr maskTexture, float worldPerPixel) {
+    PROFILE_SCOPE("DistanceField::build");
+    sgl::Renderer->setBlendMode(sgl::BLEND_OVERWRITE);
+    sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+    sgl::AABB2 fullscreenRect(glm::vec2(-1, -1), glm::vec2(1, 1));
+    sgl::Renderer->bindFBO(jumpFloodFBOs[0]);
+    glViewport(0, 0, width, height);
+    sgl::Renderer->blitTexture(maskTexture, fullscreenRect, seedShader);
+
+    // Jump flooding with halving step sizes
+    int stepSize = 1;
+    while (stepSize * 2 < std::max(width, height)) {
+        stepSize *= 2;
+    }
+    int currentIdx = 0;
+    for (; stepSize >= 1; stepSize /= 2) {
+        sgl::Renderer->bindFBO(jumpFloodFBOs[1 - currentIdx]);
+        jumpFloodShader->setUniform("stepSize", stepSize);
+        sgl::Renderer->blitTexture(jumpFloodTextures[currentIdx], fullscreenRect, jumpFloodShader);
+        currentIdx = 1 - currentIdx;
+    }
+
+    sgl::Renderer->bindFBO(distanceFBO);
+    distanceShader->setUniform("worldPerPixel", worldPerPixel);
+    sgl::Renderer->blitTexture(jumpFloodTextures[currentIdx], fullscreenRect, distanceShader);
+
+    sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
+    sgl::Renderer->unbindFBO();
+}
@@ -0,0 +1,65 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOGIC_DISTANCEFIELD_HPP_
+#define LOGIC_DISTANCEFIELD_HPP_
+
+#include <Graphics/Shader/ShaderManager.hpp>
+#include <Graphics/Buffers/FBO.hpp>
+#include <Graphics/Texture/TextureManager.hpp>
+
+/**
+ * Screen-sized signed distance field of a mask, built with jump flooding on the GPU.
+ * Outside pixels search the nearest mask pixel and inside pixels the nearest free pixel in the same passes.
+ */
+class DistanceField {
+public:
+    DistanceField();
+    void onResolutionChanged(int width, int height);
+
+    // Builds the signed distance (in world units, negative inside) to the texels with alpha > 0.5 in the mask
+    void build(sgl::TexturePtr maskTexture, float worldPerPixel);
+    inline sgl::TexturePtr getTexture() { return distanceTex; }
+
+private:
+    sgl::ShaderProgramPtr seedShader;
+    sgl::ShaderProgramPtr jumpFloodShader;
+    sgl::ShaderProgramPtr distanceShader;
+
+    sgl::FramebufferObjectPtr jumpFloodFBOs[2];
+    sgl::TexturePtr jumpFloodTextures[2];
+    sgl::FramebufferObjectPtr distanceFBO;
+    sgl::TexturePtr distanceTex;
+    int width = 0, height = 0;
+};
+
+#endif /* LOGIC_DISTANCEFIELD_HPP_ */
@@ -0,0 +1,186 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <Graphics/Renderer.hpp>
+#include <Graphics/OpenGL/Texture.hpp>
+#include <Math/Geometry/MatrixUtil.hpp>
+
+#include "Utils/Profiler.hpp"
+#include "Utils/ShaderCache.hpp"
+#include "LightBlur.hpp"
+
+// Variance (in texels^2) added by one horizontal and one vertical pass of GaussianBlur.glsl
+const float GAUSSIAN_PASS_VARIANCE = 2.85f;
+const int BLUR_TILE_SIZE = 16;
+
+LightBlur::LightBlur() {
+    downsampleShader = ShaderCache::get()->getShaderProgram({"DualKawaseBlur.Compute.Downsample"});
+    upsampleShader = ShaderCache::get()->getShaderProgram({"DualKawaseBlur.Compute.Upsample"});
+    gaussianShader = ShaderCache::get()->getShaderProgram({"GaussianBlur.Vertex", "GaussianBlur.Fragment"});
+    glGenQueries(2, timestampQueries);
+}
+
+LightBlur::~LightBlur() {
+    glDeleteQueries(2, timestampQueries);
+}
+
+void LightBlur::onResolutionChanged(int width, int height, LightFormat lightFormat) {
+    this->width = width;
+    this->height = height;
+    // The output has the format of the light buffer. RGB9E5 can't be written by image stores.
+    ShaderDefines outputDefines;
+    if (lightFormat == LIGHT_FORMAT_R11G11B10F) {
+        outputFormat = GL_R11F_G11F_B10F;
+        outputDefines["OUTPUT_FORMAT"] = "r11f_g11f_b10f";
+    } else if (lightFormat == LIGHT_FORMAT_RGBA8) {
+        outputFormat = GL_RGBA8;
+        outputDefines["OUTPUT_FORMAT"] = "rgba8";
+    } else {
+        outputFormat = GL_RGBA16F;
+    }
+    upsampleOutputShader = ShaderCache::get()->getShaderProgram({"DualKawaseBlur.Compute.Upsample"}, outputDefines);
+
+    sgl::TextureSettings settings;
+    levelTextures.clear();
+    levelSizes.clear();
+    for (int level = 0; level <= MAX_BLUR_LEVELS; level++) {
+        glm::ivec2 size(std::max(width >> level, 1), std::max(height >> level, 1));
+        // The intermediate levels use half floats, otherwise dim lights would band after a few passes
+        settings.internalFormat = level == 0 ? outputFormat : GL_RGBA16F;
+        settings.pixelType = settings.internalFormat == GL_RGBA8 ? GL_UNSIGNED_BYTE : GL_FLOAT;
+        levelTextures.push_back(sgl::TextureManager->createEmptyTexture(size.x, size.y, settings));
+        levelSizes.push_back(size);
+    }
+    outputFBO = sgl::Renderer->createFBO();
+    outputFBO->bindTexture(levelTextures.front());
+
+    gaussianTempFBO = sgl::Renderer->createFBO();
+    settings.internalFormat = outputFormat;
+    settings.pixelType = outputFormat == GL_RGBA8 ? GL_UNSIGNED_BYTE : GL_FLOAT;
+    gaussianTempTex = sgl::TextureManager->createEmptyTexture(width, height, settings);
+    gaussianTempFBO->bindTexture(gaussianTempTex);
+}
+
+FrameGraphTextureDesc LightBlur::getLevelDesc(int level) {
+    glm::ivec2 size = levelSizes.at(level);
+    return FrameGraphTextureDesc(size.x, size.y, level == 0 ? outputFormat : GL_RGBA16F);
+}
+
+sgl::TexturePtr LightBlur::blur(sgl::TexturePtr inputTexture, LightBlurMode mode, float radius) {
+    PROFILE_SCOPE("LightBlur::blur");
+    if (mode == LIGHT_BLUR_OFF) {
+        return inputTexture;
+    }
+
+    if (queryPending) {
+        GLint available = 0;
+        glGetQueryObjectiv(timestampQueries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 startTime = 0, endTime = 0;
+            glGetQueryObjectui64v(timestampQueries[0], GL_QUERY_RESULT, &startTime);
+            glGetQueryObjectui64v(timestampQueries[1], GL_QUERY_RESULT, &endTime);
+            blurTimeMs = float(double(endTime - startTime) * 1e-6);
+            queryPending = false;
+        }
+    }
+    // Timestamps instead of GL_TIME_ELAPSED, as the headless mode already measures the whole frame with the latter
+    bool measure = !queryPending;
+    if (measure) {
+        glQueryCounter(timestampQueries[0], GL_TIMESTAMP);
+    }
+
+    if (mode == LIGHT_BLUR_DUAL_KAWASE) {
+        blurDualKawase(inputTexture, radius);
+    } else {
+        blurGaussian(inputTexture, radius);
+    }
+
+    if (measure) {
+        glQueryCounter(timestampQueries[1], GL_TIMESTAMP);
+        queryPending = true;
+    }
+    return levelTextures.front();
+}
+
+void LightBlur::blurDualKawase(sgl::TexturePtr &inputTexture, float radius) {
+    // Every level doubles the radius, the remaining factor scales the distance of the upsampling taps
+    int numLevels = int(std::ceil(std::log2(std::max(radius, 2.0f) * 0.5f)));
+    numLevels = glm::clamp(numLevels, 1, MAX_BLUR_LEVELS);
+    float offset = glm::clamp(radius / float(1 << (numLevels + 1)), 0.5f, 2.0f);
+
+    dispatch(downsampleShader, inputTexture, 1);
+    for (int level = 2; level <= numLevels; level++) {
+        dispatch(downsampleShader, levelTextures.at(level - 1), level);
+    }
+    upsampleShader->setUniform("offset", offset);
+    for (int level = numLevels - 1; level >= 1; level--) {
+        dispatch(upsampleShader, levelTextures.at(level + 1), level);
+    }
+    upsampleOutputShader->setUniform("offset", offset);
+    dispatch(upsampleOutputShader, levelTextures.at(1), 0);
+}
+
+void LightBlur::dispatch(sgl::ShaderProgramPtr &shader, sgl::TexturePtr &input, int outputLevel) {
+    sgl::TextureGL *outputTexture = static_cast<sgl::TextureGL*>(levelTextures.at(outputLevel).get());
+    glm::ivec2 outputSize = levelSizes.at(outputLevel);
+    shader->setUniform("inputTexture", input, 0);
+    glBindImageTexture(0, outputTexture->getTexture(), 0, GL_FALSE, 0, GL_WRITE_ONLY,
+            outputLevel == 0 ? outputFormat : GL_RGBA16F);
+    shader->dispatchCompute(
+            (outputSize.x + BLUR_TILE_SIZE - 1) / BLUR_TILE_SIZE, (outputSize.y + BLUR_TILE_SIZE - 1) / BLUR_TILE_SIZE);
+    // The next pass samples the output (the last one is blitted or read back)
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+}
+
+void LightBlur::blurGaussian(sgl::TexturePtr &inputTexture, float radius) {
+    // The radius corresponds to about two standard deviations of the dual filter chain
+    float sigma = radius * 0.5f;
+    int numIterations = std::max(int(std::ceil(sigma * sigma / GAUSSIAN_PASS_VARIANCE)), 1);
+
+    sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+    gaussianShader->setUniform("texSize", glm::vec2(width, height));
+    sgl::TexturePtr source = inputTexture;
+    for (int i = 0; i < numIterations; i++) {
+        sgl::Renderer->bindFBO(gaussianTempFBO);
+        gaussianShader->setUniform("horzBlur", true);
+        sgl::Renderer->blitTexture(source, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)), gaussianShader);
+        sgl::Renderer->bindFBO(outputFBO);
+        gaussianShader->setUniform("horzBlur", false);
+        sgl::Renderer->blitTexture(gaussianTempTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)), gaussianShader);
+        source = levelTextures.front();
+    }
+    sgl::Renderer->unbindFBO();
+}
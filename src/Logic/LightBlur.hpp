@@ -0,0 +1,96 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOGIC_LIGHTBLUR_HPP_
+#define LOGIC_LIGHTBLUR_HPP_
+
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <Graphics/Shader/ShaderManager.hpp>
+#include <Graphics/Texture/TextureManager.hpp>
+#include "Utils/FrameGraph.hpp"
+#include "LightFormat.hpp"
+
+enum LightBlurMode {
+    LIGHT_BLUR_OFF, LIGHT_BLUR_DUAL_KAWASE, LIGHT_BLUR_GAUSSIAN
+};
+
+// Maximum number of downsampled levels, i.e., blur radii up to about 2^(MAX_BLUR_LEVELS+1) pixels
+const int MAX_BLUR_LEVELS = 6;
+
+/**
+ * Softens a light texture with a dual filter (Kawase) chain of compute passes: The input is halved several times and
+ * then upsampled again with a small tent-like kernel, so the cost hardly depends on the radius. All levels are
+ * allocated when the resolution changes. LIGHT_BLUR_GAUSSIAN iterates GaussianBlur.glsl at full resolution until the
+ * same variance is reached and only exists as a reference for comparing quality and speed.
+ */
+class LightBlur {
+public:
+    LightBlur();
+    ~LightBlur();
+    // The output has the passed format (RGBA16F for RGB9E5), the intermediate levels always use RGBA16F
+    void onResolutionChanged(int width, int height, LightFormat lightFormat = LIGHT_FORMAT_RGBA8);
+
+    // Returns the blurred texture (radius in pixels). It stays valid until the next call.
+    sgl::TexturePtr blur(sgl::TexturePtr inputTexture, LightBlurMode mode, float radius);
+    // GPU time of the last finished blur (read back a few frames late to avoid stalls)
+    inline float getBlurTimeMs() { return blurTimeMs; }
+    // Level 0 is the output, levels 1 to MAX_BLUR_LEVELS are the downsampled ones
+    inline sgl::TexturePtr getLevelTexture(int level) { return levelTextures.at(level); }
+    FrameGraphTextureDesc getLevelDesc(int level);
+
+private:
+    void blurDualKawase(sgl::TexturePtr &inputTexture, float radius);
+    void blurGaussian(sgl::TexturePtr &inputTexture, float radius);
+    void dispatch(sgl::ShaderProgramPtr &shader, sgl::TexturePtr &input, int outputLevel);
+
+    int width = 0, height = 0;
+    GLint outputFormat = GL_RGBA8;
+    sgl::ShaderProgramPtr downsampleShader;
+    sgl::ShaderProgramPtr upsampleShader;
+    sgl::ShaderProgramPtr upsampleOutputShader;
+    sgl::ShaderProgramPtr gaussianShader;
+
+    // Level 0 is the full resolution output, level i has the resolution divided by 2^i
+    std::vector<sgl::TexturePtr> levelTextures;
+    std::vector<glm::ivec2> levelSizes;
+    sgl::FramebufferObjectPtr outputFBO;
+    sgl::FramebufferObjectPtr gaussianTempFBO;
+    sgl::TexturePtr gaussianTempTex;
+
+    GLuint timestampQueries[2];
+    bool queryPending = false;
+    float blurTimeMs = 0.0f;
+};
+
+#endif /* LOGIC_LIGHTBLUR_HPP_ */
@@ -0,0 +1,180 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+#include "Utils/Profiler.hpp"
+#include "LightClustering.hpp"
+
+// Keeps dark lights from dividing by zero when weighting the positions
+const float MIN_LIGHT_WEIGHT = 1.0f;
+
+uint64_t LightClustering::getCellKey(const glm::vec2 &position) {
+    int32_t x = int32_t(std::floor(position.x / cellSize));
+    int32_t y = int32_t(std::floor(position.y / cellSize));
+    return (uint64_t(uint32_t(x)) << 32u) | uint64_t(uint32_t(y));
+}
+
+glm::vec2 LightClustering::getPosition(const ClusterNode &node) {
+    return node.weightedPositionSum / node.weightSum;
+}
+
+void LightClustering::addCandidates(int nodeIndex) {
+    // Two clusters whose centers are farther apart than the tolerance (i.e., the cell size) can't be merged
+    const ClusterNode &node = nodes.at(nodeIndex);
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            auto it = grid.find(getCellKey(node.center + glm::vec2(float(x), float(y)) * cellSize));
+            if (it == grid.end()) {
+                continue;
+            }
+            for (int otherIndex : it->second) {
+                const ClusterNode &other = nodes.at(otherIndex);
+                if (otherIndex == nodeIndex || !other.alive) {
+                    continue;
+                }
+                float distance = glm::length(other.center - node.center);
+                float mergedRadius = std::max(
+                        (distance + node.extentRadius + other.extentRadius) * 0.5f,
+                        std::max(node.extentRadius, other.extentRadius));
+                if (2.0f * mergedRadius <= cellSize) {
+                    candidateHeap.push_back(MergeCandidate(mergedRadius, std::make_pair(nodeIndex, otherIndex)));
+                    std::push_heap(candidateHeap.begin(), candidateHeap.end(), std::greater<MergeCandidate>());
+                }
+            }
+        }
+    }
+}
+
+void LightClustering::cluster(
+        const std::vector<VolumeLightPtr> &lights, float tolerance, std::vector<VolumeLightPtr> &groups) {
+    PROFILE_SCOPE("LightClustering::cluster");
+    groups.clear();
+    if (tolerance <= 0.0f || lights.size() < 2) {
+        groups = lights;
+        return;
+    }
+
+    cellSize = tolerance;
+    nodes.clear();
+    candidateHeap.clear();
+    grid.clear();
+    for (size_t i = 0; i < lights.size(); i++) {
+        VolumeLight &light = *lights.at(i);
+        sgl::Color color = light.getColor();
+        glm::vec3 colorVec(float(color.getR()), float(color.getG()), float(color.getB()));
+        float weight = std::max(colorVec.x + colorVec.y + colorVec.z, MIN_LIGHT_WEIGHT);
+        ClusterNode node;
+        node.center = light.getPosition();
+        node.extentRadius = 0.0f;
+        node.weightedPositionSum = light.getPosition() * weight;
+        node.colorSum = colorVec;
+        node.weightSum = weight;
+        node.reach = light.getRadius();
+        node.numLights = 1;
+        node.lightIndex = int(i);
+        node.alive = true;
+        nodes.push_back(node);
+        grid[getCellKey(node.center)].push_back(int(i));
+    }
+    for (size_t i = 0; i < lights.size(); i++) {
+        addCandidates(int(i));
+    }
+
+    // Agglomerative clustering: The pair with the smallest bounding circle is merged first
+    while (!candidateHeap.empty()) {
+        std::pop_heap(candidateHeap.begin(), candidateHeap.end(), std::greater<MergeCandidate>());
+        float mergedRadius = candidateHeap.back().first;
+        int indexA = candidateHeap.back().second.first;
+        int indexB = candidateHeap.back().second.second;
+        candidateHeap.pop_back();
+        if (!nodes.at(indexA).alive || !nodes.at(indexB).alive) {
+            continue;
+        }
+
+        ClusterNode &a = nodes.at(indexA);
+        ClusterNode &b = nodes.at(indexB);
+        ClusterNode parent;
+        float distance = glm::length(b.center - a.center);
+        if (distance + b.extentRadius <= a.extentRadius) {
+            parent.center = a.center;
+        } else if (distance + a.extentRadius <= b.extentRadius) {
+            parent.center = b.center;
+        } else {
+            parent.center = a.center + (b.center - a.center) * ((mergedRadius - a.extentRadius) / distance);
+        }
+        parent.extentRadius = mergedRadius;
+        parent.weightedPositionSum = a.weightedPositionSum + b.weightedPositionSum;
+        parent.colorSum = a.colorSum + b.colorSum;
+        parent.weightSum = a.weightSum + b.weightSum;
+        glm::vec2 position = parent.weightedPositionSum / parent.weightSum;
+        parent.reach = std::max(
+                a.reach + glm::length(getPosition(a) - position), b.reach + glm::length(getPosition(b) - position));
+        parent.numLights = a.numLights + b.numLights;
+        parent.lightIndex = -1;
+        parent.alive = true;
+        a.alive = false;
+        b.alive = false;
+
+        int parentIndex = int(nodes.size());
+        nodes.push_back(parent);
+        grid[getCellKey(parent.center)].push_back(parentIndex);
+        addCandidates(parentIndex);
+    }
+
+    // The remaining roots are the cut through the hierarchy
+    size_t numVirtualLights = 0;
+    for (const ClusterNode &node : nodes) {
+        if (!node.alive) {
+            continue;
+        }
+        if (node.numLights == 1) {
+            groups.push_back(lights.at(node.lightIndex));
+            continue;
+        }
+        glm::vec3 color = glm::min(node.colorSum, glm::vec3(255.0f));
+        sgl::Color groupColor(uint8_t(color.x), uint8_t(color.y), uint8_t(color.z));
+        if (numVirtualLights < virtualLights.size()) {
+            VolumeLightPtr &virtualLight = virtualLights.at(numVirtualLights);
+            virtualLight->setPosition(getPosition(node));
+            virtualLight->setRadius(node.reach);
+            virtualLight->setColor(groupColor);
+        } else {
+            virtualLights.push_back(VolumeLightPtr(new VolumeLight(getPosition(node), node.reach, groupColor)));
+        }
+        groups.push_back(virtualLights.at(numVirtualLights));
+        numVirtualLights++;
+    }
+}
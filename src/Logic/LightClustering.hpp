@@ -0,0 +1,85 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef LOGIC_LIGHTCLUSTERING_HPP_
+#define LOGIC_LIGHTCLUSTERING_HPP_
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "VolumeLight.hpp"
+
+/**
+ * Level of detail for lights. Lights are merged bottom-up (closest pair first) into a hierarchy of clusters. Every
+ * cluster whose bounding circle has a diameter of at most the tolerance is rendered as one virtual light, so the
+ * number of shadow passes depends on the number of perceptible light groups instead of the number of lights.
+ * The hierarchy is only built up to the tolerance, as larger clusters are never merged.
+ */
+class LightClustering {
+public:
+    /**
+     * Replaces the lights by their groups. Single lights are passed on, the virtual lights of larger groups have the
+     * summed color (clamped to 255), the position weighted by the intensities and a radius reaching as far as the
+     * farthest light of the group. The virtual lights stay valid until the next call.
+     * @param tolerance Maximum diameter of a group in world units (<= 0: The lights are passed on unchanged).
+     */
+    void cluster(const std::vector<VolumeLightPtr> &lights, float tolerance, std::vector<VolumeLightPtr> &groups);
+
+private:
+    struct ClusterNode {
+        glm::vec2 center; // Bounding circle of the positions
+        float extentRadius;
+        glm::vec2 weightedPositionSum;
+        glm::vec3 colorSum;
+        float weightSum;
+        float reach; // Radius of the virtual light
+        int numLights;
+        int lightIndex; // Only for single lights
+        bool alive; // False after being merged into a parent
+    };
+    // Extent radius of the merged cluster and the indices of both nodes
+    typedef std::pair<float, std::pair<int, int>> MergeCandidate;
+    uint64_t getCellKey(const glm::vec2 &position);
+    void addCandidates(int nodeIndex);
+    glm::vec2 getPosition(const ClusterNode &node);
+
+    float cellSize = 1.0f;
+    std::vector<ClusterNode> nodes;
+    std::vector<MergeCandidate> candidateHeap; // Min-heap of the merged extent radii
+    std::unordered_map<uint64_t, std::vector<int>> grid; // Nodes by cell (of the size of the tolerance)
+    std::vector<VolumeLightPtr> virtualLights;
+};
+
+#endif /* LOGIC_LIGHTCLUSTERING_HPP_ */
@@ -0,0 +1,75 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Utils/File/Logfile.hpp>
+
+#include "LightFormat.hpp"
+
+static bool isRenderableWithBlending(GLint internalFormat) {
+    GLint renderable = GL_NONE, blend = GL_NONE;
+    glGetInternalformativ(GL_TEXTURE_2D, internalFormat, GL_FRAMEBUFFER_RENDERABLE, 1, &renderable);
+    glGetInternalformativ(GL_TEXTURE_2D, internalFormat, GL_FRAMEBUFFER_BLEND, 1, &blend);
+    return renderable == GL_FULL_SUPPORT && blend == GL_FULL_SUPPORT;
+}
+
+LightFormat getSupportedLightFormat(LightFormat format) {
+    if (format != LIGHT_FORMAT_RGB9E5) {
+        return format;
+    }
+    // -1: Not queried yet
+    static int rgb9e5Supported = -1;
+    if (rgb9e5Supported < 0) {
+        rgb9e5Supported = isRenderableWithBlending(GL_RGB9_E5) ? 1 : 0;
+        if (!rgb9e5Supported) {
+            sgl::Logfile::get()->writeInfo(
+                    "RGB9E5 can't be rendered to with blending on this device, using R11G11B10F instead.");
+        }
+    }
+    return rgb9e5Supported ? format : LIGHT_FORMAT_R11G11B10F;
+}
+
+GLint getLightFormatInternalFormat(LightFormat format) {
+    switch (format) {
+    case LIGHT_FORMAT_R11G11B10F:
+        return GL_R11F_G11F_B10F;
+    case LIGHT_FORMAT_RGB9E5:
+        return GL_RGB9_E5;
+    case LIGHT_FORMAT_RGBA16F:
+        return GL_RGBA16F;
+    default:
+        return GL_RGBA8;
+    }
+}
+
+int getLightFormatBytesPerPixel(LightFormat format) {
+    return format == LIGHT_FORMAT_RGBA16F ? 8 : 4;
+}
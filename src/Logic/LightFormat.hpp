@@ -0,0 +1,58 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOGIC_LIGHTFORMAT_HPP_
+#define LOGIC_LIGHTFORMAT_HPP_
+
+#include <GL/glew.h>
+
+/**
+ * Format of the textures the light is accumulated in. RGBA8 saturates at 1 and bands with many dim lights. The packed
+ * float formats have the same size, but no alpha channel and only 6 (R11G11B10F) or 9 (RGB9E5) mantissa bits.
+ * RGBA16F doubles the bandwidth of every light.
+ */
+enum LightFormat {
+    LIGHT_FORMAT_RGBA8, LIGHT_FORMAT_R11G11B10F, LIGHT_FORMAT_RGB9E5, LIGHT_FORMAT_RGBA16F
+};
+const int NUM_LIGHT_FORMATS = 4;
+const char *const LIGHT_FORMAT_NAMES[] = {
+        "RGBA8", "R11G11B10F", "RGB9E5", "RGBA16F"
+};
+
+// RGB9E5 is only color-renderable (with blending) on some drivers. Otherwise, R11G11B10F is used instead.
+LightFormat getSupportedLightFormat(LightFormat format);
+GLint getLightFormatInternalFormat(LightFormat format);
+int getLightFormatBytesPerPixel(LightFormat format);
+// Anything but RGBA8 isn't clamped to [0,1] and needs tone mapping when combined with the scene
+inline bool isLightFormatHdr(LightFormat format) { return format != LIGHT_FORMAT_RGBA8; }
+
+#endif /* LOGIC_LIGHTFORMAT_HPP_ */
@@ -0,0 +1,287 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <cfloat>
+#include <GL/glew.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHTMANAGERCPU_SSE
+#include <emmintrin.h>
+#endif
+
+#include <Graphics/Renderer.hpp>
+#include <Graphics/Shader/ShaderManager.hpp>
+#include <Graphics/Texture/TextureManager.hpp>
+#include <Input/Keyboard.hpp>
+#include <Math/Geometry/MatrixUtil.hpp>
+#include <ImGui/ImGuiWrapper.hpp>
+
+#include "Utils/Profiler.hpp"
+#include "Utils/ShaderCache.hpp"
+#include "LightManagerCPU.hpp"
+
+static const int TILE_SIZE = 32;
+
+LightManagerCPU::LightManagerCPU(sgl::CameraPtr _camera) {
+    camera = _camera;
+    sceneTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
+    lightCombineShader = ShaderCache::get()->getShaderProgram(
+            {"LightMix.Vertex", "LightMix.Fragment"});
+    lightCombineShader->setUniform("ambientLight", sgl::Color(50, 50, 50));
+    // Only needed for the edge geometry of the primitives, the shadows are computed on the CPU
+    edgeShader = ShaderCache::get()->getShaderProgram(
+            {"VolumeLight.Vertex", "VolumeLight.Geometry", "VolumeLight.Fragment"});
+    onResolutionChanged();
+}
+
+void LightManagerCPU::renderGUI() {
+    ImGui::Separator();
+    ImGui::Text("CPU threads: %d", int(threadPool.getNumThreads()));
+}
+
+
+void LightManagerCPU::onResolutionChanged() {
+    width = getRenderWidth();
+    height = getRenderHeight();
+    numTilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    numTilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+    sceneFBO = sgl::Renderer->createFBO();
+    sceneTex = sgl::TextureManager->createEmptyTexture(width, height);
+    sceneFBO->bindTexture(sceneTex);
+    sceneTarget->bindFramebufferObject(sceneFBO);
+
+    lightTex = sgl::TextureManager->createEmptyTexture(width, height);
+    lightBuffer.resize(width * height * 4);
+}
+
+void LightManagerCPU::beginRenderScene() {
+    PROFILE_SCOPE("LightManagerCPU::beginRenderScene");
+    camera->setRenderTarget(sceneTarget);
+    sceneTarget->bindRenderTarget();
+    sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(242, 242, 242));
+
+    // Now render scene (user)
+}
+
+void LightManagerCPU::endRenderScene() {
+    PROFILE_SCOPE("LightManagerCPU::endRenderScene");
+    sgl::Renderer->unbindFBO();
+}
+
+void LightManagerCPU::beginRenderLightmap() {
+    PROFILE_SCOPE("LightManagerCPU::beginRenderLightmap");
+    // The camera rectangle in the plane z = 0 is mapped to the whole light buffer
+    sgl::AABB2 camRect = camera->getAABB2(0.0f);
+    pixelSize = glm::vec2(camRect.getWidth() / width, camRect.getHeight() / height);
+    worldOrigin = camRect.min + 0.5f * pixelSize;
+}
+
+void LightManagerCPU::computeShadowWedges() {
+    updateOccluderEdges();
+    sgl::AABB2 camRect = camera->getAABB2(0.0f);
+
+    std::vector<VolumeLightPtr> &lights = getLights();
+    lightWedges.resize(lights.size());
+    for (size_t lightIdx = 0; lightIdx < lights.size(); lightIdx++) {
+        glm::vec2 lightPos = lights.at(lightIdx)->getPosition();
+        std::vector<ShadowWedge> &wedges = lightWedges.at(lightIdx);
+        wedges.clear();
+        getShadowCastingEdges(lightPos, camRect, edgePoints);
+        for (size_t i = 0; i < edgePoints.size(); i += 2) {
+            glm::vec2 pt0 = edgePoints.at(i);
+            glm::vec2 pt1 = edgePoints.at(i + 1);
+            glm::vec2 offset = pt1 - pt0;
+            glm::vec2 midpoint = (pt0 + pt1) * 0.5f;
+
+            // The rays from the light through both end points and the edge itself bound the shadow volume.
+            // The functions are oriented such that a point behind the midpoint of the edge is inside.
+            glm::vec2 insidePoint = midpoint + (midpoint - lightPos);
+            glm::vec2 origins[3] = { lightPos, lightPos, pt0 };
+            glm::vec2 directions[3] = { pt0 - lightPos, pt1 - lightPos, offset };
+            ShadowWedge wedge;
+            bool degenerate = false;
+            for (int k = 0; k < 3; k++) {
+                float a = -directions[k].y, b = directions[k].x;
+                float c = directions[k].y * origins[k].x - directions[k].x * origins[k].y;
+                float insideValue = a * insidePoint.x + b * insidePoint.y + c;
+                if (insideValue == 0.0f) {
+                    degenerate = true;
+                    break;
+                }
+                float sign = insideValue > 0.0f ? 1.0f : -1.0f;
+                wedge.a[k] = sign * a;
+                wedge.b[k] = sign * b;
+                wedge.c[k] = sign * c;
+            }
+            if (!degenerate) {
+                wedges.push_back(wedge);
+            }
+        }
+    }
+}
+
+void LightManagerCPU::renderLightmap(std::function<void()> renderfun) {
+    PROFILE_SCOPE("LightManagerCPU::renderLightmap");
+    computeShadowWedges();
+    threadPool.parallelFor(numTilesX * numTilesY, [this](int tileIndex){ renderTile(tileIndex); });
+}
+
+void LightManagerCPU::renderTile(int tileIndex) {
+    int x0 = (tileIndex % numTilesX) * TILE_SIZE, y0 = (tileIndex / numTilesX) * TILE_SIZE;
+    int x1 = std::min(x0 + TILE_SIZE, width), y1 = std::min(y0 + TILE_SIZE, height);
+    int tileWidth = x1 - x0, tileHeight = y1 - y0;
+    glm::vec2 tileMin = worldOrigin + pixelSize * glm::vec2(x0, y0);
+    glm::vec2 tileMax = worldOrigin + pixelSize * glm::vec2(x1 - 1, y1 - 1);
+    glm::vec2 corners[4] = { tileMin, glm::vec2(tileMax.x, tileMin.y), glm::vec2(tileMin.x, tileMax.y), tileMax };
+
+    // Lights have no attenuation, so the sums can only exceed 255 by the number of lights. 32 bits don't wrap around
+    // before 2^24 overlapping full-intensity lights.
+    uint32_t accumulated[TILE_SIZE * TILE_SIZE * 4];
+    memset(accumulated, 0, sizeof(accumulated));
+    thread_local std::vector<const ShadowWedge*> tileWedges;
+
+    std::vector<VolumeLightPtr> &lights = getLights();
+    for (size_t lightIdx = 0; lightIdx < lights.size(); lightIdx++) {
+        // Cull the shadow volumes against the pixel centers of the tile
+        tileWedges.clear();
+        bool tileInShadow = false;
+        for (const ShadowWedge &wedge : lightWedges.at(lightIdx)) {
+            bool outside = false, inside = true;
+            for (int k = 0; k < 3; k++) {
+                float minValue = FLT_MAX, maxValue = -FLT_MAX;
+                for (int i = 0; i < 4; i++) {
+                    float value = wedge.a[k] * corners[i].x + wedge.b[k] * corners[i].y + wedge.c[k];
+                    minValue = std::min(minValue, value);
+                    maxValue = std::max(maxValue, value);
+                }
+                outside |= maxValue < 0.0f;
+                inside &= minValue >= 0.0f;
+            }
+            if (inside) {
+                tileInShadow = true;
+                break;
+            }
+            if (!outside) {
+                tileWedges.push_back(&wedge);
+            }
+        }
+        if (tileInShadow) {
+            continue;
+        }
+
+        sgl::Color color = lights.at(lightIdx)->getColor();
+        uint32_t lightColor[4] = { color.getR(), color.getG(), color.getB(), color.getA() };
+        for (int y = 0; y < tileHeight; y++) {
+            float worldY = worldOrigin.y + pixelSize.y * float(y0 + y);
+            uint32_t *row = accumulated + y * TILE_SIZE * 4;
+            for (int x = 0; x < tileWidth; x += 4) {
+                float worldX = worldOrigin.x + pixelSize.x * float(x0 + x);
+                int shadowMask = 0;
+#ifdef LIGHTMANAGERCPU_SSE
+                __m128 xs = _mm_add_ps(
+                        _mm_set1_ps(worldX), _mm_mul_ps(_mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f), _mm_set1_ps(pixelSize.x)));
+                __m128 zero = _mm_setzero_ps();
+                for (const ShadowWedge *wedge : tileWedges) {
+                    __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(wedge->a[0]), xs),
+                            _mm_set1_ps(wedge->b[0] * worldY + wedge->c[0])), zero);
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(wedge->a[1]), xs),
+                            _mm_set1_ps(wedge->b[1] * worldY + wedge->c[1])), zero));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(wedge->a[2]), xs),
+                            _mm_set1_ps(wedge->b[2] * worldY + wedge->c[2])), zero));
+                    shadowMask |= _mm_movemask_ps(inside);
+                    if (shadowMask == 0xF) {
+                        break;
+                    }
+                }
+#else
+                for (int i = 0; i < 4; i++) {
+                    float px = worldX + float(i) * pixelSize.x;
+                    for (const ShadowWedge *wedge : tileWedges) {
+                        if (wedge->a[0] * px + wedge->b[0] * worldY + wedge->c[0] >= 0.0f
+                                && wedge->a[1] * px + wedge->b[1] * worldY + wedge->c[1] >= 0.0f
+                                && wedge->a[2] * px + wedge->b[2] * worldY + wedge->c[2] >= 0.0f) {
+                            shadowMask |= 1 << i;
+                            break;
+                        }
+                    }
+                }
+#endif
+                int numPixels = std::min(4, tileWidth - x);
+                for (int i = 0; i < numPixels; i++) {
+                    if ((shadowMask & (1 << i)) == 0) {
+                        uint32_t *pixel = row + (x + i) * 4;
+                        pixel[0] += lightColor[0];
+                        pixel[1] += lightColor[1];
+                        pixel[2] += lightColor[2];
+                        pixel[3] += lightColor[3];
+                    }
+                }
+            }
+        }
+    }
+
+    // Saturate like additive blending into an 8-bit render target
+    for (int y = 0; y < tileHeight; y++) {
+        uint8_t *dst = &lightBuffer.front() + ((y0 + y) * width + x0) * 4;
+        const uint32_t *src = accumulated + y * TILE_SIZE * 4;
+        for (int i = 0; i < tileWidth * 4; i++) {
+            dst[i] = uint8_t(std::min(src[i], uint32_t(255)));
+        }
+    }
+}
+
+void LightManagerCPU::endRenderLightmap() {
+    PROFILE_SCOPE("LightManagerCPU::endRenderLightmap");
+    lightTex->uploadPixelData(width, height, &lightBuffer.front());
+}
+
+void LightManagerCPU::blitMixSceneAndLights() {
+    PROFILE_SCOPE("LightManagerCPU::blitMixSceneAndLights");
+    sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+
+    if (sgl::Keyboard->isKeyDown(SDLK_s)) {
+        sgl::Renderer->blitTexture(
+                sceneTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
+    } else if (sgl::Keyboard->isKeyDown(SDLK_d)) {
+        sgl::Renderer->blitTexture(
+                lightTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
+    } else {
+        lightCombineShader->setUniform("lightTexture", lightTex, 1);
+        sgl::Renderer->blitTexture(
+                sceneTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)), lightCombineShader);
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOGIC_VOLUMELIGHT_LIGHTMANAGERCPU_HPP_
+#define LOGIC_VOLUMELIGHT_LIGHTMANAGERCPU_HPP_
+
+#include <cstdint>
+#include "Utils/ThreadPool.hpp"
+#include "LightManagerInterface.hpp"
+
+/**
+ * Software renderer for the light buffer, e.g. for systems without GPU acceleration. The screen is split into tiles
+ * that are processed in parallel. Each tile culls the shadow volumes of the occluder edges against its bounds and
+ * tests the remaining ones with SIMD half-space tests. Only the finished light buffer is uploaded to the GPU.
+ * As it computes the same shadow volumes as LightManagerVolume, it also serves as a reference for the GPU managers.
+ */
+class LightManagerCPU : public LightManagerInterface {
+public:
+    LightManagerCPU(sgl::CameraPtr _camera);
+    void beginRenderScene();
+    void endRenderScene();
+    void beginRenderLightmap();
+    void renderLightmap(std::function<void()> renderfun); // renderfun is unused, the occluders are used directly
+    void endRenderLightmap();
+    void blitMixSceneAndLights();
+    void renderGUI();
+
+    void onOccluderChanged(const sgl::AABB2 &region) {}
+    void onResolutionChanged();
+    sgl::ShaderProgramPtr getEdgeShader() { return edgeShader; }
+    sgl::TexturePtr getLightTexture() { return lightTex; }
+
+    // RGBA light buffer of the last frame (bottom row first)
+    const std::vector<uint8_t> &getLightBuffer() { return lightBuffer; }
+
+private:
+    // Shadow volume of one edge: Inside if all three linear functions a*x + b*y + c are non-negative
+    struct ShadowWedge {
+        float a[3], b[3], c[3];
+    };
+    void computeShadowWedges();
+    void renderTile(int tileIndex);
+
+    sgl::CameraPtr camera;
+    sgl::ShaderProgramPtr edgeShader;
+    sgl::ShaderProgramPtr lightCombineShader;
+
+    sgl::RenderTargetPtr sceneTarget;
+    sgl::FramebufferObjectPtr sceneFBO;
+    sgl::TexturePtr sceneTex;
+    sgl::TexturePtr lightTex;
+
+    ThreadPool threadPool;
+    std::vector<glm::vec2> edgePoints; // Line list of the shadow casting edges of the current light
+    std::vector<std::vector<ShadowWedge>> lightWedges; // Shadow volumes of the back-facing edges per light
+    std::vector<uint8_t> lightBuffer;
+    int width = 0, height = 0;
+    int numTilesX = 0, numTilesY = 0;
+    glm::vec2 worldOrigin; // World position of the center of pixel (0, 0)
+    glm::vec2 pixelSize;
+};
+
+
+
+#endif /* LOGIC_VOLUMELIGHT_LIGHTMANAGERCPU_HPP_ */
@@ -0,0 +1,148 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <Graphics/Renderer.hpp>
+#include <Graphics/Shader/ShaderAttributes.hpp>
+#include <Math/Geometry/MatrixUtil.hpp>
+#include "LightManagerInterface.hpp"
+
+sgl::ShaderAttributesPtr createFullscreenQuadRenderData(sgl::ShaderProgramPtr shader, sgl::AABB2 sceneRect) {
+    // Set up the vertex data of the rectangle
+    std::vector<glm::vec2> fullscreenQuad{
+        glm::vec2(sceneRect.max.x, sceneRect.max.y),
+        glm::vec2(sceneRect.min.x, sceneRect.min.y),
+        glm::vec2(sceneRect.max.x, sceneRect.min.y),
+        glm::vec2(sceneRect.min.x, sceneRect.min.y),
+        glm::vec2(sceneRect.max.x, sceneRect.max.y),
+        glm::vec2(sceneRect.min.x, sceneRect.max.y)};
+
+    // Feed the shader with the data
+    sgl::GeometryBufferPtr geomBuffer = sgl::Renderer->createGeometryBuffer(
+            sizeof(glm::vec2)*fullscreenQuad.size(), &fullscreenQuad.front());
+    sgl::ShaderAttributesPtr shaderAttributes = sgl::ShaderManager->createShaderAttributes(shader);
+    shaderAttributes->addGeometryBuffer(geomBuffer, "vertexPosition", sgl::ATTRIB_FLOAT, 2);
+    return shaderAttributes;
+}
+
+int LightManagerInterface::selectEdgeLod(Primitive &occluder) {
+    float tolerance = getShadowLodTolerance(shadowPassViewRect);
+    if (shadowPassLights.empty() || tolerance <= 0.0f) {
+        return 0;
+    }
+    // All lights of the pass share the edge data, so the finest level needed by any of them is used
+    int lod = occluder.getNumEdgeLods() - 1;
+    for (const glm::vec2 &lightPos : shadowPassLights) {
+        lod = std::min(lod, occluder.selectEdgeLod(lightPos, shadowPassViewRect, tolerance));
+        if (lod == 0) {
+            break;
+        }
+    }
+    return lod;
+}
+
+glm::mat4 LightManagerInterface::getJitteredProjectionMatrix(const glm::mat4 &projectionMatrix) {
+    // Applied after the projection, i.e., the offset is the same for all depths
+    return sgl::matrixTranslation(projectionJitter) * projectionMatrix;
+}
+
+float LightManagerInterface::getShadowLodTolerance(const sgl::AABB2 &viewRect) {
+    return shadowLodError * viewRect.getWidth() / float(getRenderWidth());
+}
+
+std::vector<VolumeLightPtr> &LightManagerInterface::getLightGroups(
+        bool renderStaticLights, const sgl::AABB2 &viewRect) {
+    clusterInputLights.clear();
+    for (VolumeLightPtr &light : getLights()) {
+        if (renderStaticLights || !light->isStatic()) {
+            clusterInputLights.push_back(light);
+        }
+    }
+    float tolerance = lightClusterError * viewRect.getWidth() / float(getRenderWidth());
+    lightClustering.cluster(clusterInputLights, tolerance, lightGroups);
+    numLightGroups = int(lightGroups.size());
+    return lightGroups;
+}
+
+void LightManagerInterface::updateOccluderEdges() {
+    occluderEdgePoints.resize(occluders.size());
+    occluderEdgeBounds.resize(occluders.size());
+    std::vector<glm::vec2> edgeLoop;
+    for (size_t occluderIdx = 0; occluderIdx < occluders.size(); occluderIdx++) {
+        PrimitivePtr &occluder = occluders.at(occluderIdx);
+        std::vector<std::vector<glm::vec2>> &lodEdgePoints = occluderEdgePoints.at(occluderIdx);
+        lodEdgePoints.resize(std::max(occluder->getNumEdgeLods(), 1));
+        sgl::AABB2 &bounds = occluderEdgeBounds.at(occluderIdx);
+        bounds = sgl::AABB2(occluder->getPosition(), occluder->getPosition());
+        bool hasEdges = false;
+        for (size_t lod = 0; lod < lodEdgePoints.size(); lod++) {
+            occluder->getWorldEdges(edgeLoop, int(lod));
+            std::vector<glm::vec2> &edgePoints = lodEdgePoints.at(lod);
+            edgePoints.clear();
+            for (size_t i = 0; i < edgeLoop.size(); i++) {
+                edgePoints.push_back(edgeLoop.at(i));
+                edgePoints.push_back(edgeLoop.at((i + 1) % edgeLoop.size()));
+                if (!hasEdges) {
+                    bounds = sgl::AABB2(edgeLoop.at(i), edgeLoop.at(i));
+                    hasEdges = true;
+                }
+                bounds.combine(edgeLoop.at(i));
+            }
+        }
+    }
+}
+
+void LightManagerInterface::getShadowCastingEdges(
+        const glm::vec2 &lightPos, const sgl::AABB2 &viewRect, std::vector<glm::vec2> &shadowEdgePoints,
+        float maxDistance) {
+    float tolerance = getShadowLodTolerance(viewRect);
+    bool limited = maxDistance < std::numeric_limits<float>::max();
+    sgl::AABB2 reach(lightPos - glm::vec2(maxDistance), lightPos + glm::vec2(maxDistance));
+    shadowEdgePoints.clear();
+    for (size_t occluderIdx = 0; occluderIdx < occluderEdgePoints.size(); occluderIdx++) {
+        if (limited && !reach.intersects(occluderEdgeBounds.at(occluderIdx))) {
+            continue;
+        }
+        int lod = occluders.at(occluderIdx)->selectEdgeLod(lightPos, viewRect, tolerance);
+        const std::vector<glm::vec2> &edgePoints = occluderEdgePoints.at(occluderIdx).at(lod);
+        for (size_t i = 0; i < edgePoints.size(); i += 2) {
+            // Same test as in VolumeLight.Geometry: Only edges facing away from the light cast a shadow volume
+            glm::vec2 offset = edgePoints.at(i + 1) - edgePoints.at(i);
+            glm::vec2 normal(-offset.y, offset.x);
+            glm::vec2 midpoint = (edgePoints.at(i) + edgePoints.at(i + 1)) * 0.5f;
+            if (glm::dot(normal, midpoint - lightPos) < 0.0f) {
+                shadowEdgePoints.push_back(edgePoints.at(i));
+                shadowEdgePoints.push_back(edgePoints.at(i + 1));
+            }
+        }
+    }
+}
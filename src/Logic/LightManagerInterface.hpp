@@ -36,15 +36,31 @@
 #include <Graphics/Shader/ShaderManager.hpp>
 #include <Graphics/Scene/RenderTarget.hpp>
 #include <Graphics/Scene/Camera.hpp>
+#include <Math/Geometry/AABB2.hpp>
+#include <Utils/AppSettings.hpp>
+#include <Graphics/Window.hpp>
 #include <glm/glm.hpp>
 #include <vector>
+#include <limits>
 #include <functional>
 #include "VolumeLight.hpp"
+#include "Primitive.hpp"
+#include "BakedLightmap.hpp"
+#include "Utils/FrameGraph.hpp"
+#include "LightFormat.hpp"
+#include "Multisampling.hpp"
+#include "LightClustering.hpp"
+#include "LightView.hpp"
+
+typedef boost::shared_ptr<std::vector<VolumeLightPtr>> LightStorePtr;
+
+// Two triangles covering the passed rectangle (only vertex positions)
+sgl::ShaderAttributesPtr createFullscreenQuadRenderData(sgl::ShaderProgramPtr shader, sgl::AABB2 sceneRect);
 
 class LightManagerInterface
 {
 public:
-    LightManagerInterface() {}
+    LightManagerInterface() : lightStore(new std::vector<VolumeLightPtr>()) {}
     virtual ~LightManagerInterface() {}
     virtual void beginRenderScene()=0;
     virtual void endRenderScene()=0;
@@ -54,12 +70,113 @@ public:
     virtual void blitMixSceneAndLights()=0;
     virtual void renderGUI()=0;
 
-    virtual VolumeLightPtr addLight(
-            const glm::vec2 &pos, float rad = 10.0f, const sgl::Color &col = sgl::Color(255, 255, 255))=0;
-    virtual std::vector<VolumeLightPtr> &getLights()=0;
+    VolumeLightPtr addLight(
+            const glm::vec2 &pos, float rad = 10.0f, const sgl::Color &col = sgl::Color(255, 255, 255)) {
+        VolumeLightPtr light(new VolumeLight(pos, rad, col));
+        lightStore->push_back(light);
+        return light;
+    }
+    std::vector<VolumeLightPtr> &getLights() { return *lightStore; }
+    // Resident light managers share one light store, so switching between them doesn't copy any lights
+    void setLightStore(LightStorePtr store) { lightStore = store; }
+    LightStorePtr getLightStore() { return lightStore; }
+
+    // Called if an occluder changed inside the passed region (in world space)
+    virtual void onOccluderChanged(const sgl::AABB2 &region)=0;
 
     virtual void onResolutionChanged()=0;
     virtual sgl::ShaderProgramPtr getEdgeShader()=0;
+    // The accumulated light of all lights after endRenderLightmap
+    virtual sgl::TexturePtr getLightTexture()=0;
+    // False if the result of the scene pass isn't used in this frame (e.g., in the light debug view)
+    virtual bool isSceneNeeded() { return true; }
+    // Only managers whose render targets are transient resources of a frame graph return one
+    virtual FrameGraph *getFrameGraph() { return nullptr; }
+    // Estimated framebuffer traffic per pixel of adding one dynamic light to the light buffer (0: Not estimated)
+    virtual int getLightBytesPerPixel() { return 0; }
+
+    // Views rendered by renderAdditionalViews in every frame in addition to the one of the camera
+    void setAdditionalViews(const std::vector<LightViewPtr> &views) { additionalViews = views; }
+    /**
+     * Renders the additional views with the shadow data of the current frame after blitMixSceneAndLights and
+     * composites them into the bound framebuffer. Returns false if the shadow data of the manager depends on the view.
+     * @param renderScene Renders the scene with the passed camera.
+     */
+    virtual bool renderAdditionalViews(std::function<void(sgl::CameraPtr)> renderScene) { return false; }
+
+    // Static lights matching the baked ones aren't rendered anymore if a baked lightmap is set
+    void setBakedLightmap(BakedLightmapPtr lightmap) { bakedLightmap = lightmap; }
+    BakedLightmapPtr getBakedLightmap() { return bakedLightmap; }
+
+    // Managers that compute the shadows on the CPU use the edges of the occluders instead of the render callback
+    void setOccluders(const std::vector<PrimitivePtr> &primitives) { occluders = primitives; }
+
+    /**
+     * Maximum on-screen error of the shadow edges (in pixels) when the occluders are rendered with simplified
+     * outlines. 0 disables the shadow-pass level of detail.
+     */
+    void setShadowLodError(float pixels) { shadowLodError = pixels; }
+    float getShadowLodError() { return shadowLodError; }
+    /**
+     * Maximum on-screen diameter (in pixels) of a group of lights that is rendered as one virtual light with a single
+     * shadow pass. 0 renders every light on its own.
+     */
+    void setLightClusterError(float pixels) { lightClusterError = pixels; }
+    float getLightClusterError() { return lightClusterError; }
+    // Number of lights rendered with their own shadow pass in the last frame, i.e., after clustering
+    int getNumLightGroups() { return numLightGroups; }
+    // Level of detail of the occluder for the lights of the current shadow pass (called by the render callback)
+    int selectEdgeLod(Primitive &occluder);
+    // Projection of the shadow pass, shifted by the sub-pixel jitter of temporal antialiasing (called by the render
+    // callback)
+    glm::mat4 getJitteredProjectionMatrix(const glm::mat4 &projectionMatrix);
+
+    // Overrides the size of the internal render targets (e.g. for baking). 0 means the window size is used.
+    void setRenderResolution(int width, int height) {
+        renderWidth = width;
+        renderHeight = height;
+        onResolutionChanged();
+    }
+
+protected:
+    int getRenderWidth() {
+        return renderWidth > 0 ? renderWidth : sgl::AppSettings::get()->getMainWindow()->getWidth();
+    }
+    int getRenderHeight() {
+        return renderHeight > 0 ? renderHeight : sgl::AppSettings::get()->getMainWindow()->getHeight();
+    }
+
+    // Tolerance for Primitive::selectEdgeLod in world units
+    float getShadowLodTolerance(const sgl::AABB2 &viewRect);
+    // The lights rendered each frame (the dynamic ones, or all if renderStaticLights), after clustering
+    std::vector<VolumeLightPtr> &getLightGroups(bool renderStaticLights, const sgl::AABB2 &viewRect);
+    // Transforms the edge loops of all occluders and levels of detail to world space (once per frame)
+    void updateOccluderEdges();
+    // Line list of all edges facing away from the light, each occluder at the level of detail selected for the light.
+    // Occluders that don't overlap the square of half size maxDistance around the light are skipped.
+    void getShadowCastingEdges(
+            const glm::vec2 &lightPos, const sgl::AABB2 &viewRect, std::vector<glm::vec2> &shadowEdgePoints,
+            float maxDistance = std::numeric_limits<float>::max());
+
+    LightStorePtr lightStore;
+    BakedLightmapPtr bakedLightmap;
+    std::vector<LightViewPtr> additionalViews;
+    std::vector<PrimitivePtr> occluders;
+    std::vector<std::vector<std::vector<glm::vec2>>> occluderEdgePoints; // Indexed by occluder, then level of detail
+    std::vector<sgl::AABB2> occluderEdgeBounds; // Bounds of the edges of all levels of detail
+
+    // Set by the GPU managers before calling the render callback of a shadow pass
+    std::vector<glm::vec2> shadowPassLights;
+    sgl::AABB2 shadowPassViewRect;
+    glm::vec2 projectionJitter = glm::vec2(0.0f); // In normalized device coordinates, 0 without temporal AA
+
+private:
+    float shadowLodError = 0.5f;
+    float lightClusterError = 0.0f;
+    int numLightGroups = 0;
+    LightClustering lightClustering;
+    std::vector<VolumeLightPtr> clusterInputLights, lightGroups;
+    int renderWidth = 0, renderHeight = 0;
 };
 
 
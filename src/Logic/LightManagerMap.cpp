@@ -31,6 +31,7 @@
  */
 
 #include <vector>
+#include <algorithm>
 #include <GL/glew.h>
 
 #include <Graphics/Renderer.hpp>
@@ -38,6 +39,7 @@
 #include <Graphics/Texture/TextureManager.hpp>
 #include <Graphics/Window.hpp>
 #include <Utils/AppSettings.hpp>
+#include <Utils/Convert.hpp>
 #include <Input/Keyboard.hpp>
 #include <Math/Math.hpp>
 #include <Math/Geometry/MatrixUtil.hpp>
@@ -46,52 +48,26 @@
 #include <Graphics/Shader/ShaderAttributes.hpp>
 #include <ImGui/ImGuiWrapper.hpp>
 
+#include "Utils/Profiler.hpp"
+#include "Utils/ShaderCache.hpp"
 #include "LightManagerMap.hpp"
 
 const float LIGHT_FAR_PLANE_DIST = 10.0f;
 static int depthFormat = GL_DEPTH_COMPONENT16;
-
-GLuint createShadowmapTex(int res) {
-    GLuint texture = 0;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, depthFormat, res, 1, 3);
-    return texture;
-}
-
-sgl::ShaderAttributesPtr createFullscreenQuadRenderData(sgl::ShaderProgramPtr shader, sgl::AABB2 sceneRect) {
-    // Set up the vertex data of the rectangle
-    std::vector<glm::vec2> fullscreenQuad{
-        glm::vec2(sceneRect.max.x, sceneRect.max.y),
-        glm::vec2(sceneRect.min.x, sceneRect.min.y),
-        glm::vec2(sceneRect.max.x, sceneRect.min.y),
-        glm::vec2(sceneRect.min.x, sceneRect.min.y),
-        glm::vec2(sceneRect.max.x, sceneRect.max.y),
-        glm::vec2(sceneRect.min.x, sceneRect.max.y)};
-
-    // Feed the shader with the data
-    sgl::GeometryBufferPtr geomBuffer = sgl::Renderer->createGeometryBuffer(
-            sizeof(glm::vec2)*fullscreenQuad.size(), &fullscreenQuad.front());
-    sgl::ShaderAttributesPtr shaderAttributes = sgl::ShaderManager->createShaderAttributes(shader);
-    shaderAttributes->addGeometryBuffer(geomBuffer, "vertexPosition", sgl::ATTRIB_FLOAT, 2);
-    return shaderAttributes;
-}
+static bool attenuation = false;
+static int lightFormat = LIGHT_FORMAT_RGBA8;
+static bool temporalAntialiasing = false;
 
 LightManagerMap::LightManagerMap(sgl::CameraPtr _camera) {
     camera = _camera;
-    sceneTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
-    lightTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
-    shadowmapTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
-    lightCombineShader = sgl::ShaderManager->getShaderProgram({"LightMix.Vertex", "LightMix.Fragment"});
-    lightCombineShader->setUniform("ambientLight", sgl::Color(50, 50, 50));
-    shadowmapShader = sgl::ShaderManager->getShaderProgram({"ShadowMapVolume.Vertex",
-            "ShadowMapVolume.Geometry", "ShadowMapVolume.Fragment"});
-    shadowMapRenderShader = sgl::ShaderManager->getShaderProgram({"ShadowMapRender.Vertex",
-        "ShadowMapRender.Fragment"});
+    // Every light of a batch renders to its own viewport of the shadow atlas
+    GLint maxViewports = 16;
+    glGetIntegerv(GL_MAX_VIEWPORTS, &maxViewports);
+    maxLightsPerPass = std::min(int(maxViewports), 16);
+    shadowmapShader = ShaderCache::get()->getShaderProgram({"ShadowMapVolume.Vertex",
+            "ShadowMapVolume.Geometry", "ShadowMapVolume.Fragment"},
+            {{"MAX_LIGHTS_PER_PASS", sgl::toString(maxLightsPerPass)}});
+    loadShaders();
     onResolutionChanged();
 
     // The three light cams look in three directions with 120° angles inbetween
@@ -104,26 +80,95 @@ LightManagerMap::LightManagerMap(sgl::CameraPtr _camera) {
         glm::vec3 eyepos(0.0f, 0.0f, 0.0f);
         lightcamView[i] = glm::lookAt(eyepos, eyepos+lightcamLookDir[i], glm::vec3(0.0f, 0.0f, 1.0f)); // eye, center, up
     }
+    // The geometry shader moves the geometry relative to the light of the invocation
+    int matUniformLoc = shadowmapShader->getUniformLoc("camViewProjMatrices");
+    for (int i = 0; i < 3; ++i) {
+        shadowmapShader->setUniform(matUniformLoc+i, lightcamProj[i]*lightcamView[i]);
+    }
     shadowmapShader->setUniform("farPlaneDist", LIGHT_FAR_PLANE_DIST);
+}
+
+void LightManagerMap::loadShaders() {
+    // The depth bias only needs to cover the quantization error of the depth format
+    ShaderDefines defines;
+    if (depthFormat == GL_DEPTH_COMPONENT16) {
+        defines["SHADOW_BIAS"] = "0.002";
+    } else if (depthFormat == GL_DEPTH_COMPONENT24) {
+        defines["SHADOW_BIAS"] = "0.0005";
+    } else {
+        defines["SHADOW_BIAS"] = "0.0002";
+    }
+    if (attenuation) {
+        defines["LIGHT_ATTENUATION"] = "";
+    }
+    shadowMapRenderShader = ShaderCache::get()->getShaderProgram(
+            {"ShadowMapRender.Vertex", "ShadowMapRender.Fragment"}, defines);
     shadowMapRenderShader->setUniform("farPlaneDist", LIGHT_FAR_PLANE_DIST);
+    loadCombineShader();
+}
+
+void LightManagerMap::loadCombineShader() {
+    // HDR light needs to be tone mapped instead of clamped when combined with the scene
+    ShaderDefines combineDefines;
+    if (isLightFormatHdr(getSupportedLightFormat(LightFormat(lightFormat)))) {
+        combineDefines["HDR_LIGHT"] = "";
+    }
+    lightCombineShader = ShaderCache::get()->getShaderProgram({"LightMix.Vertex", "LightMix.Fragment"}, combineDefines);
+    lightCombineShader->setUniform("ambientLight", sgl::Color(50, 50, 50));
 }
 
 
 static int shadowMapWidth = 2048;
-static bool multisampling = false;
+static int sceneSamples = 1;
 static int depthFormatIndex = 0;
+static bool cacheStaticLights = true;
+static int shadowAtlasRingSize = 3;
+
+void LightManagerMap::setShadowAtlasRingSize(int ringSize) {
+    shadowAtlasRingSize = std::max(ringSize, 1);
+}
+
+void LightManagerMap::setMultisampling(int numSamples) {
+    sceneSamples = numSamples;
+}
+
+void LightManagerMap::setTemporalAA(bool enabled) {
+    temporalAntialiasing = enabled;
+}
+
+void LightManagerMap::setLightFormat(LightFormat format) {
+    lightFormat = format;
+}
+
+int LightManagerMap::getLightBytesPerPixel() {
+    // Each light is blended additively, i.e., the light buffer is read and written once
+    return 2 * getLightFormatBytesPerPixel(getSupportedLightFormat(LightFormat(lightFormat)));
+}
 
 void LightManagerMap::renderGUI() {
     ImGui::Separator();
 
-    ImGui::Text("Shadow Map Resolution:");
+    ImGui::Text("Maximum Shadow Map Resolution:");
     if (ImGui::SliderInt("pixels", &shadowMapWidth, 16, 4096)) {
-        onResolutionChanged();
+        staticLightCache.invalidate();
+    }
+    if (!shadowAtlases.empty()) {
+        ShadowAtlas &shadowAtlas = shadowAtlases.at(currentAtlasIndex);
+        int numAtlasTexels = shadowAtlas.getWidth() * shadowAtlas.getHeight();
+        ImGui::Text("Shadow atlas: %dx%d, %d%% used", shadowAtlas.getWidth(), shadowAtlas.getHeight(),
+                numAtlasTexels > 0 ? 100 * shadowAtlas.getNumUsedTexels() / numAtlasTexels : 0);
     }
+    ImGui::SliderInt("Atlas Ring Size", &shadowAtlasRingSize, 1, 8);
 
-    if (ImGui::Checkbox("Multisampling", &multisampling)) {
+    // The light is computed per pixel from the shadow maps, so only the scene has geometry edges to antialias
+    if (renderSampleCountCombo("Scene MSAA", &sceneSamples)) {
         onResolutionChanged();
     }
+    if (ImGui::Combo("Light Format", &lightFormat, LIGHT_FORMAT_NAMES, NUM_LIGHT_FORMATS)) {
+        loadShaders();
+        onResolutionChanged();
+    }
+    ImGui::Checkbox("Temporal AA", &temporalAntialiasing);
 
     const char *depthFormatNames[] = {"UNORM 16-bit", "UNORM 24-bit", "UNORM 32-bit", "Float 32-bit"};
     if (ImGui::Combo("Precision", (int*)&depthFormatIndex, depthFormatNames, IM_ARRAYSIZE(depthFormatNames))) {
@@ -136,145 +181,433 @@ void LightManagerMap::renderGUI() {
         } else if (depthFormatIndex == 3) {
             depthFormat = GL_DEPTH_COMPONENT32F;
         }
+        loadShaders();
         onResolutionChanged();
     }
+
+    if (ImGui::Checkbox("Attenuation", &attenuation)) {
+        loadShaders();
+        onResolutionChanged();
+    }
+
+    if (ImGui::Checkbox("Cache Static Lights", &cacheStaticLights)) {
+        staticLightCache.invalidate();
+    }
+
+    ImGui::Text("%s", frameGraph.getMemorySummary().c_str());
 }
 
 
 
-VolumeLightPtr LightManagerMap::addLight(const glm::vec2 &pos, float rad, const sgl::Color &col) {
-    VolumeLightPtr light(new VolumeLight(pos, rad, col));
-    lights.push_back(light);
-    onResolutionChanged();
-    return light;
+void LightManagerMap::onOccluderChanged(const sgl::AABB2 &region) {
+    staticLightCache.invalidateRegion(region);
 }
 
 void LightManagerMap::onResolutionChanged() {
-    sgl::Window *window = sgl::AppSettings::get()->getMainWindow();
-
-    sceneFBO = sgl::Renderer->createFBO();
-    if (multisampling) {
-        sceneRenderTex = sgl::TextureManager->createMultisampledTexture(
-                window->getWidth(), window->getHeight(), 8);
-    } else {
-        sceneRenderTex = sgl::TextureManager->createEmptyTexture(
-                window->getWidth(), window->getHeight());
-    }
-    sceneFBO->bindTexture(sceneRenderTex);
-    sceneTarget->bindFramebufferObject(sceneFBO);
-
-    lightFBO = sgl::Renderer->createFBO();
-    lightTex = sgl::TextureManager->createEmptyTexture(window->getWidth(), window->getHeight());
-    lightFBO->bindTexture(lightTex);
-    lightTarget->bindFramebufferObject(lightFBO);
-
-    // Create shadow map
-    sgl::TextureSettings settings(
-            sgl::TEXTURE_2D_ARRAY, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
-    settings.internalFormat = depthFormat;
-    sgl::TextureGL *texGL = new sgl::TextureGL(
-            createShadowmapTex(shadowMapWidth), shadowMapWidth, 1, 16, settings);
-    shadowmap = sgl::TexturePtr(texGL);
-    shadowmapFBO = sgl::Renderer->createFBO();
-    shadowmapFBO->bindTexture(shadowmap, sgl::DEPTH_ATTACHMENT);
-    shadowmapTarget->bindFramebufferObject(shadowmapFBO);
+    int width = getRenderWidth();
+    int height = getRenderHeight();
+
+    // The transient targets are created by the frame graph when the next frame is compiled
+    frameGraph.releaseTextures();
+    // The light format may have changed (e.g., in headless mode) without the GUI reloading the shaders
+    loadCombineShader();
+    numSceneSamples = getSupportedSampleCount(sceneSamples);
+    resolveShader = getResolveShader(numSceneSamples, false);
+    lightTex = sgl::TexturePtr();
+    staticLightCache.onResolutionChanged(
+            width, height, getLightFormatInternalFormat(getSupportedLightFormat(LightFormat(lightFormat))));
+    temporalAA.onResolutionChanged(width, height);
+    shadowmapRenderAttributes = sgl::ShaderAttributesPtr();
+    updateShadowmapRenderAttributes();
+}
 
+void LightManagerMap::updateShadowmapRenderAttributes() {
+    // The quad covers the view of the camera, which moves when the world is streamed
     sgl::AABB2 camRect = camera->getAABB2(0.0f);
+    if (shadowmapRenderAttributes && camRect.min == shadowmapRenderRect.min && camRect.max == shadowmapRenderRect.max) {
+        return;
+    }
+    shadowmapRenderRect = camRect;
+
+    // One pixel larger on each side, as the jitter shifts the rectangle by up to half a pixel
+    glm::vec2 pixelSize(camRect.getWidth() / float(getRenderWidth()), camRect.getHeight() / float(getRenderHeight()));
+    camRect.min -= pixelSize;
+    camRect.max += pixelSize;
     shadowmapRenderAttributes = createFullscreenQuadRenderData(shadowMapRenderShader, camRect);
 }
 
+void LightManagerMap::setupFrameGraph(bool renderScene) {
+    int width = getRenderWidth();
+    int height = getRenderHeight();
+    GLint lightInternalFormat = getLightFormatInternalFormat(getSupportedLightFormat(LightFormat(lightFormat)));
+    // The debug views only show either the scene or the light
+    bool showScene = renderScene && !sgl::Keyboard->isKeyDown(SDLK_d);
+    bool showLight = !renderScene || !sgl::Keyboard->isKeyDown(SDLK_s);
+
+    frameGraph.reset();
+    scenePass = resolvePass = taaPass = compositePass = FRAME_GRAPH_NONE;
+    if (renderScene) {
+        sceneRenderResource = frameGraph.createTexture(
+                "Scene", FrameGraphTextureDesc(width, height, GL_RGBA8, numSceneSamples > 1 ? numSceneSamples : 0));
+        frameGraph.setClearColor(sceneRenderResource, sgl::Color(242, 242, 242));
+        scenePass = frameGraph.addPass("Scene", {}, {sceneRenderResource});
+        sceneResource = sceneRenderResource;
+        if (numSceneSamples > 1) {
+            // The multisampled scene is dead after the resolve
+            sceneResource = frameGraph.createTexture("Scene (resolved)", FrameGraphTextureDesc(width, height));
+            resolvePass = frameGraph.addPass("Resolve Scene", {sceneRenderResource}, {sceneResource});
+        }
+    }
+
+    // The atlases of the ring are persistent. Their size is the one of the last frames.
+    std::vector<FrameGraphResource> atlasResources;
+    for (size_t i = 0; i < shadowAtlases.size(); i++) {
+        FrameGraphTextureDesc atlasDesc(shadowAtlases.at(i).getWidth(), shadowAtlases.at(i).getHeight(), depthFormat);
+        atlasDesc.numLayers = 3;
+        atlasResources.push_back(frameGraph.importTexture(
+                "Shadow Atlas " + sgl::toString(int(i)), shadowAtlases.at(i).getTexture(), atlasDesc));
+    }
+    shadowPass = frameGraph.addPass("Shadow Maps", {}, atlasResources);
+    FrameGraphResource cacheResource = frameGraph.importTexture(
+            "Static Light Cache", staticLightCache.getTexture(),
+            FrameGraphTextureDesc(width, height, lightInternalFormat));
+    lightResource = frameGraph.createTexture("Light", FrameGraphTextureDesc(width, height, lightInternalFormat));
+    frameGraph.setClearColor(lightResource, sgl::Color(0, 0, 0));
+    std::vector<FrameGraphResource> lightReads = atlasResources;
+    lightReads.push_back(cacheResource);
+    lightPass = frameGraph.addPass("Lights", lightReads, {lightResource});
+    lightOutputResource = lightResource;
+
+    // Baking renders independent tiles, which have no history
+    if (temporalAntialiasing && renderScene) {
+        FrameGraphResource previousHistoryResource = frameGraph.importTexture(
+                "TAA History (previous)", temporalAA.getPreviousHistoryTexture(), temporalAA.getHistoryDesc());
+        FrameGraphResource historyResource = frameGraph.importTexture(
+                "TAA History", temporalAA.getHistoryTexture(), temporalAA.getHistoryDesc());
+        taaPass = frameGraph.addPass("Temporal AA", {lightResource, previousHistoryResource}, {historyResource});
+        lightOutputResource = historyResource;
+    }
+
+    if (renderScene) {
+        std::vector<FrameGraphResource> compositeReads;
+        if (showScene) {
+            compositeReads.push_back(sceneResource);
+        }
+        if (showLight) {
+            compositeReads.push_back(lightOutputResource);
+        }
+        compositePass = frameGraph.addPass("Composite", compositeReads, {});
+    }
+    if (showLight) {
+        // Also read after the frame (getLightTexture)
+        frameGraph.markOutput(lightOutputResource);
+    }
+    frameGraph.compile();
+}
+
+bool LightManagerMap::isSceneNeeded() {
+    return !frameGraph.isPassCulled(scenePass);
+}
+
 void LightManagerMap::beginRenderScene() {
-    camera->setRenderTarget(sceneTarget);
-    sceneTarget->bindRenderTarget();
-    sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(242, 242, 242));
+    PROFILE_SCOPE("LightManagerMap::beginRenderScene");
+    setupFrameGraph(true);
+    sceneRendered = true;
+    if (frameGraph.beginPass(scenePass)) {
+        camera->setRenderTarget(frameGraph.getRenderTarget(sceneRenderResource));
+    }
 
     // Now render scene (user)
 }
 
 void LightManagerMap::endRenderScene() {
+    PROFILE_SCOPE("LightManagerMap::endRenderScene");
     sgl::Renderer->unbindFBO();
 
-    sceneTex = sgl::Renderer->resolveMultisampledTexture(sceneRenderTex);
-
-    /*TexturePtr texFXAA = TextureManager->createEmptyTexture(window->getWidth(), window->getHeight());
-    FramebufferObjectPtr fboFXAA = Renderer->createFBO();
-    fboFXAA->bindTexture(texFXAA);
-    Renderer->bindFBO(fboFXAA);
-    Renderer->blitTextureFXAAAntialiased(tex);
-    tex = texFXAA;*/
+    if (frameGraph.beginPass(resolvePass)) {
+        // Resolve with the variant specialized for the sample count, as the loop is unrolled at compile time
+        sgl::Renderer->setBlendMode(sgl::BLEND_OVERWRITE);
+        sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+        sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+        sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+        sgl::Renderer->blitTexture(frameGraph.getTexture(sceneRenderResource),
+                sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)), resolveShader);
+        sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
+        sgl::Renderer->setViewMatrix(camera->getViewMatrix());
+        sgl::Renderer->setProjectionMatrix(camera->getProjectionMatrix());
+    }
 
     sgl::Renderer->unbindFBO();
 }
 
 
 void LightManagerMap::renderLightmap(std::function<void()> renderfun) {
-    for (VolumeLightPtr &light : lights) {
-        sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
-        sgl::Renderer->setViewMatrix(camera->getViewMatrix());
-        sgl::Renderer->setProjectionMatrix(camera->getProjectionMatrix());
-        shadowmapTarget->bindRenderTarget();
-        sgl::Renderer->clearFramebuffer(GL_DEPTH_BUFFER_BIT, light->getColor(), 1.0f);
-        shadowmapShader->setUniform("lightpos", light->getPosition());
-        int matUniformLoc = shadowmapShader->getUniformLoc("camViewProjMatrices");
-        for (int i = 0; i < 3; ++i) {
-            shadowmapShader->setUniform(
-                    matUniformLoc+i,
-                    lightcamProj[i]*lightcamView[i]*sgl::matrixTranslation(-light->getPosition()));
-        }
-        /*shadowmapShader->bind();
-        glm::mat4 matrices[3];
-        for (int i = 0; i < 3; ++i) {
-            matrices[i] = lightcamProj[i]*lightcamView[i]*matrixTranslation(-light->getPosition());
-            //shadowmapShader->setUniform(matUniformLoc+i, lightcamProj[i]*lightcamView[i]*matrixTranslation(-light->getPosition()));
+    PROFILE_SCOPE("LightManagerMap::renderLightmap");
+    if (frameGraph.isPassCulled(lightPass)) {
+        return;
+    }
+    std::vector<VolumeLightPtr> &lights = getLights();
+    bool useBakedLightmap = bakedLightmap && bakedLightmap->matchesLights(lights);
+    bool renderStaticLights = !useBakedLightmap && !cacheStaticLights;
+    glm::mat4 viewProjMatrix = camera->getProjectionMatrix() * camera->getViewMatrix();
+    bool updateCache = !useBakedLightmap && cacheStaticLights && staticLightCache.needsUpdate(lights, viewProjMatrix);
+    // The cache only holds the static lights of the main view
+    bool viewsNeedStaticLights = !additionalViews.empty() && !useBakedLightmap && cacheStaticLights;
+    bakedLightmapUsed = useBakedLightmap;
+
+    // All shadow maps of the frame are rendered to the atlas first. The static lights are only needed if the cache
+    // is rebuilt or for the additional views and come first.
+    shadowLights.clear();
+    if (updateCache || viewsNeedStaticLights) {
+        for (VolumeLightPtr &light : lights) {
+            if (light->isStatic()) {
+                shadowLights.push_back(light.get());
+            }
         }
-        glUniformMatrix4fv(matUniformLoc, 3, false, (float*)&matrices);*/
+    }
+    size_t numStaticShadowLights = shadowLights.size();
+    for (VolumeLightPtr &light : getLightGroups(renderStaticLights, camera->getAABB2(0.0f))) {
+        shadowLights.push_back(light.get());
+    }
+    if (frameGraph.beginPass(shadowPass)) {
+        renderShadowAtlas(renderfun);
+    }
 
-        glDepthMask(GL_TRUE);
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LESS);
-        glViewport(0,0,shadowMapWidth,1);
-        renderfun();
-        glDisable(GL_DEPTH_TEST);
-        sgl::Window *window = sgl::AppSettings::get()->getMainWindow();
-        glViewport(0,0,window->getWidth(),window->getHeight());
+    // Binds and clears the light target
+    frameGraph.beginPass(lightPass);
+    sgl::RenderTargetPtr lightTarget = frameGraph.getRenderTarget(lightResource);
+    glm::mat4 projectionMatrix = getJitteredProjectionMatrix(camera->getProjectionMatrix());
+    if (useBakedLightmap) {
+        // Start with the baked static lights
+        lightTarget->bindRenderTarget();
+        bakedLightmap->render(camera);
+    } else if (cacheStaticLights) {
+        if (updateCache) {
+            staticLightCache.beginUpdate();
+            for (size_t i = 0; i < numStaticShadowLights; i++) {
+                renderLight(i, camera->getViewMatrix(), projectionMatrix, shadowmapRenderAttributes);
+            }
+            staticLightCache.endUpdate(lights, viewProjMatrix);
+        }
 
+        // Start with the accumulated static lights and only add the dynamic ones
         lightTarget->bindRenderTarget();
-        sgl::Renderer->setBlendMode(sgl::BLEND_ADDITIVE);
-        sgl::Renderer->setViewMatrix(camera->getViewMatrix());
-        sgl::Renderer->setProjectionMatrix(camera->getProjectionMatrix());
-        sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
-        shadowMapRenderShader->setUniform("lightpos", light->getPosition());
-        shadowMapRenderShader->setUniform("lightColor", light->getColor());
-        sgl::Renderer->render(shadowmapRenderAttributes);
+        staticLightCache.blitCachedLights();
+    } else {
+        lightTarget->bindRenderTarget();
+    }
+
+    for (size_t i = numStaticShadowLights; i < shadowLights.size(); i++) {
+        renderLight(i, camera->getViewMatrix(), projectionMatrix, shadowmapRenderAttributes);
     }
     sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
 }
 
+bool LightManagerMap::renderAdditionalViews(std::function<void(sgl::CameraPtr)> renderScene) {
+    PROFILE_SCOPE("LightManagerMap::renderAdditionalViews");
+    if (frameGraph.isPassCulled(lightPass)) {
+        return true;
+    }
+    GLint outputViewport[4];
+    glGetIntegerv(GL_VIEWPORT, outputViewport);
+    sgl::FramebufferObjectPtr outputFBO = sgl::Renderer->getFBO();
+    GLint lightInternalFormat = getLightFormatInternalFormat(getSupportedLightFormat(LightFormat(lightFormat)));
+
+    for (LightViewPtr &view : additionalViews) {
+        sgl::CameraPtr viewCamera = view->getCamera();
+        view->updateTargets(lightInternalFormat);
+        glViewport(0, 0, view->getWidth(), view->getHeight());
+
+        sgl::Renderer->bindFBO(view->getSceneFBO());
+        sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(242, 242, 242));
+        renderScene(viewCamera);
+
+        // The shadow atlas of the frame is shared, only the lights are shaded again for the pixels of the view
+        sgl::Renderer->bindFBO(view->getLightFBO());
+        sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(0, 0, 0));
+        if (bakedLightmapUsed) {
+            bakedLightmap->render(viewCamera);
+        }
+        sgl::ShaderAttributesPtr sceneQuad = view->getSceneQuad(shadowMapRenderShader);
+        for (size_t i = 0; i < shadowLights.size(); i++) {
+            renderLight(i, viewCamera->getViewMatrix(), viewCamera->getProjectionMatrix(), sceneQuad);
+        }
+        sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
+    }
+
+    if (outputFBO) {
+        sgl::Renderer->bindFBO(outputFBO);
+    } else {
+        sgl::Renderer->unbindFBO();
+    }
+    glViewport(outputViewport[0], outputViewport[1], outputViewport[2], outputViewport[3]);
+    sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+    for (LightViewPtr &view : additionalViews) {
+        lightCombineShader->setUniform("lightTexture", view->getLightTexture(), 1);
+        sgl::Renderer->blitTexture(view->getSceneTexture(), view->getScreenRect(), lightCombineShader);
+    }
+    return true;
+}
+
+int LightManagerMap::computeShadowMapWidth(VolumeLight *light) {
+    sgl::AABB2 camRect = camera->getAABB2(0.0f);
+    glm::vec2 lightPos = light->getPosition();
+    glm::vec2 corners[4] = {
+            camRect.min, glm::vec2(camRect.max.x, camRect.min.y), camRect.max, glm::vec2(camRect.min.x, camRect.max.y)
+    };
+    float maxDistance = 0.0f;
+    for (const glm::vec2 &corner : corners) {
+        maxDistance = std::max(maxDistance, glm::length(corner - lightPos));
+    }
+    maxDistance = std::min(maxDistance, attenuation ? light->getRadius() : LIGHT_FAR_PLANE_DIST);
+
+    // Angle covered by the visible part of the scene (at most the field of view of one light camera)
+    float angle = 2.0f * sgl::PI / 3.0f;
+    bool lightInView = lightPos.x >= camRect.min.x && lightPos.y >= camRect.min.y
+            && lightPos.x <= camRect.max.x && lightPos.y <= camRect.max.y;
+    if (!lightInView) {
+        glm::vec2 centerDir = (camRect.min + camRect.max) * 0.5f - lightPos;
+        float minAngle = 0.0f, maxAngle = 0.0f;
+        for (const glm::vec2 &corner : corners) {
+            glm::vec2 cornerDir = corner - lightPos;
+            float cornerAngle = atan2f(
+                    centerDir.x * cornerDir.y - centerDir.y * cornerDir.x, glm::dot(centerDir, cornerDir));
+            minAngle = std::min(minAngle, cornerAngle);
+            maxAngle = std::max(maxAngle, cornerAngle);
+        }
+        angle = std::min(angle, maxAngle - minAngle);
+    }
+
+    // About one texel per pixel at the farthest visible point
+    float pixelsPerUnit = float(getRenderWidth()) / camRect.getWidth();
+    float neededTexels = maxDistance * pixelsPerUnit * angle;
+    int width = 16;
+    while (float(width) < neededTexels && width < shadowMapWidth) {
+        width *= 2;
+    }
+    return std::min(width, shadowMapWidth);
+}
+
+void LightManagerMap::renderShadowAtlas(std::function<void()> &renderfun) {
+    PROFILE_SCOPE("LightManagerMap::renderShadowAtlas");
+    shadowMapWidths.clear();
+    for (VolumeLight *light : shadowLights) {
+        shadowMapWidths.push_back(computeShadowMapWidth(light));
+    }
+    // Each frame uses the next atlas of the ring. Clearing and rendering the atlas then doesn't need to wait for
+    // the composite passes of the previous frames still reading from theirs.
+    if (shadowAtlases.size() != size_t(shadowAtlasRingSize)) {
+        shadowAtlases.resize(shadowAtlasRingSize);
+    }
+    currentAtlasIndex = (currentAtlasIndex + 1) % shadowAtlases.size();
+    ShadowAtlas &shadowAtlas = shadowAtlases.at(currentAtlasIndex);
+    shadowAtlas.pack(shadowMapWidths, shadowMapWidth, depthFormat);
+    if (shadowLights.empty()) {
+        return;
+    }
+
+    sgl::Renderer->setViewMatrix(camera->getViewMatrix());
+    sgl::Renderer->setProjectionMatrix(camera->getProjectionMatrix());
+    shadowAtlas.getRenderTarget()->bindRenderTarget();
+    glDepthMask(GL_TRUE);
+    sgl::Renderer->clearFramebuffer(GL_DEPTH_BUFFER_BIT, sgl::Color(0, 0, 0), 1.0f);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+
+    // The edges are rendered once per batch of lights instead of once per light
+    int lightPositionsLoc = shadowmapShader->getUniformLoc("lightPositions");
+    shadowPassViewRect = camera->getAABB2(0.0f);
+    for (size_t batchStart = 0; batchStart < shadowLights.size(); batchStart += maxLightsPerPass) {
+        int numBatchLights = int(std::min(shadowLights.size() - batchStart, size_t(maxLightsPerPass)));
+        shadowPassLights.clear();
+        for (int i = 0; i < numBatchLights; i++) {
+            const ShadowAtlasRegion &region = shadowAtlas.getRegion(batchStart + i);
+            glViewportIndexedf(GLuint(i), float(region.x), float(region.row), float(region.width), 1.0f);
+            shadowmapShader->setUniform(lightPositionsLoc + i, shadowLights.at(batchStart + i)->getPosition());
+            shadowPassLights.push_back(shadowLights.at(batchStart + i)->getPosition());
+        }
+        shadowmapShader->setUniform("numLights", numBatchLights);
+        renderfun();
+    }
+    shadowPassLights.clear();
+
+    glDisable(GL_DEPTH_TEST);
+    glViewport(0, 0, getRenderWidth(), getRenderHeight());
+}
+
+void LightManagerMap::renderLight(size_t shadowLightIndex, const glm::mat4 &viewMatrix,
+        const glm::mat4 &projectionMatrix, sgl::ShaderAttributesPtr &sceneQuad) {
+    VolumeLight *light = shadowLights.at(shadowLightIndex);
+    ShadowAtlas &shadowAtlas = shadowAtlases.at(currentAtlasIndex);
+    const ShadowAtlasRegion &region = shadowAtlas.getRegion(shadowLightIndex);
+    sgl::Renderer->setBlendMode(sgl::BLEND_ADDITIVE);
+    sgl::Renderer->setViewMatrix(viewMatrix);
+    sgl::Renderer->setProjectionMatrix(projectionMatrix);
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+    shadowMapRenderShader->setUniform("depthMap", shadowAtlas.getTexture(), 0);
+    shadowMapRenderShader->setUniform(
+            "atlasSize", glm::vec2(float(shadowAtlas.getWidth()), float(shadowAtlas.getHeight())));
+    shadowMapRenderShader->setUniform(
+            "atlasRegion", glm::vec3(float(region.x), float(region.width), float(region.row)));
+    shadowMapRenderShader->setUniform("lightpos", light->getPosition());
+    shadowMapRenderShader->setUniform("lightColor", light->getColor());
+    if (attenuation) {
+        shadowMapRenderShader->setUniform("lightRadius", light->getRadius());
+    }
+    sgl::Renderer->render(sceneQuad);
+}
+
 void LightManagerMap::beginRenderLightmap() {
-    camera->setRenderTarget(lightTarget);
-    lightTarget->bindRenderTarget();
-    sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(0, 0, 0));
+    PROFILE_SCOPE("LightManagerMap::beginRenderLightmap");
+    if (!sceneRendered) {
+        // Only the light is rendered (e.g., when baking)
+        setupFrameGraph(false);
+    }
+    sgl::RenderTargetPtr lightTarget = frameGraph.getRenderTarget(lightResource);
+    if (lightTarget) {
+        camera->setRenderTarget(lightTarget);
+    }
+    projectionJitter = frameGraph.isPassCulled(taaPass) ? glm::vec2(0.0f) : temporalAA.getJitter();
+    updateShadowmapRenderAttributes();
 }
 
 void LightManagerMap::endRenderLightmap() {
+    PROFILE_SCOPE("LightManagerMap::endRenderLightmap");
     sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
     sgl::Renderer->unbindFBO();
+    projectionJitter = glm::vec2(0.0f);
+    if (frameGraph.beginPass(taaPass)) {
+        temporalAA.resolve(frameGraph.getTexture(lightResource),
+                camera->getProjectionMatrix() * camera->getViewMatrix());
+    } else {
+        // The history is outdated once a frame is skipped
+        temporalAA.invalidate();
+    }
+    if (!frameGraph.isPassCulled(lightPass)) {
+        lightTex = frameGraph.getTexture(lightOutputResource);
+    }
+    sceneRendered = false;
 }
 
 void LightManagerMap::blitMixSceneAndLights() {
+    PROFILE_SCOPE("LightManagerMap::blitMixSceneAndLights");
+    frameGraph.beginPass(compositePass);
     sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
     sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
     sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
 
     if (sgl::Keyboard->isKeyDown(SDLK_s)) {
         sgl::Renderer->blitTexture(
-                sceneTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
+                frameGraph.getTexture(sceneResource), sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
     } else if (sgl::Keyboard->isKeyDown(SDLK_d)) {
         sgl::Renderer->blitTexture(
                 lightTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
     } else {
         lightCombineShader->setUniform("lightTexture", lightTex, 1);
         sgl::Renderer->blitTexture(
-                sceneTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)), lightCombineShader);
+                frameGraph.getTexture(sceneResource), sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)),
+                lightCombineShader);
     }
 }
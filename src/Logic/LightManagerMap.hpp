@@ -34,6 +34,10 @@
 #define LOGIC_VOLUMELIGHT_LIGHTMANAGER2_HPP_
 
 #include "LightManagerInterface.hpp"
+#include "StaticLightCache.hpp"
+#include "ShadowAtlas.hpp"
+#include "TemporalAA.hpp"
+#include "Utils/FrameGraph.hpp"
 
 class LightManagerMap : public LightManagerInterface
 {
@@ -47,35 +51,65 @@ public:
     void blitMixSceneAndLights();
     void renderGUI();
 
-    VolumeLightPtr addLight(
-            const glm::vec2 &pos, float rad = 10.0f, const sgl::Color &col = sgl::Color(255, 255, 255));
-    std::vector<VolumeLightPtr> &getLights() { return lights; }
-
+    void onOccluderChanged(const sgl::AABB2 &region);
     void onResolutionChanged();
     sgl::ShaderProgramPtr getEdgeShader() { return shadowmapShader; }
+    sgl::TexturePtr getLightTexture() { return lightTex; }
+    bool isSceneNeeded();
+    FrameGraph *getFrameGraph() { return &frameGraph; }
+    int getLightBytesPerPixel();
+    bool renderAdditionalViews(std::function<void(sgl::CameraPtr)> renderScene);
+    // Number of shadow atlases used in turn by consecutive frames (shared by all instances, like the GUI settings)
+    static void setShadowAtlasRingSize(int ringSize);
+    static void setMultisampling(int numSamples);
+    static void setTemporalAA(bool enabled);
+    static void setLightFormat(LightFormat format);
 
 private:
+    // Declares the passes of the frame. Without the scene (e.g., when baking), only the light is rendered.
+    void setupFrameGraph(bool renderScene);
+    // Fetches the shader variants specialized for the current settings
+    void loadShaders();
+    void loadCombineShader();
+    // Number of texels needed by the shadow map of the light, depending on how much of the visible scene it covers
+    int computeShadowMapWidth(VolumeLight *light);
+    // Renders the shadow maps of all lights in shadowLights to the atlas
+    void renderShadowAtlas(std::function<void()> &renderfun);
+    // Adds the contribution of the light with the passed index in shadowLights to the bound target (sceneQuad covers
+    // the part of the scene seen by the passed matrices)
+    void renderLight(size_t shadowLightIndex, const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix,
+            sgl::ShaderAttributesPtr &sceneQuad);
+
     sgl::CameraPtr camera;
-    std::vector<VolumeLightPtr> lights;
     sgl::ShaderProgramPtr plainShader;
     sgl::ShaderProgramPtr shadowmapShader;
     sgl::ShaderProgramPtr shadowMapRenderShader;
     sgl::ShaderProgramPtr lightCombineShader;
+    sgl::ShaderProgramPtr resolveShader; // Specialized for numSceneSamples
+    int numSceneSamples = 1;
 
+    void updateShadowmapRenderAttributes();
     sgl::ShaderAttributesPtr shadowmapRenderAttributes;
+    sgl::AABB2 shadowmapRenderRect;
     glm::mat4 lightcamProj[3];
     glm::mat4 lightcamView[3];
 
-    sgl::RenderTargetPtr sceneTarget;
-    sgl::FramebufferObjectPtr sceneFBO;
-    sgl::TexturePtr sceneTex;
-    sgl::TexturePtr sceneRenderTex; // Equal to sceneTex if no MSAA is used
-    sgl::RenderTargetPtr lightTarget;
-    sgl::FramebufferObjectPtr lightFBO;
-    sgl::TexturePtr lightTex;
-    sgl::RenderTargetPtr shadowmapTarget;
-    sgl::FramebufferObjectPtr shadowmapFBO;
-    sgl::TexturePtr shadowmap;
+    // The scene and light targets are transient resources of the frame graph
+    FrameGraph frameGraph;
+    bool sceneRendered = false; // beginRenderScene was called in the current frame
+    FrameGraphResource sceneRenderResource = FRAME_GRAPH_NONE, sceneResource = FRAME_GRAPH_NONE; // Equal without MSAA
+    FrameGraphResource lightResource = FRAME_GRAPH_NONE, lightOutputResource = FRAME_GRAPH_NONE;
+    FrameGraphPass scenePass = FRAME_GRAPH_NONE, resolvePass = FRAME_GRAPH_NONE, shadowPass = FRAME_GRAPH_NONE;
+    FrameGraphPass lightPass = FRAME_GRAPH_NONE, taaPass = FRAME_GRAPH_NONE, compositePass = FRAME_GRAPH_NONE;
+    sgl::TexturePtr lightTex; // The accumulated light (kept after the frame)
+    std::vector<ShadowAtlas> shadowAtlases;
+    size_t currentAtlasIndex = 0;
+    int maxLightsPerPass;
+    std::vector<VolumeLight*> shadowLights; // The lights rendered in the current frame
+    bool bakedLightmapUsed = false; // In the current frame
+    std::vector<int> shadowMapWidths;
+    StaticLightCache staticLightCache;
+    TemporalAA temporalAA;
 };
 
 
@@ -0,0 +1,238 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <GL/glew.h>
+
+#include <Graphics/Renderer.hpp>
+#include <Graphics/Shader/ShaderManager.hpp>
+#include <Graphics/Texture/TextureManager.hpp>
+#include <Input/Keyboard.hpp>
+#include <Math/Geometry/MatrixUtil.hpp>
+#include <ImGui/ImGuiWrapper.hpp>
+
+#include "Utils/Profiler.hpp"
+#include "Utils/ShaderCache.hpp"
+#include "Arc.hpp"
+#include "LightManagerRadianceCascades.hpp"
+
+LightManagerRadianceCascades::LightManagerRadianceCascades(sgl::CameraPtr _camera) {
+    camera = _camera;
+    sceneTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
+    lightTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
+    lightCombineShader = ShaderCache::get()->getShaderProgram(
+            {"LightMix.Vertex", "LightMix.Fragment"});
+    lightCombineShader->setUniform("ambientLight", sgl::Color(50, 50, 50));
+    plainShader = ShaderCache::get()->getShaderProgram({"Mesh.Vertex.Plain", "Mesh.Fragment.Plain"});
+    cascadeShader = ShaderCache::get()->getShaderProgram(
+            {"RadianceCascades.Vertex", "RadianceCascades.Fragment.Cascade"});
+    fluenceShader = ShaderCache::get()->getShaderProgram(
+            {"RadianceCascades.Vertex", "RadianceCascades.Fragment.Fluence"});
+    // Only needed for the edge geometry of the primitives
+    edgeShader = ShaderCache::get()->getShaderProgram(
+            {"VolumeLight.Vertex", "VolumeLight.Geometry", "VolumeLight.Fragment"});
+    onResolutionChanged();
+}
+
+static float lightDiscRadius = 0.01f;
+static float baseInterval = 1.0f;
+static float intensity = 4.0f;
+
+void LightManagerRadianceCascades::renderGUI() {
+    ImGui::Separator();
+
+    ImGui::SliderFloat("Light Radius", &lightDiscRadius, 0.002f, 0.05f);
+    ImGui::SliderFloat("Intensity", &intensity, 0.5f, 32.0f);
+    if (ImGui::SliderFloat("Base Interval", &baseInterval, 0.5f, 8.0f)) {
+        onResolutionChanged();
+    }
+    ImGui::Text("Cascades: %d", numCascades);
+}
+
+
+void LightManagerRadianceCascades::onResolutionChanged() {
+    width = getRenderWidth();
+    height = getRenderHeight();
+
+    sceneFBO = sgl::Renderer->createFBO();
+    sceneTex = sgl::TextureManager->createEmptyTexture(width, height);
+    sceneFBO->bindTexture(sceneTex);
+    sceneTarget->bindFramebufferObject(sceneFBO);
+
+    lightFBO = sgl::Renderer->createFBO();
+    lightTex = sgl::TextureManager->createEmptyTexture(width, height);
+    lightFBO->bindTexture(lightTex);
+    lightTarget->bindFramebufferObject(lightFBO);
+
+    emissionFBO = sgl::Renderer->createFBO();
+    emissionTex = sgl::TextureManager->createEmptyTexture(width, height);
+    emissionFBO->bindTexture(emissionTex);
+    distanceField.onResolutionChanged(width, height);
+
+    // The rays of the top cascade need to reach across the whole screen: l0 * (4^n - 1) / 3 >= diagonal
+    float diagonal = std::sqrt(float(width * width + height * height));
+    numCascades = 1;
+    while (baseInterval * (std::pow(4.0f, float(numCascades)) - 1.0f) / 3.0f < diagonal) {
+        numCascades++;
+    }
+    int topProbeSpacing = 2 << (numCascades - 1);
+    cascadeWidth = (width + topProbeSpacing - 1) / topProbeSpacing * topProbeSpacing;
+    cascadeHeight = (height + topProbeSpacing - 1) / topProbeSpacing * topProbeSpacing;
+
+    sgl::TextureSettings cascadeSettings(
+            sgl::TEXTURE_2D, GL_NEAREST, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+    cascadeSettings.internalFormat = GL_RGBA16F;
+    cascadeSettings.pixelFormat = GL_RGBA;
+    cascadeSettings.pixelType = GL_FLOAT;
+    for (int i = 0; i < 2; i++) {
+        cascadeFBOs[i] = sgl::Renderer->createFBO();
+        cascadeTextures[i] = sgl::TextureManager->createEmptyTexture(cascadeWidth, cascadeHeight, cascadeSettings);
+        cascadeFBOs[i]->bindTexture(cascadeTextures[i]);
+    }
+}
+
+void LightManagerRadianceCascades::beginRenderScene() {
+    PROFILE_SCOPE("LightManagerRadianceCascades::beginRenderScene");
+    camera->setRenderTarget(sceneTarget);
+    sceneTarget->bindRenderTarget();
+    sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(242, 242, 242));
+
+    // Now render scene (user)
+}
+
+void LightManagerRadianceCascades::endRenderScene() {
+    PROFILE_SCOPE("LightManagerRadianceCascades::endRenderScene");
+    sgl::Renderer->unbindFBO();
+}
+
+void LightManagerRadianceCascades::beginRenderLightmap() {
+    PROFILE_SCOPE("LightManagerRadianceCascades::beginRenderLightmap");
+    camera->setRenderTarget(lightTarget);
+}
+
+void LightManagerRadianceCascades::updateLightDisc() {
+    if (lightDiscData && lightDiscDataRadius == lightDiscRadius) {
+        return;
+    }
+    std::vector<glm::vec2> vertices;
+    getPointsOnCircle(vertices, glm::vec2(0.0f, 0.0f), lightDiscRadius, 32);
+    lightDiscData = sgl::ShaderManager->createShaderAttributes(plainShader);
+    sgl::GeometryBufferPtr geometryBuffer = sgl::Renderer->createGeometryBuffer(
+            sizeof(glm::vec2)*vertices.size(), &vertices.front());
+    lightDiscData->addGeometryBuffer(geometryBuffer, "vertexPosition", sgl::ATTRIB_FLOAT, 2);
+    lightDiscData->setVertexMode(sgl::VERTEX_MODE_TRIANGLE_FAN);
+    lightDiscDataRadius = lightDiscRadius;
+}
+
+void LightManagerRadianceCascades::renderEmission() {
+    updateLightDisc();
+
+    sgl::Renderer->bindFBO(emissionFBO);
+    glViewport(0, 0, width, height);
+    sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(0, 0, 0, 0));
+    sgl::Renderer->setBlendMode(sgl::BLEND_OVERWRITE);
+    sgl::Renderer->setProjectionMatrix(camera->getProjectionMatrix());
+    sgl::Renderer->setViewMatrix(camera->getViewMatrix());
+    for (PrimitivePtr &occluder : occluders) {
+        occluder->renderFilled(occluder->getEmission());
+    }
+    for (VolumeLightPtr &light : getLights()) {
+        sgl::Renderer->setModelMatrix(sgl::matrixTranslation(light->getPosition()));
+        plainShader->setUniform("color", light->getColor());
+        sgl::Renderer->render(lightDiscData);
+    }
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+}
+
+void LightManagerRadianceCascades::renderLightmap(std::function<void()> renderfun) {
+    PROFILE_SCOPE("LightManagerRadianceCascades::renderLightmap");
+    renderEmission();
+    float worldPerPixel = camera->getAABB2(0.0f).getWidth() / float(width);
+    distanceField.build(emissionTex, worldPerPixel);
+
+    sgl::Renderer->setBlendMode(sgl::BLEND_OVERWRITE);
+    sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+    sgl::AABB2 fullscreenRect(glm::vec2(-1, -1), glm::vec2(1, 1));
+
+    // Evaluate the cascades from the top (longest rays) to the bottom
+    cascadeShader->setUniform("emissionTexture", emissionTex, 1);
+    cascadeShader->setUniform("renderSize", glm::vec2(width, height));
+    cascadeShader->setUniform("worldPerPixel", worldPerPixel);
+    cascadeShader->setUniform("baseInterval", baseInterval);
+    glViewport(0, 0, cascadeWidth, cascadeHeight);
+    int currentIdx = 0;
+    for (int cascadeIdx = numCascades - 1; cascadeIdx >= 0; cascadeIdx--) {
+        bool hasUpperCascade = cascadeIdx != numCascades - 1;
+        sgl::Renderer->bindFBO(cascadeFBOs[currentIdx]);
+        cascadeShader->setUniform("cascadeIndex", cascadeIdx);
+        cascadeShader->setUniform("hasUpperCascade", hasUpperCascade);
+        if (hasUpperCascade) {
+            cascadeShader->setUniform("upperCascadeTexture", cascadeTextures[1 - currentIdx], 2);
+        }
+        sgl::Renderer->blitTexture(distanceField.getTexture(), fullscreenRect, cascadeShader);
+        currentIdx = 1 - currentIdx;
+    }
+
+    // The incoming light of every pixel from cascade 0
+    lightTarget->bindRenderTarget();
+    glViewport(0, 0, width, height);
+    fluenceShader->setUniform("intensity", intensity);
+    sgl::Renderer->blitTexture(cascadeTextures[1 - currentIdx], fullscreenRect, fluenceShader);
+    sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
+}
+
+void LightManagerRadianceCascades::endRenderLightmap() {
+    PROFILE_SCOPE("LightManagerRadianceCascades::endRenderLightmap");
+    sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
+    sgl::Renderer->unbindFBO();
+}
+
+void LightManagerRadianceCascades::blitMixSceneAndLights() {
+    PROFILE_SCOPE("LightManagerRadianceCascades::blitMixSceneAndLights");
+    sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+
+    if (sgl::Keyboard->isKeyDown(SDLK_s)) {
+        sgl::Renderer->blitTexture(
+                sceneTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
+    } else if (sgl::Keyboard->isKeyDown(SDLK_d)) {
+        sgl::Renderer->blitTexture(
+                lightTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
+    } else {
+        lightCombineShader->setUniform("lightTexture", lightTex, 1);
+        sgl::Renderer->blitTexture(
+                sceneTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)), lightCombineShader);
+    }
+}
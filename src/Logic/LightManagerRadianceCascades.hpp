@@ -0,0 +1,97 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOGIC_VOLUMELIGHT_LIGHTMANAGERRADIANCECASCADES_HPP_
+#define LOGIC_VOLUMELIGHT_LIGHTMANAGERRADIANCECASCADES_HPP_
+
+#include "LightManagerInterface.hpp"
+#include "DistanceField.hpp"
+
+/**
+ * 2D global illumination with radiance cascades. Lights (as small discs) and emissive occluders are rendered into an
+ * emission texture, and rays are traced through its distance field in a hierarchy of probe grids: Each cascade has
+ * half the probe density, four times the directions and four times the ray length of the one below. Merging the
+ * cascades from top to bottom gives the incoming light of every pixel, including bounce light from emitters.
+ * The cost only depends on the resolution and the number of cascades, not on the number of lights.
+ */
+class LightManagerRadianceCascades : public LightManagerInterface {
+public:
+    LightManagerRadianceCascades(sgl::CameraPtr _camera);
+    void beginRenderScene();
+    void endRenderScene();
+    void beginRenderLightmap();
+    void renderLightmap(std::function<void()> renderfun); // renderfun is unused, the occluders are used directly
+    void endRenderLightmap();
+    void blitMixSceneAndLights();
+    void renderGUI();
+
+    void onOccluderChanged(const sgl::AABB2 &region) {}
+    void onResolutionChanged();
+    sgl::ShaderProgramPtr getEdgeShader() { return edgeShader; }
+    sgl::TexturePtr getLightTexture() { return lightTex; }
+
+private:
+    void renderEmission();
+    void updateLightDisc();
+
+    sgl::CameraPtr camera;
+    sgl::ShaderProgramPtr edgeShader;
+    sgl::ShaderProgramPtr plainShader;
+    sgl::ShaderProgramPtr cascadeShader;
+    sgl::ShaderProgramPtr fluenceShader;
+    sgl::ShaderProgramPtr lightCombineShader;
+    sgl::ShaderAttributesPtr lightDiscData;
+    float lightDiscDataRadius = 0.0f;
+
+    sgl::RenderTargetPtr sceneTarget;
+    sgl::FramebufferObjectPtr sceneFBO;
+    sgl::TexturePtr sceneTex;
+    sgl::RenderTargetPtr lightTarget;
+    sgl::FramebufferObjectPtr lightFBO;
+    sgl::TexturePtr lightTex;
+
+    // rgb: Emitted light, a: Occluder or emitter
+    sgl::FramebufferObjectPtr emissionFBO;
+    sgl::TexturePtr emissionTex;
+    DistanceField distanceField;
+
+    // Ping-pong targets for the cascades. Their size is a multiple of the probe spacing of the top cascade.
+    sgl::FramebufferObjectPtr cascadeFBOs[2];
+    sgl::TexturePtr cascadeTextures[2];
+    int numCascades = 0;
+    int cascadeWidth = 0, cascadeHeight = 0;
+    int width = 0, height = 0;
+};
+
+
+
+#endif /* LOGIC_VOLUMELIGHT_LIGHTMANAGERRADIANCECASCADES_HPP_ */
@@ -0,0 +1,261 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Graphics/Renderer.hpp>
+#include <Graphics/Shader/ShaderManager.hpp>
+#include <Graphics/Texture/TextureManager.hpp>
+#include <Input/Keyboard.hpp>
+#include <Math/Geometry/MatrixUtil.hpp>
+#include <ImGui/ImGuiWrapper.hpp>
+
+#include "Utils/Profiler.hpp"
+#include "Utils/ShaderCache.hpp"
+#include "LightManagerSDF.hpp"
+
+LightManagerSDF::LightManagerSDF(sgl::CameraPtr _camera) {
+    camera = _camera;
+    sceneTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
+    lightTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
+    lightCombineShader = ShaderCache::get()->getShaderProgram(
+            {"LightMix.Vertex", "LightMix.Fragment"});
+    lightCombineShader->setUniform("ambientLight", sgl::Color(50, 50, 50));
+    loadShaders();
+    // Only needed for the edge geometry of the primitives, the shadows are computed from the distance field
+    edgeShader = ShaderCache::get()->getShaderProgram(
+            {"VolumeLight.Vertex", "VolumeLight.Geometry", "VolumeLight.Fragment"});
+    glGenBuffers(1, &lightBuffer);
+    onResolutionChanged();
+}
+
+LightManagerSDF::~LightManagerSDF() {
+    glDeleteBuffers(1, &lightBuffer);
+}
+
+static bool cacheStaticLights = true;
+static float softness = 16.0f;
+static bool attenuation = false;
+
+void LightManagerSDF::loadShaders() {
+    ShaderDefines defines;
+    if (attenuation) {
+        defines["LIGHT_ATTENUATION"] = "";
+    }
+    lightingShader = ShaderCache::get()->getShaderProgram(
+            {"SDFShadows.Vertex", "SDFShadows.Fragment.Lighting"}, defines);
+}
+
+void LightManagerSDF::renderGUI() {
+    ImGui::Separator();
+
+    if (ImGui::Checkbox("Cache Static Lights", &cacheStaticLights)) {
+        staticLightCache.invalidate();
+    }
+    if (ImGui::SliderFloat("Shadow Sharpness", &softness, 1.0f, 128.0f)) {
+        staticLightCache.invalidate();
+    }
+    if (ImGui::Checkbox("Attenuation", &attenuation)) {
+        loadShaders();
+        staticLightCache.invalidate();
+    }
+}
+
+
+void LightManagerSDF::onOccluderChanged(const sgl::AABB2 &region) {
+    distanceFieldValid = false;
+    staticLightCache.invalidateRegion(region);
+}
+
+void LightManagerSDF::onResolutionChanged() {
+    width = getRenderWidth();
+    height = getRenderHeight();
+
+    sceneFBO = sgl::Renderer->createFBO();
+    sceneTex = sgl::TextureManager->createEmptyTexture(width, height);
+    sceneFBO->bindTexture(sceneTex);
+    sceneTarget->bindFramebufferObject(sceneFBO);
+
+    lightFBO = sgl::Renderer->createFBO();
+    lightTex = sgl::TextureManager->createEmptyTexture(width, height);
+    lightFBO->bindTexture(lightTex);
+    lightTarget->bindFramebufferObject(lightFBO);
+
+    maskFBO = sgl::Renderer->createFBO();
+    maskTex = sgl::TextureManager->createEmptyTexture(width, height);
+    maskFBO->bindTexture(maskTex);
+
+    distanceField.onResolutionChanged(width, height);
+    distanceFieldValid = false;
+
+    staticLightCache.onResolutionChanged(width, height);
+}
+
+void LightManagerSDF::beginRenderScene() {
+    PROFILE_SCOPE("LightManagerSDF::beginRenderScene");
+    camera->setRenderTarget(sceneTarget);
+    sceneTarget->bindRenderTarget();
+    sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(242, 242, 242));
+
+    // Now render scene (user)
+}
+
+void LightManagerSDF::endRenderScene() {
+    PROFILE_SCOPE("LightManagerSDF::endRenderScene");
+    sgl::Renderer->unbindFBO();
+}
+
+void LightManagerSDF::beginRenderLightmap() {
+    PROFILE_SCOPE("LightManagerSDF::beginRenderLightmap");
+    camera->setRenderTarget(lightTarget);
+}
+
+void LightManagerSDF::updateDistanceField() {
+    glm::mat4 viewProjMatrix = camera->getProjectionMatrix() * camera->getViewMatrix();
+    if (distanceFieldValid && viewProjMatrix == distanceFieldViewProjMatrix) {
+        return;
+    }
+    PROFILE_SCOPE("LightManagerSDF::updateDistanceField");
+
+    // Occluder mask: Alpha is one inside of the occluders
+    sgl::Renderer->bindFBO(maskFBO);
+    glViewport(0, 0, width, height);
+    sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(0, 0, 0, 0));
+    sgl::Renderer->setBlendMode(sgl::BLEND_OVERWRITE);
+    sgl::Renderer->setProjectionMatrix(camera->getProjectionMatrix());
+    sgl::Renderer->setViewMatrix(camera->getViewMatrix());
+    for (PrimitivePtr &occluder : occluders) {
+        occluder->render();
+    }
+
+    distanceField.build(maskTex, camera->getAABB2(0.0f).getWidth() / float(width));
+    distanceFieldValid = true;
+    distanceFieldViewProjMatrix = viewProjMatrix;
+}
+
+void LightManagerSDF::drawLights(const std::vector<VolumeLight*> &drawnLights) {
+    if (drawnLights.empty()) {
+        return;
+    }
+
+    lightData.clear();
+    for (VolumeLight *light : drawnLights) {
+        sgl::Color color = light->getColor();
+        LightData data;
+        data.position = light->getPosition();
+        data.radius = light->getRadius();
+        data.padding = 0.0f;
+        data.color = glm::vec4(color.getFloatR(), color.getFloatG(), color.getFloatB(), color.getFloatA());
+        lightData.push_back(data);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, lightData.size() * sizeof(LightData), &lightData.front(), GL_STREAM_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, lightBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    sgl::AABB2 camRect = camera->getAABB2(0.0f);
+    lightingShader->setUniform("numLights", int(drawnLights.size()));
+    lightingShader->setUniform("worldMin", camRect.min);
+    lightingShader->setUniform("worldSize", camRect.max - camRect.min);
+    lightingShader->setUniform("worldPerPixel", camRect.getWidth() / float(width));
+    lightingShader->setUniform("softness", softness);
+
+    sgl::Renderer->setBlendMode(sgl::BLEND_ADDITIVE);
+    sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+    sgl::Renderer->blitTexture(
+            distanceField.getTexture(), sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)), lightingShader);
+}
+
+void LightManagerSDF::renderLightmap(std::function<void()> renderfun) {
+    PROFILE_SCOPE("LightManagerSDF::renderLightmap");
+    updateDistanceField();
+
+    bool useBakedLightmap = bakedLightmap && bakedLightmap->matchesLights(getLights());
+    bool renderStaticLights = !useBakedLightmap && !cacheStaticLights;
+    std::vector<VolumeLight*> staticLights, directLights;
+    for (VolumeLightPtr &light : getLights()) {
+        if (!light->isStatic() || renderStaticLights) {
+            directLights.push_back(light.get());
+        } else {
+            staticLights.push_back(light.get());
+        }
+    }
+
+    if (useBakedLightmap) {
+        // Start with the baked static lights
+        lightTarget->bindRenderTarget();
+        sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(0, 0, 0));
+        bakedLightmap->render(camera);
+    } else if (cacheStaticLights) {
+        glm::mat4 viewProjMatrix = camera->getProjectionMatrix() * camera->getViewMatrix();
+        if (staticLightCache.needsUpdate(getLights(), viewProjMatrix)) {
+            staticLightCache.beginUpdate();
+            drawLights(staticLights);
+            staticLightCache.endUpdate(getLights(), viewProjMatrix);
+        }
+
+        // Start with the accumulated static lights and only add the dynamic ones
+        lightTarget->bindRenderTarget();
+        staticLightCache.blitCachedLights();
+    } else {
+        lightTarget->bindRenderTarget();
+        sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(0, 0, 0));
+    }
+
+    drawLights(directLights);
+    sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
+}
+
+void LightManagerSDF::endRenderLightmap() {
+    PROFILE_SCOPE("LightManagerSDF::endRenderLightmap");
+    sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
+    sgl::Renderer->unbindFBO();
+}
+
+void LightManagerSDF::blitMixSceneAndLights() {
+    PROFILE_SCOPE("LightManagerSDF::blitMixSceneAndLights");
+    sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+
+    if (sgl::Keyboard->isKeyDown(SDLK_s)) {
+        sgl::Renderer->blitTexture(
+                sceneTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
+    } else if (sgl::Keyboard->isKeyDown(SDLK_d)) {
+        sgl::Renderer->blitTexture(
+                lightTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
+    } else {
+        lightCombineShader->setUniform("lightTexture", lightTex, 1);
+        sgl::Renderer->blitTexture(
+                sceneTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)), lightCombineShader);
+    }
+}
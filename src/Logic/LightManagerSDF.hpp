@@ -0,0 +1,108 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOGIC_VOLUMELIGHT_LIGHTMANAGERSDF_HPP_
+#define LOGIC_VOLUMELIGHT_LIGHTMANAGERSDF_HPP_
+
+#include <GL/glew.h>
+#include "LightManagerInterface.hpp"
+#include "StaticLightCache.hpp"
+#include "DistanceField.hpp"
+
+/**
+ * Shadows from a signed distance field of the occluders. The field is only rebuilt with jump flooding if an occluder
+ * or the camera changed. All lights are then shaded in one full-screen pass that sphere-traces from every pixel
+ * towards every light, which also gives soft penumbrae. The cost depends on pixels x lights x steps, but not on the
+ * number of edges.
+ */
+class LightManagerSDF : public LightManagerInterface {
+public:
+    LightManagerSDF(sgl::CameraPtr _camera);
+    ~LightManagerSDF();
+    void beginRenderScene();
+    void endRenderScene();
+    void beginRenderLightmap();
+    void renderLightmap(std::function<void()> renderfun); // renderfun is unused, the occluders are used directly
+    void endRenderLightmap();
+    void blitMixSceneAndLights();
+    void renderGUI();
+
+    void onOccluderChanged(const sgl::AABB2 &region);
+    void onResolutionChanged();
+    sgl::ShaderProgramPtr getEdgeShader() { return edgeShader; }
+    sgl::TexturePtr getLightTexture() { return lightTex; }
+
+    // Signed distance to the closest occluder in world units (negative inside)
+    sgl::TexturePtr getDistanceTexture() { return distanceField.getTexture(); }
+    // Rebuilds the distance field if it is outdated
+    void updateDistanceField();
+
+private:
+    struct LightData {
+        glm::vec2 position;
+        float radius;
+        float padding;
+        glm::vec4 color;
+    };
+    // Fetches the shader variants specialized for the current settings
+    void loadShaders();
+    // Adds the passed lights to the currently bound render target in one full-screen pass
+    void drawLights(const std::vector<VolumeLight*> &drawnLights);
+
+    sgl::CameraPtr camera;
+    sgl::ShaderProgramPtr edgeShader;
+    sgl::ShaderProgramPtr lightingShader;
+    sgl::ShaderProgramPtr lightCombineShader;
+
+    sgl::RenderTargetPtr sceneTarget;
+    sgl::FramebufferObjectPtr sceneFBO;
+    sgl::TexturePtr sceneTex;
+    sgl::RenderTargetPtr lightTarget;
+    sgl::FramebufferObjectPtr lightFBO;
+    sgl::TexturePtr lightTex;
+    StaticLightCache staticLightCache;
+
+    // Distance field of the occluders
+    sgl::FramebufferObjectPtr maskFBO;
+    sgl::TexturePtr maskTex;
+    DistanceField distanceField;
+    bool distanceFieldValid = false;
+    glm::mat4 distanceFieldViewProjMatrix;
+    int width = 0, height = 0;
+
+    GLuint lightBuffer = 0; // Shader storage buffer with the data of the drawn lights
+    std::vector<LightData> lightData;
+};
+
+
+
+#endif /* LOGIC_VOLUMELIGHT_LIGHTMANAGERSDF_HPP_ */
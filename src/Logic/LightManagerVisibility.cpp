@@ -0,0 +1,261 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstddef>
+
+#include <Graphics/Renderer.hpp>
+#include <Graphics/Shader/ShaderManager.hpp>
+#include <Graphics/Texture/TextureManager.hpp>
+#include <Input/Keyboard.hpp>
+#include <Math/Geometry/MatrixUtil.hpp>
+#include <ImGui/ImGuiWrapper.hpp>
+
+#include "Utils/Profiler.hpp"
+#include "Utils/ShaderCache.hpp"
+#include "VisibilityPolygon.hpp"
+#include "LightManagerVisibility.hpp"
+
+LightManagerVisibility::LightManagerVisibility(sgl::CameraPtr _camera) {
+    camera = _camera;
+    sceneTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
+    lightTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
+    lightCombineShader = ShaderCache::get()->getShaderProgram(
+            {"LightMix.Vertex", "LightMix.Fragment"});
+    lightCombineShader->setUniform("ambientLight", sgl::Color(50, 50, 50));
+    polygonShader = ShaderCache::get()->getShaderProgram(
+            {"VisibilityLight.Vertex", "VisibilityLight.Fragment"});
+    // Only needed for the edge geometry of the primitives, the shadows are computed on the CPU
+    edgeShader = ShaderCache::get()->getShaderProgram(
+            {"VolumeLight.Vertex", "VolumeLight.Geometry", "VolumeLight.Fragment"});
+
+    // sgl's shader attributes support no multi-draw calls, so the batch uses its own vertex array
+    glGenVertexArrays(1, &vertexArray);
+    glGenBuffers(1, &vertexBuffer);
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(PolygonVertex),
+            (void*)offsetof(PolygonVertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PolygonVertex),
+            (void*)offsetof(PolygonVertex, color));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    onResolutionChanged();
+}
+
+LightManagerVisibility::~LightManagerVisibility() {
+    glDeleteVertexArrays(1, &vertexArray);
+    glDeleteBuffers(1, &vertexBuffer);
+}
+
+static bool cacheStaticLights = true;
+
+void LightManagerVisibility::renderGUI() {
+    ImGui::Separator();
+
+    if (ImGui::Checkbox("Cache Static Lights", &cacheStaticLights)) {
+        staticLightCache.invalidate();
+    }
+    ImGui::Text("Polygon vertices: %d", int(batchVertices.size()));
+}
+
+
+void LightManagerVisibility::onOccluderChanged(const sgl::AABB2 &region) {
+    staticLightCache.invalidateRegion(region);
+}
+
+void LightManagerVisibility::onResolutionChanged() {
+    int width = getRenderWidth();
+    int height = getRenderHeight();
+
+    sceneFBO = sgl::Renderer->createFBO();
+    sceneTex = sgl::TextureManager->createEmptyTexture(width, height);
+    sceneFBO->bindTexture(sceneTex);
+    sceneTarget->bindFramebufferObject(sceneFBO);
+
+    lightFBO = sgl::Renderer->createFBO();
+    lightTex = sgl::TextureManager->createEmptyTexture(width, height);
+    lightFBO->bindTexture(lightTex);
+    lightTarget->bindFramebufferObject(lightFBO);
+
+    staticLightCache.onResolutionChanged(width, height);
+}
+
+void LightManagerVisibility::beginRenderScene() {
+    PROFILE_SCOPE("LightManagerVisibility::beginRenderScene");
+    camera->setRenderTarget(sceneTarget);
+    sceneTarget->bindRenderTarget();
+    sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(242, 242, 242));
+
+    // Now render scene (user)
+}
+
+void LightManagerVisibility::endRenderScene() {
+    PROFILE_SCOPE("LightManagerVisibility::endRenderScene");
+    sgl::Renderer->unbindFBO();
+}
+
+void LightManagerVisibility::beginRenderLightmap() {
+    PROFILE_SCOPE("LightManagerVisibility::beginRenderLightmap");
+    camera->setRenderTarget(lightTarget);
+}
+
+void LightManagerVisibility::addLightPolygons(const std::vector<VolumeLight*> &polygonLights) {
+    sgl::AABB2 camRect = camera->getAABB2(0.0f);
+    lightFans.resize(polygonLights.size());
+    threadPool.parallelFor(int(polygonLights.size()), [&](int lightIdx) {
+        // Reused by all tasks of the same thread
+        thread_local VisibilityScratch scratch;
+        thread_local std::vector<glm::vec2> shadowEdgePoints;
+
+        // Only the edges within the reach of the light are swept, so the cost doesn't depend on far away occluders
+        VolumeLight *light = polygonLights.at(lightIdx);
+        glm::vec2 lightPos = light->getPosition();
+        float radius = light->getRadius();
+        sgl::AABB2 bounds(glm::max(camRect.min, lightPos - glm::vec2(radius)),
+                glm::min(camRect.max, lightPos + glm::vec2(radius)));
+        if (bounds.min.x >= bounds.max.x || bounds.min.y >= bounds.max.y) {
+            lightFans.at(lightIdx).clear();
+            return;
+        }
+        getShadowCastingEdges(lightPos, camRect, shadowEdgePoints, radius);
+        computeVisibilityPolygon(lightPos, shadowEdgePoints, bounds, scratch, lightFans.at(lightIdx));
+    });
+
+    for (size_t lightIdx = 0; lightIdx < polygonLights.size(); lightIdx++) {
+        const std::vector<glm::vec2> &fan = lightFans.at(lightIdx);
+        sgl::Color color = polygonLights.at(lightIdx)->getColor();
+        batchFirsts.push_back(GLint(batchVertices.size()));
+        batchCounts.push_back(GLsizei(fan.size()));
+        for (const glm::vec2 &point : fan) {
+            PolygonVertex vertex = { point, { color.getR(), color.getG(), color.getB(), color.getA() } };
+            batchVertices.push_back(vertex);
+        }
+    }
+}
+
+void LightManagerVisibility::uploadBatch() {
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, batchVertices.size() * sizeof(PolygonVertex),
+            batchVertices.empty() ? nullptr : &batchVertices.front(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void LightManagerVisibility::drawPolygons(size_t firstPolygon, size_t numPolygons) {
+    if (numPolygons == 0) {
+        return;
+    }
+    sgl::Renderer->setBlendMode(sgl::BLEND_ADDITIVE);
+    polygonShader->setUniform("viewProjectionMatrix", camera->getProjectionMatrix() * camera->getViewMatrix());
+    polygonShader->bind();
+    glBindVertexArray(vertexArray);
+    glMultiDrawArrays(GL_TRIANGLE_FAN, &batchFirsts.at(firstPolygon), &batchCounts.at(firstPolygon),
+            GLsizei(numPolygons));
+    glBindVertexArray(0);
+}
+
+void LightManagerVisibility::renderLightmap(std::function<void()> renderfun) {
+    PROFILE_SCOPE("LightManagerVisibility::renderLightmap");
+    bool useBakedLightmap = bakedLightmap && bakedLightmap->matchesLights(getLights());
+    bool renderStaticLights = !useBakedLightmap && !cacheStaticLights;
+    glm::mat4 viewProjMatrix = camera->getProjectionMatrix() * camera->getViewMatrix();
+    bool updateCache =
+            !useBakedLightmap && cacheStaticLights && staticLightCache.needsUpdate(getLights(), viewProjMatrix);
+
+    updateOccluderEdges();
+
+    // The polygons of the static lights (only if the cache is rebuilt) come first in the batch
+    std::vector<VolumeLight*> cachedLights, directLights;
+    for (VolumeLightPtr &light : getLights()) {
+        if (!light->isStatic() || renderStaticLights) {
+            directLights.push_back(light.get());
+        } else if (updateCache) {
+            cachedLights.push_back(light.get());
+        }
+    }
+    batchVertices.clear();
+    batchFirsts.clear();
+    batchCounts.clear();
+    addLightPolygons(cachedLights);
+    addLightPolygons(directLights);
+    uploadBatch();
+
+    if (useBakedLightmap) {
+        // Start with the baked static lights
+        lightTarget->bindRenderTarget();
+        sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(0, 0, 0));
+        bakedLightmap->render(camera);
+    } else if (cacheStaticLights) {
+        if (updateCache) {
+            staticLightCache.beginUpdate();
+            drawPolygons(0, cachedLights.size());
+            staticLightCache.endUpdate(getLights(), viewProjMatrix);
+        }
+
+        // Start with the accumulated static lights and only add the dynamic ones
+        lightTarget->bindRenderTarget();
+        staticLightCache.blitCachedLights();
+    } else {
+        lightTarget->bindRenderTarget();
+        sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(0, 0, 0));
+    }
+
+    drawPolygons(cachedLights.size(), directLights.size());
+    sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
+}
+
+void LightManagerVisibility::endRenderLightmap() {
+    PROFILE_SCOPE("LightManagerVisibility::endRenderLightmap");
+    sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
+    sgl::Renderer->unbindFBO();
+}
+
+void LightManagerVisibility::blitMixSceneAndLights() {
+    PROFILE_SCOPE("LightManagerVisibility::blitMixSceneAndLights");
+    sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+
+    if (sgl::Keyboard->isKeyDown(SDLK_s)) {
+        sgl::Renderer->blitTexture(
+                sceneTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
+    } else if (sgl::Keyboard->isKeyDown(SDLK_d)) {
+        sgl::Renderer->blitTexture(
+                lightTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
+    } else {
+        lightCombineShader->setUniform("lightTexture", lightTex, 1);
+        sgl::Renderer->blitTexture(
+                sceneTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)), lightCombineShader);
+    }
+}
@@ -0,0 +1,100 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOGIC_VOLUMELIGHT_LIGHTMANAGERVISIBILITY_HPP_
+#define LOGIC_VOLUMELIGHT_LIGHTMANAGERVISIBILITY_HPP_
+
+#include <cstdint>
+#include <GL/glew.h>
+#include "Utils/ThreadPool.hpp"
+#include "LightManagerInterface.hpp"
+#include "StaticLightCache.hpp"
+
+/**
+ * Computes the exact lit region of every light as a visibility polygon on the CPU (one task per light).
+ * All polygons are uploaded as one batch of triangle fans, and each light is drawn once with additive blending.
+ * In contrast to shadow maps and shadow volumes, there are no resolution artifacts and no shadow overdraw.
+ */
+class LightManagerVisibility : public LightManagerInterface {
+public:
+    LightManagerVisibility(sgl::CameraPtr _camera);
+    ~LightManagerVisibility();
+    void beginRenderScene();
+    void endRenderScene();
+    void beginRenderLightmap();
+    void renderLightmap(std::function<void()> renderfun); // renderfun is unused, the occluders are used directly
+    void endRenderLightmap();
+    void blitMixSceneAndLights();
+    void renderGUI();
+
+    void onOccluderChanged(const sgl::AABB2 &region);
+    void onResolutionChanged();
+    sgl::ShaderProgramPtr getEdgeShader() { return edgeShader; }
+    sgl::TexturePtr getLightTexture() { return lightTex; }
+
+private:
+    struct PolygonVertex {
+        glm::vec2 position;
+        uint8_t color[4];
+    };
+    // Computes the polygons of the passed lights in parallel and appends them to the batch
+    void addLightPolygons(const std::vector<VolumeLight*> &polygonLights);
+    void uploadBatch();
+    void drawPolygons(size_t firstPolygon, size_t numPolygons);
+
+    sgl::CameraPtr camera;
+    sgl::ShaderProgramPtr edgeShader;
+    sgl::ShaderProgramPtr polygonShader;
+    sgl::ShaderProgramPtr lightCombineShader;
+
+    sgl::RenderTargetPtr sceneTarget;
+    sgl::FramebufferObjectPtr sceneFBO;
+    sgl::TexturePtr sceneTex;
+    sgl::RenderTargetPtr lightTarget;
+    sgl::FramebufferObjectPtr lightFBO;
+    sgl::TexturePtr lightTex;
+    StaticLightCache staticLightCache;
+
+    std::vector<std::vector<glm::vec2>> lightFans; // Per light task
+    // Batch of all triangle fans of this frame
+    std::vector<PolygonVertex> batchVertices;
+    std::vector<GLint> batchFirsts;
+    std::vector<GLsizei> batchCounts;
+    GLuint vertexArray = 0;
+    GLuint vertexBuffer = 0;
+
+    ThreadPool threadPool;
+};
+
+
+
+#endif /* LOGIC_VOLUMELIGHT_LIGHTMANAGERVISIBILITY_HPP_ */
@@ -40,146 +40,383 @@
 #include <Input/Keyboard.hpp>
 #include <Math/Geometry/MatrixUtil.hpp>
 #include <ImGui/ImGuiWrapper.hpp>
+#include <Utils/Convert.hpp>
 
+#include "Utils/Profiler.hpp"
+#include "Utils/ShaderCache.hpp"
 #include "LightManagerVolume.hpp"
 
+
 LightManagerVolume::LightManagerVolume(sgl::CameraPtr _camera) {
     camera = _camera;
-    sceneTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
-    lightTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
-    lightTempTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
-    lightCombineShader = sgl::ShaderManager->getShaderProgram(
-            {"LightMix.Vertex", "LightMix.Fragment"});
-    lightCombineShader->setUniform("ambientLight", sgl::Color(50, 50, 50));
-    edgeShader = sgl::ShaderManager->getShaderProgram(
+    edgeShader = ShaderCache::get()->getShaderProgram(
             {"VolumeLight.Vertex", "VolumeLight.Geometry", "VolumeLight.Fragment"});
+    plainShader = ShaderCache::get()->getShaderProgram({"Mesh.Vertex.Plain", "Mesh.Fragment.Plain"});
+    lightQuadRenderData = createFullscreenQuadRenderData(plainShader, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
     onResolutionChanged();
 }
 
-static bool multisampling = false;
+static int sceneSamples = 1;
+static int lightSamples = 1;
+static bool cacheStaticLights = true;
+static int blurMode = LIGHT_BLUR_OFF;
+static float blurRadius = 8.0f;
+static bool fxaa = false;
+static int lightFormat = LIGHT_FORMAT_RGBA8;
+static bool temporalAntialiasing = false;
+
+void LightManagerVolume::setLightBlur(LightBlurMode mode, float radius) {
+    blurMode = mode;
+    blurRadius = radius;
+}
+
+void LightManagerVolume::setMultisampling(int numSceneSamples, int numLightSamples) {
+    sceneSamples = numSceneSamples;
+    lightSamples = numLightSamples;
+}
+
+void LightManagerVolume::setTemporalAA(bool enabled) {
+    temporalAntialiasing = enabled;
+}
+
+void LightManagerVolume::setLightFormat(LightFormat format) {
+    lightFormat = format;
+}
+
+int LightManagerVolume::getLightBytesPerPixel() {
+    // Adding the light reads and writes every sample of the light buffer and of the depth-stencil buffer (to reset the
+    // stencil). The shadow volumes themselves depend on the occluders and aren't included.
+    int numSamples = getSupportedSampleCount(lightSamples);
+    return numSamples * 2 * (getLightFormatBytesPerPixel(getSupportedLightFormat(LightFormat(lightFormat))) + 4);
+}
 
 void LightManagerVolume::renderGUI() {
     ImGui::Separator();
 
-    if (ImGui::Checkbox("Multisampling", &multisampling)) {
+    if (renderSampleCountCombo("Scene MSAA", &sceneSamples)) {
         onResolutionChanged();
     }
+    if (renderSampleCountCombo("Shadow Edge MSAA", &lightSamples)) {
+        onResolutionChanged();
+    }
+    ImGui::Checkbox("Temporal AA", &temporalAntialiasing);
+    if (ImGui::Combo("Light Format", &lightFormat, LIGHT_FORMAT_NAMES, NUM_LIGHT_FORMATS)) {
+        onResolutionChanged();
+    }
+
+    if (ImGui::Checkbox("Cache Static Lights", &cacheStaticLights)) {
+        staticLightCache.invalidate();
+    }
+
+    ImGui::Text("Light Blur:");
+    ImGui::RadioButton("Off", &blurMode, LIGHT_BLUR_OFF); ImGui::SameLine();
+    ImGui::RadioButton("Dual Kawase", &blurMode, LIGHT_BLUR_DUAL_KAWASE); ImGui::SameLine();
+    ImGui::RadioButton("Gaussian (Reference)", &blurMode, LIGHT_BLUR_GAUSSIAN);
+    if (blurMode != LIGHT_BLUR_OFF) {
+        ImGui::SliderFloat("Blur Radius (px)", &blurRadius, 1.0f, 64.0f);
+        ImGui::Text("Blur GPU Time: %.3fms", lightBlur.getBlurTimeMs());
+    }
+    ImGui::Checkbox("FXAA", &fxaa);
+
+    ImGui::Text("%s", frameGraph.getMemorySummary().c_str());
 }
 
 
-VolumeLightPtr LightManagerVolume::addLight(const glm::vec2 &pos, float rad, const sgl::Color &col) {
-    VolumeLightPtr light(new VolumeLight(pos, rad, col));
-    lights.push_back(light);
-    return light;
+void LightManagerVolume::onOccluderChanged(const sgl::AABB2 &region) {
+    staticLightCache.invalidateRegion(region);
 }
 
 void LightManagerVolume::onResolutionChanged() {
-    sgl::Window *window = sgl::AppSettings::get()->getMainWindow();
+    int width = getRenderWidth();
+    int height = getRenderHeight();
+    LightFormat format = getSupportedLightFormat(LightFormat(lightFormat));
 
-    sceneFBO = sgl::Renderer->createFBO();
-    if (multisampling) {
-        sceneRenderTex = sgl::TextureManager->createMultisampledTexture(window->getWidth(), window->getHeight(), 8);
-    } else {
-        sceneRenderTex = sgl::TextureManager->createEmptyTexture(window->getWidth(), window->getHeight());
+    // The transient targets are created by the frame graph when the next frame is compiled
+    frameGraph.releaseTextures();
+    lightOutputTex = sgl::TexturePtr();
+    numSceneSamples = getSupportedSampleCount(sceneSamples);
+    numLightSamples = getSupportedSampleCount(lightSamples);
+    sceneResolveShader = getResolveShader(numSceneSamples, false);
+    lightResolveShader = getResolveShader(numLightSamples, true);
+    staticLightCache.onResolutionChanged(width, height, getLightFormatInternalFormat(format));
+    lightBlur.onResolutionChanged(width, height, format);
+    temporalAA.onResolutionChanged(width, height);
+
+    ShaderDefines combineDefines;
+    if (isLightFormatHdr(format)) {
+        combineDefines["HDR_LIGHT"] = "";
     }
-    sceneFBO->bindTexture(sceneRenderTex);
-    sceneTarget->bindFramebufferObject(sceneFBO);
+    lightCombineShader = ShaderCache::get()->getShaderProgram({"LightMix.Vertex", "LightMix.Fragment"}, combineDefines);
+    lightCombineShader->setUniform("ambientLight", sgl::Color(50, 50, 50));
+}
 
-    lightFBO = sgl::Renderer->createFBO();
-    if (multisampling) {
-        lightRenderTex = sgl::TextureManager->createMultisampledTexture(window->getWidth(), window->getHeight(), 8);
-    } else {
-        lightRenderTex = sgl::TextureManager->createEmptyTexture(window->getWidth(), window->getHeight());
+void LightManagerVolume::setupFrameGraph(bool renderScene) {
+    int width = getRenderWidth();
+    int height = getRenderHeight();
+    GLint lightInternalFormat = getLightFormatInternalFormat(getSupportedLightFormat(LightFormat(lightFormat)));
+    // The debug views only show either the scene or the light
+    bool showScene = renderScene && !sgl::Keyboard->isKeyDown(SDLK_d);
+    bool showLight = !renderScene || !sgl::Keyboard->isKeyDown(SDLK_s);
+
+    frameGraph.reset();
+    scenePass = resolvePass = lightResolvePass = taaPass = blurPass = fxaaPass = compositePass = FRAME_GRAPH_NONE;
+    if (renderScene) {
+        sceneRenderResource = frameGraph.createTexture(
+                "Scene", FrameGraphTextureDesc(width, height, GL_RGBA8, numSceneSamples > 1 ? numSceneSamples : 0));
+        frameGraph.setClearColor(sceneRenderResource, sgl::Color(242, 242, 242));
+        scenePass = frameGraph.addPass("Scene", {}, {sceneRenderResource});
+        sceneResource = sceneRenderResource;
+        if (numSceneSamples > 1) {
+            // The multisampled scene is dead after the resolve
+            sceneResource = frameGraph.createTexture("Scene (resolved)", FrameGraphTextureDesc(width, height));
+            resolvePass = frameGraph.addPass("Resolve Scene", {sceneRenderResource}, {sceneResource});
+        }
+    }
+
+    FrameGraphResource cacheResource = frameGraph.importTexture(
+            "Static Light Cache", staticLightCache.getTexture(),
+            FrameGraphTextureDesc(width, height, lightInternalFormat));
+    // The lights are added to all samples not covered by their shadow volumes in the stencil buffer
+    FrameGraphTextureDesc lightRenderDesc(
+            width, height, lightInternalFormat, numLightSamples > 1 ? numLightSamples : 0);
+    lightRenderDesc.stencil = true;
+    lightRenderResource = frameGraph.createTexture("Light", lightRenderDesc);
+    frameGraph.setClearColor(lightRenderResource, sgl::Color(0, 0, 0, 0));
+    lightPass = frameGraph.addPass("Lights", {cacheResource}, {lightRenderResource});
+    lightAccumResource = lightRenderResource;
+    if (numLightSamples > 1) {
+        // The only resolve of the light in the frame
+        lightAccumResource = frameGraph.createTexture(
+                "Light (resolved)", FrameGraphTextureDesc(width, height, lightInternalFormat));
+        lightResolvePass = frameGraph.addPass("Resolve Light", {lightRenderResource}, {lightAccumResource});
+    }
+    lightOutputResource = lightAccumResource;
+
+    // Baking renders independent tiles, which have no history
+    if (temporalAntialiasing && renderScene) {
+        FrameGraphResource previousHistoryResource = frameGraph.importTexture(
+                "TAA History (previous)", temporalAA.getPreviousHistoryTexture(), temporalAA.getHistoryDesc());
+        FrameGraphResource historyResource = frameGraph.importTexture(
+                "TAA History", temporalAA.getHistoryTexture(), temporalAA.getHistoryDesc());
+        taaInputResource = lightOutputResource;
+        taaPass = frameGraph.addPass("Temporal AA", {lightOutputResource, previousHistoryResource}, {historyResource});
+        lightOutputResource = historyResource;
+    }
+    if (blurMode != LIGHT_BLUR_OFF) {
+        blurInputResource = lightOutputResource;
+        std::vector<FrameGraphResource> blurReads = {lightOutputResource};
+        FrameGraphResource blurOutputResource = FRAME_GRAPH_NONE;
+        for (int level = 0; level <= MAX_BLUR_LEVELS; level++) {
+            FrameGraphResource levelResource = frameGraph.importTexture(
+                    "Blur Level " + sgl::toString(level), lightBlur.getLevelTexture(level),
+                    lightBlur.getLevelDesc(level));
+            if (level == 0) {
+                blurOutputResource = levelResource;
+            } else {
+                blurReads.push_back(levelResource);
+            }
+        }
+        blurPass = frameGraph.addPass("Blur", blurReads, {blurOutputResource});
+        lightOutputResource = blurOutputResource;
+    }
+    if (fxaa) {
+        fxaaInputResource = lightOutputResource;
+        FrameGraphResource fxaaResource = frameGraph.createTexture(
+                "Light (FXAA)", FrameGraphTextureDesc(width, height, lightInternalFormat));
+        fxaaPass = frameGraph.addPass("FXAA", {lightOutputResource}, {fxaaResource});
+        lightOutputResource = fxaaResource;
+    }
+
+    if (renderScene) {
+        std::vector<FrameGraphResource> compositeReads;
+        if (showScene) {
+            compositeReads.push_back(sceneResource);
+        }
+        if (showLight) {
+            compositeReads.push_back(lightOutputResource);
+        }
+        compositePass = frameGraph.addPass("Composite", compositeReads, {});
+    }
+    if (showLight) {
+        // Also read after the frame (getLightTexture)
+        frameGraph.markOutput(lightOutputResource);
     }
-    lightFBO->bindTexture(lightRenderTex);
-    lightTarget->bindFramebufferObject(lightFBO);
+    frameGraph.compile();
+}
 
-    lightTempFBO = sgl::Renderer->createFBO();
-    lightTempTex = sgl::TextureManager->createEmptyTexture(window->getWidth(), window->getHeight());
-    lightTempFBO->bindTexture(lightTempTex);
-    lightTempTarget->bindFramebufferObject(lightTempFBO);
+bool LightManagerVolume::isSceneNeeded() {
+    return !frameGraph.isPassCulled(scenePass);
 }
 
 void LightManagerVolume::beginRenderScene() {
-    camera->setRenderTarget(sceneTarget);
-    sceneTarget->bindRenderTarget();
-    sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(242, 242, 242));
+    PROFILE_SCOPE("LightManagerVolume::beginRenderScene");
+    setupFrameGraph(true);
+    sceneRendered = true;
+    if (frameGraph.beginPass(scenePass)) {
+        camera->setRenderTarget(frameGraph.getRenderTarget(sceneRenderResource));
+    }
 
     // Now render scene (user)
 }
 
 void LightManagerVolume::endRenderScene() {
+    PROFILE_SCOPE("LightManagerVolume::endRenderScene");
     sgl::Renderer->unbindFBO();
-    sceneTex = sgl::Renderer->resolveMultisampledTexture(sceneRenderTex);
+
+    if (frameGraph.beginPass(resolvePass)) {
+        sgl::Renderer->setBlendMode(sgl::BLEND_OVERWRITE);
+        sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+        sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+        sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+        sgl::Renderer->blitTexture(frameGraph.getTexture(sceneRenderResource),
+                sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)), sceneResolveShader);
+        sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
+        sgl::Renderer->setViewMatrix(camera->getViewMatrix());
+        sgl::Renderer->setProjectionMatrix(camera->getProjectionMatrix());
+    }
     sgl::Renderer->unbindFBO();
 }
 
 
 void LightManagerVolume::renderLightmap(std::function<void()> renderfun) {
-    lightTempTarget->bindRenderTarget();
-    sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(0, 0, 0));
-
-    for (VolumeLightPtr &light : lights) {
-        lightTarget->bindRenderTarget();
-        sgl::Renderer->setBlendMode(sgl::BLEND_SUBTRACTIVE);
-        sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, light->getColor());
-        edgeShader->setUniform("lightpos", light->position);
-        renderfun();
-
-        lightTempTarget->bindRenderTarget();
-        sgl::Renderer->setBlendMode(sgl::BLEND_ADDITIVE);
-        sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
-        sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
-        sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
-        sgl::Renderer->blitTexture(
-                lightRenderTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
+    PROFILE_SCOPE("LightManagerVolume::renderLightmap");
+    // Binds and clears the light and stencil buffers
+    if (!frameGraph.beginPass(lightPass)) {
+        return;
+    }
+    sgl::RenderTargetPtr accumulationTarget = frameGraph.getRenderTarget(lightRenderResource);
+
+    bool useBakedLightmap = bakedLightmap && bakedLightmap->matchesLights(getLights());
+    bool renderStaticLights = !useBakedLightmap && !cacheStaticLights;
+    if (useBakedLightmap) {
+        // Start with the baked static lights
+        bakedLightmap->render(camera);
+    } else if (cacheStaticLights) {
+        glm::mat4 viewProjMatrix = camera->getProjectionMatrix() * camera->getViewMatrix();
+        if (staticLightCache.needsUpdate(getLights(), viewProjMatrix)) {
+            // Render the static lights to the (still empty) light buffer and store them resolved in the cache
+            for (VolumeLightPtr &light : getLights()) {
+                if (light->isStatic()) {
+                    renderLight(light, renderfun, accumulationTarget);
+                }
+            }
+            staticLightCache.beginUpdate();
+            copyLight(frameGraph.getTexture(lightRenderResource));
+            staticLightCache.endUpdate(getLights(), viewProjMatrix);
+            accumulationTarget->bindRenderTarget();
+        } else {
+            // Start with the accumulated static lights and only add the dynamic ones
+            staticLightCache.blitCachedLights();
+        }
+    }
+
+    for (VolumeLightPtr &light : getLightGroups(renderStaticLights, camera->getAABB2(0.0f))) {
+        renderLight(light, renderfun, accumulationTarget);
+    }
+    sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
+}
+
+void LightManagerVolume::renderLight(
+        VolumeLightPtr &light, std::function<void()> &renderfun, sgl::RenderTargetPtr &accumulationTarget) {
+    accumulationTarget->bindRenderTarget();
+    // Mark the samples in the shadow volumes. Overlapping volumes just mark them again.
+    glEnable(GL_STENCIL_TEST);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glStencilFunc(GL_ALWAYS, 1, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    edgeShader->setUniform("lightpos", light->position);
+    shadowPassLights.assign(1, light->position);
+    shadowPassViewRect = camera->getAABB2(0.0f);
+    renderfun();
+    shadowPassLights.clear();
+
+    // Add the light to the unmarked samples. All samples are unmarked again afterwards for the next light.
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glStencilFunc(GL_EQUAL, 0, 0xFF);
+    glStencilOp(GL_ZERO, GL_ZERO, GL_ZERO);
+    sgl::Renderer->setBlendMode(sgl::BLEND_ADDITIVE);
+    sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+    plainShader->setUniform("color", light->getColor());
+    sgl::Renderer->render(lightQuadRenderData);
+    glDisable(GL_STENCIL_TEST);
+}
+
+void LightManagerVolume::copyLight(const sgl::TexturePtr &lightTexture) {
+    sgl::Renderer->setBlendMode(sgl::BLEND_OVERWRITE);
+    sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+    if (numLightSamples > 1) {
+        sgl::Renderer->blitTexture(lightTexture, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)), lightResolveShader);
+    } else {
+        sgl::Renderer->blitTexture(lightTexture, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
     }
     sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
 }
 
 void LightManagerVolume::beginRenderLightmap() {
-    camera->setRenderTarget(lightTarget);
+    PROFILE_SCOPE("LightManagerVolume::beginRenderLightmap");
+    if (!sceneRendered) {
+        // Only the light is rendered (e.g., when baking)
+        setupFrameGraph(false);
+    }
+    sgl::RenderTargetPtr lightRenderTarget = frameGraph.getRenderTarget(lightRenderResource);
+    if (lightRenderTarget) {
+        camera->setRenderTarget(lightRenderTarget);
+    }
+    // The shadow volumes are shifted by a different sub-pixel offset in every frame
+    projectionJitter = frameGraph.isPassCulled(taaPass) ? glm::vec2(0.0f) : temporalAA.getJitter();
 }
 
 void LightManagerVolume::endRenderLightmap() {
+    PROFILE_SCOPE("LightManagerVolume::endRenderLightmap");
     sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
     sgl::Renderer->unbindFBO();
 
-    //lightTex = sgl::Renderer->resolveMultisampledTexture(lightRenderTex);
-    bool blur = false;
-    bool fxaa = false;
-    if (blur) {
-        sgl::Renderer->blurTexture(lightTempTex);
+    if (frameGraph.beginPass(lightResolvePass)) {
+        copyLight(frameGraph.getTexture(lightRenderResource));
     }
-
-    if (fxaa) {
-        sgl::Window *window = sgl::AppSettings::get()->getMainWindow();
-        sgl::TexturePtr texFXAA = sgl::TextureManager->createEmptyTexture(window->getWidth(), window->getHeight());
-        sgl::FramebufferObjectPtr fboFXAA = sgl::Renderer->createFBO();
-        fboFXAA->bindTexture(texFXAA);
-        sgl::Renderer->bindFBO(fboFXAA);
-        sgl::Renderer->blitTextureFXAAAntialiased(lightTempTex);
-        lightTempTex = texFXAA;
-        lightTempFBO->bindTexture(lightTempTex);
+    projectionJitter = glm::vec2(0.0f);
+    if (frameGraph.beginPass(taaPass)) {
+        temporalAA.resolve(frameGraph.getTexture(taaInputResource),
+                camera->getProjectionMatrix() * camera->getViewMatrix());
+    } else {
+        // The history is outdated once a frame is skipped
+        temporalAA.invalidate();
+    }
+    if (frameGraph.beginPass(blurPass)) {
+        lightBlur.blur(frameGraph.getTexture(blurInputResource), LightBlurMode(blurMode), blurRadius);
+    }
+    if (frameGraph.beginPass(fxaaPass)) {
+        sgl::Renderer->blitTextureFXAAAntialiased(frameGraph.getTexture(fxaaInputResource));
+    }
+    if (!frameGraph.isPassCulled(lightPass)) {
+        lightOutputTex = frameGraph.getTexture(lightOutputResource);
     }
+    sceneRendered = false;
 
     sgl::Renderer->unbindFBO();
 }
 
 void LightManagerVolume::blitMixSceneAndLights() {
+    PROFILE_SCOPE("LightManagerVolume::blitMixSceneAndLights");
+    frameGraph.beginPass(compositePass);
     sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
     sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
     sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
 
     if (sgl::Keyboard->isKeyDown(SDLK_s)) {
         sgl::Renderer->blitTexture(
-                sceneTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
+                frameGraph.getTexture(sceneResource), sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
     } else if (sgl::Keyboard->isKeyDown(SDLK_d)) {
         sgl::Renderer->blitTexture(
-                lightTempTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
+                lightOutputTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
     } else {
-        lightCombineShader->setUniform("lightTexture", lightTempTex, 1);
+        lightCombineShader->setUniform("lightTexture", lightOutputTex, 1);
         sgl::Renderer->blitTexture(
-                sceneTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)), lightCombineShader);
+                frameGraph.getTexture(sceneResource), sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)),
+                lightCombineShader);
     }
 }
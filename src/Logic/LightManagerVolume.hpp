@@ -34,6 +34,10 @@
 #define LOGIC_VOLUMELIGHT_LIGHTMANAGER_HPP_
 
 #include "LightManagerInterface.hpp"
+#include "StaticLightCache.hpp"
+#include "LightBlur.hpp"
+#include "TemporalAA.hpp"
+#include "Utils/FrameGraph.hpp"
 
 class LightManagerVolume : public LightManagerInterface {
 public:
@@ -46,31 +50,53 @@ public:
     void blitMixSceneAndLights();
     void renderGUI();
 
-    VolumeLightPtr addLight(
-            const glm::vec2 &pos, float rad = 10.0f, const sgl::Color &col = sgl::Color(255, 255, 255));
-    std::vector<VolumeLightPtr> &getLights() { return lights; }
-
+    void onOccluderChanged(const sgl::AABB2 &region);
     void onResolutionChanged();
     sgl::ShaderProgramPtr getEdgeShader() { return edgeShader; }
+    sgl::TexturePtr getLightTexture() { return lightOutputTex; }
+    bool isSceneNeeded();
+    FrameGraph *getFrameGraph() { return &frameGraph; }
+    int getLightBytesPerPixel();
+    // Softening of the accumulated light (shared by all instances, like the GUI settings)
+    static void setLightBlur(LightBlurMode mode, float radius);
+    // Sample counts of the scene and of the light buffer the shadow volumes are rendered to (1: No MSAA)
+    static void setMultisampling(int numSceneSamples, int numLightSamples);
+    static void setTemporalAA(bool enabled);
+    static void setLightFormat(LightFormat format);
 
 private:
+    // Declares the passes of the frame. Without the scene (e.g., when baking), only the light is rendered.
+    void setupFrameGraph(bool renderScene);
+    // Renders the shadow volumes of the light to the stencil buffer and adds its contribution to the passed
+    // accumulation target where the stencil buffer is unmarked
+    void renderLight(VolumeLightPtr &light, std::function<void()> &renderfun, sgl::RenderTargetPtr &accumulationTarget);
+    // Copies the light buffer to the bound target, resolving it if it is multisampled
+    void copyLight(const sgl::TexturePtr &lightTexture);
+
     sgl::CameraPtr camera;
-    std::vector<VolumeLightPtr> lights;
     sgl::ShaderProgramPtr plainShader;
     sgl::ShaderProgramPtr edgeShader;
     sgl::ShaderProgramPtr lightCombineShader;
+    sgl::ShaderProgramPtr sceneResolveShader; // Specialized for numSceneSamples
+    sgl::ShaderProgramPtr lightResolveShader; // Specialized for numLightSamples
+    sgl::ShaderAttributesPtr lightQuadRenderData; // Covers the whole light buffer
+    int numSceneSamples = 1, numLightSamples = 1;
 
-    sgl::RenderTargetPtr sceneTarget;
-    sgl::RenderTargetPtr lightTarget;
-    sgl::RenderTargetPtr lightTempTarget;
-    sgl::FramebufferObjectPtr sceneFBO;
-    sgl::TexturePtr sceneRenderTex; // Equal to sceneTex if no MSAA is used
-    sgl::TexturePtr sceneTex;
-    sgl::FramebufferObjectPtr lightFBO;
-    sgl::TexturePtr lightRenderTex; // Equal to lightTex if no MSAA is used
-    sgl::TexturePtr lightTex;
-    sgl::FramebufferObjectPtr lightTempFBO;
-    sgl::TexturePtr lightTempTex;
+    // All screen-sized targets except for the caches are transient resources of the frame graph
+    FrameGraph frameGraph;
+    bool sceneRendered = false; // beginRenderScene was called in the current frame
+    FrameGraphResource sceneRenderResource = FRAME_GRAPH_NONE, sceneResource = FRAME_GRAPH_NONE; // Equal without MSAA
+    // The light buffer with the stencil buffer, and its resolved version (equal without MSAA)
+    FrameGraphResource lightRenderResource = FRAME_GRAPH_NONE, lightAccumResource = FRAME_GRAPH_NONE;
+    FrameGraphResource taaInputResource = FRAME_GRAPH_NONE, blurInputResource = FRAME_GRAPH_NONE;
+    FrameGraphResource fxaaInputResource = FRAME_GRAPH_NONE, lightOutputResource = FRAME_GRAPH_NONE;
+    FrameGraphPass scenePass = FRAME_GRAPH_NONE, resolvePass = FRAME_GRAPH_NONE, lightPass = FRAME_GRAPH_NONE;
+    FrameGraphPass lightResolvePass = FRAME_GRAPH_NONE, taaPass = FRAME_GRAPH_NONE, blurPass = FRAME_GRAPH_NONE;
+    FrameGraphPass fxaaPass = FRAME_GRAPH_NONE, compositePass = FRAME_GRAPH_NONE;
+    sgl::TexturePtr lightOutputTex; // The accumulated light after blurring and FXAA (kept after the frame)
+    StaticLightCache staticLightCache;
+    LightBlur lightBlur;
+    TemporalAA temporalAA;
 };
 
 
@@ -0,0 +1,68 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <Graphics/Renderer.hpp>
+
+#include "LightManagerInterface.hpp"
+#include "LightView.hpp"
+
+void LightView::updateTargets(GLint lightInternalFormat) {
+    if (width == targetWidth && height == targetHeight && lightInternalFormat == targetLightFormat) {
+        return;
+    }
+    targetWidth = width;
+    targetHeight = height;
+    targetLightFormat = lightInternalFormat;
+
+    sceneFBO = sgl::Renderer->createFBO();
+    sceneTexture = sgl::TextureManager->createEmptyTexture(width, height);
+    sceneFBO->bindTexture(sceneTexture);
+
+    sgl::TextureSettings lightSettings;
+    lightSettings.internalFormat = lightInternalFormat;
+    lightSettings.pixelType = lightInternalFormat == GL_RGBA8 ? GL_UNSIGNED_BYTE : GL_FLOAT;
+    lightFBO = sgl::Renderer->createFBO();
+    lightTexture = sgl::TextureManager->createEmptyTexture(width, height, lightSettings);
+    lightFBO->bindTexture(lightTexture);
+}
+
+sgl::ShaderAttributesPtr LightView::getSceneQuad(sgl::ShaderProgramPtr shader) {
+    sgl::AABB2 cameraRect = camera->getAABB2(0.0f);
+    if (!sceneQuad || shader != sceneQuadShader || cameraRect.min != sceneQuadRect.min
+            || cameraRect.max != sceneQuadRect.max) {
+        sceneQuad = createFullscreenQuadRenderData(shader, cameraRect);
+        sceneQuadShader = shader;
+        sceneQuadRect = cameraRect;
+    }
+    return sceneQuad;
+}
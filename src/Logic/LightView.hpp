@@ -0,0 +1,90 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef LOGIC_LIGHTVIEW_HPP_
+#define LOGIC_LIGHTVIEW_HPP_
+
+#include <boost/shared_ptr.hpp>
+#include <GL/glew.h>
+#include <Math/Geometry/AABB2.hpp>
+#include <Graphics/Scene/Camera.hpp>
+#include <Graphics/Buffers/FBO.hpp>
+#include <Graphics/Texture/TextureManager.hpp>
+#include <Graphics/Shader/ShaderAttributes.hpp>
+
+/**
+ * An additional view of the scene (e.g., a minimap or a spectator camera) with its own camera and resolution.
+ * Light managers with view-independent shadow data shade it with the shadow data of the main view's frame, i.e., a
+ * view only costs its scene, shading and composite passes.
+ */
+class LightView {
+public:
+    /**
+     * @param camera The aspect ratio of the camera should match the one of the resolution.
+     * @param screenRect Part of the output framebuffer covered by the view (in normalized device coordinates).
+     */
+    LightView(sgl::CameraPtr camera, const sgl::AABB2 &screenRect) : camera(camera), screenRect(screenRect) {}
+    inline sgl::CameraPtr getCamera() { return camera; }
+    inline const sgl::AABB2 &getScreenRect() { return screenRect; }
+    inline void setResolution(int width, int height) { this->width = width; this->height = height; }
+    inline int getWidth() { return width; }
+    inline int getHeight() { return height; }
+
+    // Creates the scene and light targets again if the resolution or the format of the light changed
+    void updateTargets(GLint lightInternalFormat);
+    inline sgl::FramebufferObjectPtr getSceneFBO() { return sceneFBO; }
+    inline sgl::TexturePtr getSceneTexture() { return sceneTexture; }
+    inline sgl::FramebufferObjectPtr getLightFBO() { return lightFBO; }
+    inline sgl::TexturePtr getLightTexture() { return lightTexture; }
+
+    // Two triangles covering the part of the scene seen by the camera (created again if the camera moved)
+    sgl::ShaderAttributesPtr getSceneQuad(sgl::ShaderProgramPtr shader);
+
+private:
+    sgl::CameraPtr camera;
+    sgl::AABB2 screenRect;
+    int width = 1, height = 1;
+
+    int targetWidth = 0, targetHeight = 0;
+    GLint targetLightFormat = GL_NONE;
+    sgl::FramebufferObjectPtr sceneFBO, lightFBO;
+    sgl::TexturePtr sceneTexture, lightTexture;
+
+    sgl::ShaderAttributesPtr sceneQuad;
+    sgl::ShaderProgramPtr sceneQuadShader;
+    sgl::AABB2 sceneQuadRect;
+};
+
+typedef boost::shared_ptr<LightView> LightViewPtr;
+
+#endif /* LOGIC_LIGHTVIEW_HPP_ */
@@ -0,0 +1,78 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <GL/glew.h>
+#include <ImGui/ImGuiWrapper.hpp>
+#include <Utils/Convert.hpp>
+
+#include "Utils/ShaderCache.hpp"
+#include "Multisampling.hpp"
+
+int getSupportedSampleCount(int numSamples) {
+    static GLint maxSamples = 0;
+    if (maxSamples == 0) {
+        // Color attachments are multisampled textures, depth-stencil attachments are renderbuffers
+        GLint maxColorSamples = 1, maxRenderbufferSamples = 1;
+        glGetIntegerv(GL_MAX_COLOR_TEXTURE_SAMPLES, &maxColorSamples);
+        glGetIntegerv(GL_MAX_SAMPLES, &maxRenderbufferSamples);
+        maxSamples = std::max(std::min(maxColorSamples, maxRenderbufferSamples), 1);
+    }
+    int supportedSamples = 1;
+    while (supportedSamples * 2 <= std::min(numSamples, int(maxSamples))) {
+        supportedSamples *= 2;
+    }
+    return supportedSamples;
+}
+
+bool renderSampleCountCombo(const char *label, int *numSamples) {
+    const char *sampleCountNames[] = {"Off", "2x", "4x", "8x"};
+    int modeIdx = 0;
+    while ((2 << modeIdx) <= *numSamples && modeIdx < 3) {
+        modeIdx++;
+    }
+    if (ImGui::Combo(label, &modeIdx, sampleCountNames, IM_ARRAYSIZE(sampleCountNames))) {
+        *numSamples = 1 << modeIdx;
+        return true;
+    }
+    return false;
+}
+
+sgl::ShaderProgramPtr getResolveShader(int numSamples, bool linear) {
+    // Specialized for the sample count, as the loop is unrolled at compile time
+    ShaderDefines defines;
+    defines["NUM_SAMPLES"] = sgl::toString(numSamples);
+    if (linear) {
+        defines["LINEAR_RESOLVE"] = "";
+    }
+    return ShaderCache::get()->getShaderProgram({"ResolveMSAA.Vertex", "ResolveMSAA.Fragment"}, defines);
+}
@@ -0,0 +1,134 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <algorithm>
+#include <Graphics/Renderer.hpp>
+#include <Graphics/Shader/ShaderManager.hpp>
+
+#include "Utils/StagingUploader.hpp"
+#include "Polygon.hpp"
+
+static float cross(const glm::vec2 &a, const glm::vec2 &b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+static bool isInsideTriangle(const glm::vec2 &p, const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &c) {
+    return cross(b - a, p - a) >= 0.0f && cross(c - b, p - b) >= 0.0f && cross(a - c, p - c) >= 0.0f;
+}
+
+// Ear clipping of a counterclockwise simple polygon (O(n^2), the outlines only have few points)
+static void triangulate(const std::vector<glm::vec2> &loop, std::vector<glm::vec2> &triangles) {
+    std::vector<size_t> remaining;
+    for (size_t i = 0; i < loop.size(); i++) {
+        remaining.push_back(i);
+    }
+    size_t numFailedTries = 0;
+    size_t i = 0;
+    while (remaining.size() > 3 && numFailedTries < remaining.size()) {
+        size_t n = remaining.size();
+        const glm::vec2 &a = loop.at(remaining.at((i + n - 1) % n));
+        const glm::vec2 &b = loop.at(remaining.at(i % n));
+        const glm::vec2 &c = loop.at(remaining.at((i + 1) % n));
+        bool isEar = cross(b - a, c - b) > 0.0f;
+        for (size_t j = 0; isEar && j < n; j++) {
+            const glm::vec2 &p = loop.at(remaining.at(j));
+            if (&p != &a && &p != &b && &p != &c && isInsideTriangle(p, a, b, c)) {
+                isEar = false;
+            }
+        }
+        if (isEar) {
+            triangles.push_back(a);
+            triangles.push_back(b);
+            triangles.push_back(c);
+            remaining.erase(remaining.begin() + (i % n));
+            numFailedTries = 0;
+        } else {
+            i++;
+            numFailedTries++;
+        }
+    }
+    // Degenerate (e.g., self-intersecting) outlines keep their remaining points as a fan
+    for (size_t j = 1; j + 1 < remaining.size(); j++) {
+        triangles.push_back(loop.at(remaining.front()));
+        triangles.push_back(loop.at(remaining.at(j)));
+        triangles.push_back(loop.at(remaining.at(j + 1)));
+    }
+}
+
+PolygonPrimitive::PolygonPrimitive(const std::vector<glm::vec2> &outline) {
+    specialTransform = sgl::matrixIdentity();
+    glm::vec2 minPoint = outline.front(), maxPoint = outline.front();
+    float signedArea = 0.0f;
+    for (size_t i = 0; i < outline.size(); i++) {
+        minPoint = glm::min(minPoint, outline.at(i));
+        maxPoint = glm::max(maxPoint, outline.at(i));
+        signedArea += cross(outline.at(i), outline.at((i + 1) % outline.size()));
+    }
+
+    // The edges are in object space around the center and counterclockwise like the ones of the other primitives
+    position = (minPoint + maxPoint) * 0.5f;
+    edges.clear();
+    for (const glm::vec2 &point : outline) {
+        edges.push_back(point - position);
+    }
+    if (signedArea < 0.0f) {
+        std::reverse(edges.begin(), edges.end());
+    }
+
+    triangulate(edges, triangleVertices);
+    computeEdgeLods();
+}
+
+size_t PolygonPrimitive::getGeometrySize() {
+    return sizeof(glm::vec2)*triangleVertices.size() + getEdgeDataSize();
+}
+
+void PolygonPrimitive::upload(
+        sgl::ShaderProgramPtr _plainShader, sgl::ShaderProgramPtr edgeShader, StagingUploader *uploader) {
+    plainShader = _plainShader;
+    size_t size = sizeof(glm::vec2)*triangleVertices.size();
+    polygonData = sgl::ShaderManager->createShaderAttributes(plainShader);
+    sgl::GeometryBufferPtr geometryBuffer = uploader
+            ? uploader->upload(&triangleVertices.front(), size)
+            : sgl::Renderer->createGeometryBuffer(size, &triangleVertices.front());
+    polygonData->addGeometryBuffer(geometryBuffer, "vertexPosition", sgl::ATTRIB_FLOAT, 2);
+    polygonData->setVertexMode(sgl::VERTEX_MODE_TRIANGLES);
+
+    createEdgeData(edgeShader, uploader);
+}
+
+void PolygonPrimitive::renderFilled(const sgl::Color &fillColor) {
+    sgl::Renderer->setModelMatrix(getTransform());
+    plainShader->setUniform("color", fillColor);
+    sgl::Renderer->render(polygonData);
+}
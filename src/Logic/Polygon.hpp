@@ -0,0 +1,64 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef LOGIC_VOLUMELIGHT_POLYGON_HPP_
+#define LOGIC_VOLUMELIGHT_POLYGON_HPP_
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "Primitive.hpp"
+
+/**
+ * Occluder with an arbitrary simple outline, e.g. loaded from a world chunk (see WorldStreamer). It is created in two
+ * steps, so the expensive part can run on a loader thread: The constructor triangulates the outline and computes the
+ * levels of detail of the edges without any OpenGL calls. upload then creates the vertex data on the render thread.
+ */
+class PolygonPrimitive : public Primitive {
+public:
+    // The outline is in world space and may be in either winding order
+    explicit PolygonPrimitive(const std::vector<glm::vec2> &outline);
+    void upload(sgl::ShaderProgramPtr _plainShader, sgl::ShaderProgramPtr edgeShader,
+            StagingUploader *uploader = nullptr);
+    inline bool isUploaded() { return polygonData.get() != nullptr; }
+    // Bytes of all vertex data (filled triangles and edges)
+    size_t getGeometrySize();
+    void renderFilled(const sgl::Color &fillColor);
+
+private:
+    sgl::ShaderProgramPtr plainShader;
+    sgl::ShaderAttributesPtr polygonData;
+    std::vector<glm::vec2> triangleVertices;
+};
+
+
+#endif /* LOGIC_VOLUMELIGHT_POLYGON_HPP_ */
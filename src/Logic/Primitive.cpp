@@ -0,0 +1,220 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <Graphics/Renderer.hpp>
+#include <Graphics/Shader/ShaderManager.hpp>
+
+#include "Utils/StagingUploader.hpp"
+#include "Primitive.hpp"
+
+static float distanceToSegment(const glm::vec2 &p, const glm::vec2 &a, const glm::vec2 &b) {
+    glm::vec2 ab = b - a;
+    float lengthSquared = glm::dot(ab, ab);
+    float t = lengthSquared > 0.0f ? glm::clamp(glm::dot(p - a, ab) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+    return glm::length(p - (a + t * ab));
+}
+
+// Douglas-Peucker on the open polyline points[first..last]. The end points are always kept.
+static void simplifyPolyline(
+        const std::vector<glm::vec2> &points, size_t first, size_t last, float tolerance, std::vector<bool> &keep) {
+    std::vector<std::pair<size_t, size_t>> ranges;
+    ranges.push_back(std::make_pair(first, last));
+    while (!ranges.empty()) {
+        size_t start = ranges.back().first, end = ranges.back().second;
+        ranges.pop_back();
+        float maxDistance = 0.0f;
+        size_t maxIndex = start;
+        for (size_t i = start + 1; i < end; i++) {
+            float distance = distanceToSegment(points.at(i), points.at(start), points.at(end));
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                maxIndex = i;
+            }
+        }
+        if (maxDistance > tolerance) {
+            keep.at(maxIndex) = true;
+            ranges.push_back(std::make_pair(start, maxIndex));
+            ranges.push_back(std::make_pair(maxIndex, end));
+        }
+    }
+}
+
+// Simplifies a closed loop. The loop is split at its first point and the point farthest away from it.
+static void simplifyLoop(const std::vector<glm::vec2> &loop, float tolerance, std::vector<glm::vec2> &simplified) {
+    size_t n = loop.size();
+    size_t farthestIndex = 0;
+    float farthestDistance = 0.0f;
+    for (size_t i = 1; i < n; i++) {
+        float distance = glm::length(loop.at(i) - loop.front());
+        if (distance > farthestDistance) {
+            farthestDistance = distance;
+            farthestIndex = i;
+        }
+    }
+
+    // The first point is appended again, so both halves are contiguous
+    std::vector<glm::vec2> points(loop);
+    points.push_back(loop.front());
+    std::vector<bool> keep(n + 1, false);
+    keep.at(0) = true;
+    keep.at(farthestIndex) = true;
+    simplifyPolyline(points, 0, farthestIndex, tolerance, keep);
+    simplifyPolyline(points, farthestIndex, n, tolerance, keep);
+
+    simplified.clear();
+    for (size_t i = 0; i < n; i++) {
+        if (keep.at(i)) {
+            simplified.push_back(loop.at(i));
+        }
+    }
+}
+
+void Primitive::createEdgeLods(sgl::ShaderProgramPtr edgeShader) {
+    computeEdgeLods();
+    createEdgeData(edgeShader);
+}
+
+void Primitive::computeEdgeLods() {
+    boundingCenter = glm::vec2(0.0f);
+    for (const glm::vec2 &point : edges) {
+        boundingCenter += point;
+    }
+    boundingCenter /= float(edges.size());
+    boundingRadius = 0.0f;
+    for (const glm::vec2 &point : edges) {
+        boundingRadius = std::max(boundingRadius, glm::length(point - boundingCenter));
+    }
+
+    // Each level doubles the tolerance, levels that don't remove any points are skipped
+    edgeLods.clear();
+    edgeLodErrors.clear();
+    edgeLods.push_back(edges);
+    edgeLodErrors.push_back(0.0f);
+    std::vector<glm::vec2> simplified;
+    for (float tolerance = boundingRadius / 256.0f; tolerance < boundingRadius; tolerance *= 2.0f) {
+        simplifyLoop(edges, tolerance, simplified);
+        if (simplified.size() < 3) {
+            break;
+        }
+        if (simplified.size() < edgeLods.back().size()) {
+            edgeLods.push_back(simplified);
+            edgeLodErrors.push_back(tolerance);
+        }
+    }
+}
+
+size_t Primitive::getEdgeDataSize() {
+    size_t size = 0;
+    for (std::vector<glm::vec2> &loop : edgeLods) {
+        size += sizeof(glm::vec2)*loop.size();
+    }
+    return size;
+}
+
+void Primitive::createEdgeData(sgl::ShaderProgramPtr edgeShader, StagingUploader *uploader) {
+    edgeData.clear();
+    for (std::vector<glm::vec2> &loop : edgeLods) {
+        sgl::ShaderAttributesPtr lodData = sgl::ShaderManager->createShaderAttributes(edgeShader);
+        sgl::GeometryBufferPtr geometryBuffer = uploader
+                ? uploader->upload(&loop.front(), sizeof(glm::vec2)*loop.size())
+                : sgl::Renderer->createGeometryBuffer(sizeof(glm::vec2)*loop.size(), &loop.front());
+        lodData->addGeometryBuffer(geometryBuffer, "vertexPosition", sgl::ATTRIB_FLOAT, 2);
+        lodData->setVertexMode(sgl::VERTEX_MODE_LINE_LOOP);
+        edgeData.push_back(lodData);
+    }
+    edgeDataPerShader.clear();
+    edgeDataPerShader.push_back(std::make_pair(edgeShader, edgeData));
+}
+
+void Primitive::renderEdges(int lod) {
+    sgl::Renderer->setModelMatrix(getTransform());
+    sgl::Renderer->render(edgeData.at(lod));
+}
+
+void Primitive::setEdgeShader(sgl::ShaderProgramPtr edgeShader) {
+    for (auto &shaderEdgeData : edgeDataPerShader) {
+        if (shaderEdgeData.first == edgeShader) {
+            edgeData = shaderEdgeData.second;
+            return;
+        }
+    }
+    std::vector<sgl::ShaderAttributesPtr> newEdgeData;
+    for (sgl::ShaderAttributesPtr &lodData : edgeData) {
+        newEdgeData.push_back(lodData->copy(edgeShader));
+    }
+    edgeData = newEdgeData;
+    edgeDataPerShader.push_back(std::make_pair(edgeShader, edgeData));
+}
+
+void Primitive::getWorldEdges(std::vector<glm::vec2> &worldEdges, int lod) {
+    const std::vector<glm::vec2> &loop = edgeLods.empty() ? edges : edgeLods.at(lod);
+    glm::mat4 transform = getTransform();
+    worldEdges.clear();
+    worldEdges.reserve(loop.size());
+    for (const glm::vec2 &edgePoint : loop) {
+        glm::vec4 worldPoint = transform * glm::vec4(edgePoint.x, edgePoint.y, 0.0f, 1.0f);
+        worldEdges.push_back(glm::vec2(worldPoint.x, worldPoint.y));
+    }
+}
+
+int Primitive::selectEdgeLod(const glm::vec2 &lightPos, const sgl::AABB2 &viewRect, float tolerance) {
+    if (edgeLods.size() <= 1 || tolerance <= 0.0f) {
+        return 0;
+    }
+    glm::mat4 transform = getTransform();
+    float scale = std::max(
+            glm::length(glm::vec2(transform[0].x, transform[0].y)),
+            glm::length(glm::vec2(transform[1].x, transform[1].y)));
+    glm::vec4 center = transform * glm::vec4(boundingCenter.x, boundingCenter.y, 0.0f, 1.0f);
+    float distance = glm::length(glm::vec2(center.x, center.y) - lightPos) - boundingRadius * scale;
+    if (distance <= 0.0f) {
+        // The light is (nearly) inside of the occluder
+        return 0;
+    }
+
+    glm::vec2 corners[4] = {
+            viewRect.min, glm::vec2(viewRect.max.x, viewRect.min.y),
+            viewRect.max, glm::vec2(viewRect.min.x, viewRect.max.y)
+    };
+    float maxShadowDistance = 0.0f;
+    for (const glm::vec2 &corner : corners) {
+        maxShadowDistance = std::max(maxShadowDistance, glm::length(corner - lightPos));
+    }
+    float magnification = std::max(maxShadowDistance / distance, 1.0f);
+    for (int lod = int(edgeLods.size()) - 1; lod > 0; lod--) {
+        if (edgeLodErrors.at(lod) * scale * magnification <= tolerance) {
+            return lod;
+        }
+    }
+    return 0;
+}
@@ -33,18 +33,96 @@
 #ifndef LOGIC_VOLUMELIGHT_PRIMITIVE_HPP_
 #define LOGIC_VOLUMELIGHT_PRIMITIVE_HPP_
 
+#include <vector>
+#include <utility>
 #include <boost/shared_ptr.hpp>
+#include <glm/glm.hpp>
+#include <Math/Geometry/AABB2.hpp>
+#include <Math/Geometry/MatrixUtil.hpp>
 #include <Graphics/Shader/ShaderAttributes.hpp>
+#include <Graphics/Color.hpp>
 
 class Primitive;
 typedef boost::shared_ptr<Primitive> PrimitivePtr;
+class StagingUploader;
 
 class Primitive {
 public:
     virtual ~Primitive() {}
-    virtual void render()=0;
-    virtual void renderEdges()=0;
-    virtual void setEdgeShader(sgl::ShaderProgramPtr _edgeShader)=0;
+    // Renders the filled primitive with its color (or any other color, e.g. for masks)
+    void render() { renderFilled(color); }
+    virtual void renderFilled(const sgl::Color &fillColor)=0;
+    // Renders the edge loop with the passed level of detail (0: full detail, see selectEdgeLod)
+    void renderEdges(int lod = 0);
+
+    // The edge data is bound once per edge shader (i.e., per light manager) and reused when switching back
+    void setEdgeShader(sgl::ShaderProgramPtr edgeShader);
+
+    inline void setPosition(const glm::vec2 &pos) { position = pos; }
+    inline glm::vec2 getPosition() { return position; }
+    inline glm::mat4 getTransform() { return sgl::matrixTranslation(position)*specialTransform; }
+
+    inline void setColor(const sgl::Color &col) { color = col; }
+    inline sgl::Color getColor() { return color; }
+    // Emitted light, only used by light managers with global illumination
+    inline void setEmission(const sgl::Color &col) { emission = col; }
+    inline sgl::Color getEmission() { return emission; }
+
+    // Static occluders are assumed to never change. Only dynamic ones are checked for changes every frame.
+    inline void setStatic(bool _isStatic) { isStaticPrimitive = _isStatic; }
+    inline bool isStatic() { return isStaticPrimitive; }
+
+    // Edge loop transformed to world space
+    void getWorldEdges(std::vector<glm::vec2> &worldEdges, int lod = 0);
+    inline int getNumEdgeLods() { return int(edgeLods.size()); }
+
+    /**
+     * Coarsest level of detail whose shadow edges deviate by at most "tolerance" (in world units) from the ones of the
+     * full-detail outline. An outline deviating by e at distance d from the light moves the shadow edge by up to
+     * e * D / d at distance D, where D is the distance to the farthest point of the visible rectangle.
+     */
+    int selectEdgeLod(const glm::vec2 &lightPos, const sgl::AABB2 &viewRect, float tolerance);
+
+    sgl::AABB2 getAABB() {
+        std::vector<glm::vec2> worldEdges;
+        getWorldEdges(worldEdges);
+        if (worldEdges.empty()) {
+            // Degenerate primitive (e.g., an invalid outline): An empty box at its position
+            return sgl::AABB2(position, position);
+        }
+        sgl::AABB2 aabb(worldEdges.front(), worldEdges.front());
+        for (const glm::vec2 &pt : worldEdges) {
+            aabb.min = glm::min(aabb.min, pt);
+            aabb.max = glm::max(aabb.max, pt);
+        }
+        return aabb;
+    }
+
+protected:
+    // Simplifies the edge loop (Douglas-Peucker) and creates the edge data of all levels of detail
+    void createEdgeLods(sgl::ShaderProgramPtr edgeShader);
+    // The first part of createEdgeLods without any OpenGL calls, i.e., it may run on a loader thread
+    void computeEdgeLods();
+    // The second part of createEdgeLods. With an uploader, the data is copied through its staging buffer.
+    void createEdgeData(sgl::ShaderProgramPtr edgeShader, StagingUploader *uploader = nullptr);
+    // Bytes of the vertex data of all levels of detail
+    size_t getEdgeDataSize();
+
+    std::vector<glm::vec2> edges;
+    glm::vec2 position;
+    glm::mat4 specialTransform;
+    bool isStaticPrimitive = false;
+    sgl::Color color = sgl::Color(60, 60, 60);
+    sgl::Color emission = sgl::Color(0, 0, 0);
+
+private:
+    std::vector<std::vector<glm::vec2>> edgeLods; // edgeLods[0] == edges
+    std::vector<float> edgeLodErrors; // Maximum deviation from the full-detail loop (in object space)
+    glm::vec2 boundingCenter; // Bounding circle of the edge loop (in object space)
+    float boundingRadius = 0.0f;
+
+    std::vector<sgl::ShaderAttributesPtr> edgeData; // One entry per level of detail
+    std::vector<std::pair<sgl::ShaderProgramPtr, std::vector<sgl::ShaderAttributesPtr>>> edgeDataPerShader;
 };
 
 #endif /* LOGIC_VOLUMELIGHT_PRIMITIVE_HPP_ */
@@ -0,0 +1,156 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cmath>
+#include <algorithm>
+#include <Math/Math.hpp>
+#include <glm/gtx/color_space.hpp>
+
+#include "Polygon.hpp"
+#include "SceneGenerator.hpp"
+
+GeneratedScene::GeneratedScene(const SceneGeneratorSettings &settings, const sgl::AABB2 &area,
+        sgl::ShaderProgramPtr plainShader, sgl::ShaderProgramPtr edgeShader)
+        : settings(settings), area(area), random(settings.seed) {
+    float areaWidth = area.getWidth();
+    int numClusters = std::max(int(std::sqrt(float(settings.numOccluders))) / 2, 1);
+    for (int i = 0; i < numClusters; i++) {
+        clusterCenters.push_back(glm::vec2(
+                random.getRandomFloatBetween(area.min.x, area.max.x),
+                random.getRandomFloatBetween(area.min.y, area.max.y)));
+    }
+
+    // The occluders cover about a quarter of the area
+    int numOccluders = std::max(settings.numOccluders, 0);
+    float occluderSize = std::sqrt(area.getWidth() * area.getHeight() / float(std::max(numOccluders, 1))) * 0.5f;
+    int numDynamicOccluders = int(std::round(settings.motionFraction * float(numOccluders)));
+    for (int i = 0; i < numOccluders; i++) {
+        glm::vec2 center = samplePosition(i, numOccluders);
+        float halfSize = occluderSize * random.getRandomFloatBetween(0.3f, 0.5f);
+        std::vector<glm::vec2> outline;
+        if (settings.occluderShape == OCCLUDER_BOX) {
+            glm::vec2 extent(halfSize, halfSize * random.getRandomFloatBetween(0.5f, 1.0f));
+            outline = { center - extent, glm::vec2(center.x + extent.x, center.y - extent.y),
+                        center + extent, glm::vec2(center.x - extent.x, center.y + extent.y) };
+        } else {
+            int numPoints = std::max(settings.edgesPerOccluder, 3);
+            float startAngle = random.getRandomFloatBetween(0.0f, sgl::TWO_PI);
+            for (int j = 0; j < numPoints; j++) {
+                float angle = startAngle + sgl::TWO_PI * float(j) / float(numPoints);
+                float radius = settings.occluderShape == OCCLUDER_CIRCLE
+                        ? halfSize : halfSize * random.getRandomFloatBetween(0.4f, 1.0f);
+                outline.push_back(center + radius * glm::vec2(std::cos(angle), std::sin(angle)));
+            }
+        }
+        numEdges += outline.size();
+
+        PolygonPrimitive *occluder = new PolygonPrimitive(outline);
+        occluder->upload(plainShader, edgeShader);
+        occluder->setStatic(i >= numDynamicOccluders);
+        occluders.push_back(PrimitivePtr(occluder));
+        Motion motion = { occluder->getPosition(), 0.0f, 0.0f, 0.0f };
+        if (i < numDynamicOccluders) {
+            motion.radius = occluderSize * random.getRandomFloatBetween(0.5f, 1.5f);
+            motion.angularSpeed = random.getRandomFloatBetween(0.5f, 2.0f);
+            motion.phase = random.getRandomFloatBetween(0.0f, sgl::TWO_PI);
+        }
+        occluderMotions.push_back(motion);
+    }
+
+    int numLights = std::max(settings.numLights, 0);
+    int numDynamicLights = int(std::round(settings.motionFraction * float(numLights)));
+    for (int i = 0; i < numLights; i++) {
+        glm::vec2 position(
+                random.getRandomFloatBetween(area.min.x, area.max.x),
+                random.getRandomFloatBetween(area.min.y, area.max.y));
+        float radius;
+        if (settings.lightRadiusDistribution == LIGHT_RADIUS_LOG_UNIFORM) {
+            radius = std::exp(random.getRandomFloatBetween(
+                    std::log(settings.minLightRadius), std::log(settings.maxLightRadius)));
+        } else {
+            radius = random.getRandomFloatBetween(settings.minLightRadius, settings.maxLightRadius);
+        }
+        // Dim lights, so many of them don't saturate
+        glm::vec3 hsvVec(random.getRandomFloatBetween(0.0f, 360.0f), 1.0f, 0.1f);
+        glm::vec3 rgbVec = glm::rgbColor(hsvVec);
+        VolumeLightPtr light(new VolumeLight(
+                position, radius * areaWidth, sgl::Color(rgbVec.x*255, rgbVec.y*255, rgbVec.z*255)));
+        light->setStatic(i >= numDynamicLights);
+        lights.push_back(light);
+        Motion motion = { position, 0.0f, 0.0f, 0.0f };
+        if (i < numDynamicLights) {
+            motion.radius = areaWidth * random.getRandomFloatBetween(0.05f, 0.2f);
+            motion.angularSpeed = random.getRandomFloatBetween(0.5f, 2.0f);
+            motion.phase = random.getRandomFloatBetween(0.0f, sgl::TWO_PI);
+        }
+        lightMotions.push_back(motion);
+    }
+}
+
+glm::vec2 GeneratedScene::samplePosition(int idx, int count) {
+    if (settings.distribution == DISTRIBUTION_GRID) {
+        int numColumns = std::max(int(std::ceil(std::sqrt(float(count)))), 1);
+        int numRows = (count + numColumns - 1) / numColumns;
+        glm::vec2 cellSize(area.getWidth() / float(numColumns), area.getHeight() / float(numRows));
+        glm::vec2 cell(float(idx % numColumns) + 0.5f, float(idx / numColumns) + 0.5f);
+        return area.min + cell * cellSize;
+    } else if (settings.distribution == DISTRIBUTION_CLUSTERED) {
+        // The sum of two uniform samples falls off linearly from the cluster center
+        const glm::vec2 &clusterCenter = clusterCenters.at(random.getRandomIntBetween(0, clusterCenters.size() - 1));
+        float clusterRadius = area.getWidth() / float(clusterCenters.size() + 1);
+        glm::vec2 offset(
+                random.getRandomFloatBetween(-0.5f, 0.5f) + random.getRandomFloatBetween(-0.5f, 0.5f),
+                random.getRandomFloatBetween(-0.5f, 0.5f) + random.getRandomFloatBetween(-0.5f, 0.5f));
+        return glm::clamp(clusterCenter + offset * clusterRadius, area.min, area.max);
+    }
+    return glm::vec2(
+            random.getRandomFloatBetween(area.min.x, area.max.x),
+            random.getRandomFloatBetween(area.min.y, area.max.y));
+}
+
+void GeneratedScene::animate(float time) {
+    for (size_t i = 0; i < occluders.size(); i++) {
+        const Motion &motion = occluderMotions.at(i);
+        if (motion.radius > 0.0f) {
+            float angle = motion.phase + motion.angularSpeed * time;
+            occluders.at(i)->setPosition(motion.center + motion.radius * glm::vec2(std::cos(angle), std::sin(angle)));
+        }
+    }
+    for (size_t i = 0; i < lights.size(); i++) {
+        const Motion &motion = lightMotions.at(i);
+        if (motion.radius > 0.0f) {
+            float angle = motion.phase + motion.angularSpeed * time;
+            lights.at(i)->setPosition(motion.center + motion.radius * glm::vec2(std::cos(angle), std::sin(angle)));
+        }
+    }
+}
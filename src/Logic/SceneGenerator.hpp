@@ -0,0 +1,115 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef LOGIC_SCENEGENERATOR_HPP_
+#define LOGIC_SCENEGENERATOR_HPP_
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <Math/Geometry/AABB2.hpp>
+#include <Utils/Random/Xorshift.hpp>
+#include <Graphics/Shader/ShaderManager.hpp>
+
+#include "VolumeLight.hpp"
+#include "Primitive.hpp"
+
+enum OccluderShape {
+    OCCLUDER_BOX, // Always four edges
+    OCCLUDER_CIRCLE, // Regular polygon
+    OCCLUDER_RANDOM_POLYGON // Star-shaped polygon with random radii
+};
+const char *const OCCLUDER_SHAPE_NAMES[] = {
+        "box", "circle", "polygon"
+};
+
+enum SpatialDistribution {
+    DISTRIBUTION_UNIFORM, DISTRIBUTION_CLUSTERED, DISTRIBUTION_GRID
+};
+const char *const SPATIAL_DISTRIBUTION_NAMES[] = {
+        "uniform", "clustered", "grid"
+};
+
+enum LightRadiusDistribution {
+    LIGHT_RADIUS_UNIFORM, LIGHT_RADIUS_LOG_UNIFORM // Log-uniform: As many small lights as large ones
+};
+
+struct SceneGeneratorSettings {
+    int numOccluders = 100;
+    int edgesPerOccluder = 16;
+    OccluderShape occluderShape = OCCLUDER_CIRCLE;
+    SpatialDistribution distribution = DISTRIBUTION_UNIFORM;
+    int numLights = 10;
+    float minLightRadius = 0.25f, maxLightRadius = 2.0f; // In units of the width of the area
+    LightRadiusDistribution lightRadiusDistribution = LIGHT_RADIUS_UNIFORM;
+    float motionFraction = 0.0f; // Fraction of the occluders and lights that are dynamic and move
+    uint32_t seed = 1;
+};
+
+/**
+ * Procedural stress scene for scalability measurements. The occluders are placed in an area according to the spatial
+ * distribution and sized so that they cover roughly the same fraction of the area regardless of their number.
+ * The same settings always create the same scene.
+ */
+class GeneratedScene {
+public:
+    GeneratedScene(const SceneGeneratorSettings &settings, const sgl::AABB2 &area,
+            sgl::ShaderProgramPtr plainShader, sgl::ShaderProgramPtr edgeShader);
+
+    inline std::vector<PrimitivePtr> &getOccluders() { return occluders; }
+    inline std::vector<VolumeLightPtr> &getLights() { return lights; }
+    inline size_t getNumEdges() { return numEdges; }
+
+    // Moves the dynamic occluders and lights on circles, time in seconds
+    void animate(float time);
+
+private:
+    glm::vec2 samplePosition(int idx, int count);
+
+    SceneGeneratorSettings settings;
+    sgl::AABB2 area;
+    std::vector<glm::vec2> clusterCenters;
+    sgl::XorshiftRandomGenerator random;
+
+    std::vector<PrimitivePtr> occluders;
+    std::vector<VolumeLightPtr> lights;
+    size_t numEdges = 0;
+
+    struct Motion {
+        glm::vec2 center;
+        float radius, angularSpeed, phase;
+    };
+    std::vector<Motion> occluderMotions, lightMotions; // Not moving if the radius is zero
+};
+
+#endif /* LOGIC_SCENEGENERATOR_HPP_ */
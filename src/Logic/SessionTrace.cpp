@@ -0,0 +1,266 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cstring>
+#include <cstddef>
+#include <iterator>
+#include <algorithm>
+#include <Utils/File/Logfile.hpp>
+
+#include "SessionTrace.hpp"
+
+static const char SESSION_TRACE_MAGIC[4] = {'V', 'L', 'S', 'T'};
+static const uint32_t SESSION_TRACE_VERSION = 1;
+
+static size_t getSessionEventSize(uint8_t type) {
+    switch (type) {
+    case SESSION_LIGHT_ADD:
+    case SESSION_LIGHT_CHANGE:
+        return sizeof(SessionLightState);
+    case SESSION_LIGHT_REMOVE:
+        return sizeof(SessionLightRemove);
+    case SESSION_OCCLUDER_MOVE:
+        return sizeof(SessionOccluderMove);
+    case SESSION_CAMERA_MOVE:
+        return sizeof(SessionCameraMove);
+    default:
+        return 0;
+    }
+}
+
+SessionRecorder::SessionRecorder(const std::string &filename, size_t numOccluders)
+        : file(filename.c_str(), std::ios::binary), numOccluders(numOccluders) {
+    if (!file.is_open()) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in SessionRecorder::SessionRecorder: Couldn't open "
+                + "file \"" + filename + "\" for writing.");
+        return;
+    }
+    // The number of frames is written when the recording ends
+    SessionTraceHeader header;
+    memcpy(header.magic, SESSION_TRACE_MAGIC, sizeof(header.magic));
+    header.version = SESSION_TRACE_VERSION;
+    header.numOccluders = uint32_t(numOccluders);
+    header.numFrames = 0;
+    file.write((const char*)&header, sizeof(header));
+}
+
+SessionRecorder::~SessionRecorder() {
+    if (!file.is_open()) {
+        return;
+    }
+    uint32_t numFramesValue = uint32_t(numFrames);
+    file.seekp(offsetof(SessionTraceHeader, numFrames));
+    file.write((const char*)&numFramesValue, sizeof(numFramesValue));
+    file.close();
+}
+
+void SessionRecorder::writeEvent(SessionEventType type, const void *eventData, size_t size) {
+    frameEvents.push_back(char(type));
+    frameEvents.insert(frameEvents.end(), (const char*)eventData, (const char*)eventData + size);
+    numFrameEvents++;
+}
+
+void SessionRecorder::recordFrame(float dt, const std::vector<VolumeLightPtr> &lights,
+        const std::vector<PrimitivePtr> &occluders, const glm::vec3 &cameraPosition) {
+    if (!file.is_open()) {
+        return;
+    }
+    bool firstFrame = numFrames == 0;
+    frameEvents.clear();
+    numFrameEvents = 0;
+
+    std::map<VolumeLightPtr, SessionLightState> newLightStates;
+    for (const VolumeLightPtr &light : lights) {
+        SessionLightState state;
+        auto it = lightStates.find(light);
+        state.id = it != lightStates.end() ? it->second.id : nextLightId++;
+        glm::vec2 position = light->getPosition();
+        state.position[0] = position.x;
+        state.position[1] = position.y;
+        state.radius = light->getRadius();
+        sgl::Color color = light->getColor();
+        state.color[0] = color.getR();
+        state.color[1] = color.getG();
+        state.color[2] = color.getB();
+        state.color[3] = color.getA();
+        state.isStatic = light->isStatic() ? 1 : 0;
+        newLightStates[light] = state;
+    }
+    // Removed lights first, as the replay appends added lights after the remaining ones
+    for (auto &lightState : lightStates) {
+        if (newLightStates.find(lightState.first) == newLightStates.end()) {
+            SessionLightRemove event = { lightState.second.id };
+            writeEvent(SESSION_LIGHT_REMOVE, &event, sizeof(event));
+        }
+    }
+    for (const VolumeLightPtr &light : lights) {
+        const SessionLightState &state = newLightStates[light];
+        auto it = lightStates.find(light);
+        if (it == lightStates.end()) {
+            writeEvent(SESSION_LIGHT_ADD, &state, sizeof(state));
+        } else if (memcmp(&it->second, &state, sizeof(state)) != 0) {
+            writeEvent(SESSION_LIGHT_CHANGE, &state, sizeof(state));
+        }
+    }
+    lightStates.swap(newLightStates);
+
+    occluderPositions.resize(numOccluders);
+    for (size_t i = 0; i < numOccluders && i < occluders.size(); i++) {
+        glm::vec2 position = occluders.at(i)->getPosition();
+        if (firstFrame || position != occluderPositions.at(i)) {
+            SessionOccluderMove event = { uint32_t(i), { position.x, position.y } };
+            writeEvent(SESSION_OCCLUDER_MOVE, &event, sizeof(event));
+            occluderPositions.at(i) = position;
+        }
+    }
+
+    if (firstFrame || cameraPosition != lastCameraPosition) {
+        SessionCameraMove event = { { cameraPosition.x, cameraPosition.y, cameraPosition.z } };
+        writeEvent(SESSION_CAMERA_MOVE, &event, sizeof(event));
+        lastCameraPosition = cameraPosition;
+    }
+
+    SessionFrameHeader frameHeader = { dt, numFrameEvents };
+    file.write((const char*)&frameHeader, sizeof(frameHeader));
+    if (!frameEvents.empty()) {
+        file.write(&frameEvents.front(), frameEvents.size());
+    }
+    numFrames++;
+}
+
+
+bool SessionReplayer::read(void *dest, size_t size) {
+    if (offset + size > data.size()) {
+        return false;
+    }
+    memcpy(dest, &data.at(offset), size);
+    offset += size;
+    return true;
+}
+
+bool SessionReplayer::load(const std::string &filename) {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in SessionReplayer::load: Couldn't open file \""
+                + filename + "\".");
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    offset = 0;
+
+    // Validate all frames up front, so a replay never stops in the middle of a measurement
+    SessionTraceHeader header;
+    bool valid = read(&header, sizeof(header)) && memcmp(header.magic, SESSION_TRACE_MAGIC, sizeof(header.magic)) == 0
+            && header.version == SESSION_TRACE_VERSION;
+    recordedDuration = 0.0;
+    for (uint32_t frame = 0; valid && frame < header.numFrames; frame++) {
+        SessionFrameHeader frameHeader;
+        valid = read(&frameHeader, sizeof(frameHeader));
+        recordedDuration += valid ? double(frameHeader.dt) : 0.0;
+        for (uint32_t i = 0; valid && i < frameHeader.numEvents; i++) {
+            uint8_t type = 0;
+            valid = read(&type, 1);
+            size_t eventSize = getSessionEventSize(type);
+            valid = valid && eventSize > 0 && offset + eventSize <= data.size();
+            offset += eventSize;
+        }
+    }
+    if (!valid || offset != data.size()) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in SessionReplayer::load: Invalid session trace \""
+                + filename + "\".");
+        data.clear();
+        numFrames = 0;
+        return false;
+    }
+    numFrames = header.numFrames;
+    numOccluders = header.numOccluders;
+    restart();
+    return true;
+}
+
+void SessionReplayer::restart() {
+    offset = sizeof(SessionTraceHeader);
+    frameIdx = 0;
+    replayedLights.clear();
+}
+
+bool SessionReplayer::replayFrame(std::vector<VolumeLightPtr> &lights, std::vector<PrimitivePtr> &occluders,
+        sgl::CameraPtr camera) {
+    if (frameIdx >= numFrames) {
+        return false;
+    }
+    if (frameIdx == 0) {
+        lights.clear();
+    }
+    SessionFrameHeader frameHeader;
+    read(&frameHeader, sizeof(frameHeader));
+    for (uint32_t i = 0; i < frameHeader.numEvents; i++) {
+        uint8_t type = 0;
+        read(&type, 1);
+        if (type == SESSION_LIGHT_ADD || type == SESSION_LIGHT_CHANGE) {
+            SessionLightState state;
+            read(&state, sizeof(state));
+            glm::vec2 position(state.position[0], state.position[1]);
+            sgl::Color color(state.color[0], state.color[1], state.color[2], state.color[3]);
+            VolumeLightPtr &light = replayedLights[state.id];
+            if (!light) {
+                light = VolumeLightPtr(new VolumeLight(position, state.radius, color));
+                lights.push_back(light);
+            }
+            light->setPosition(position);
+            light->setRadius(state.radius);
+            light->setColor(color);
+            light->setStatic(state.isStatic != 0);
+        } else if (type == SESSION_LIGHT_REMOVE) {
+            SessionLightRemove event;
+            read(&event, sizeof(event));
+            auto it = replayedLights.find(event.id);
+            if (it != replayedLights.end()) {
+                lights.erase(std::remove(lights.begin(), lights.end(), it->second), lights.end());
+                replayedLights.erase(it);
+            }
+        } else if (type == SESSION_OCCLUDER_MOVE) {
+            SessionOccluderMove event;
+            read(&event, sizeof(event));
+            if (event.index < occluders.size()) {
+                occluders.at(event.index)->setPosition(glm::vec2(event.position[0], event.position[1]));
+            }
+        } else if (type == SESSION_CAMERA_MOVE) {
+            SessionCameraMove event;
+            read(&event, sizeof(event));
+            camera->setPosition(glm::vec3(event.position[0], event.position[1], event.position[2]));
+        }
+    }
+    frameIdx++;
+    return true;
+}
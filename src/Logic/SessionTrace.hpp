@@ -0,0 +1,155 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef LOGIC_SESSIONTRACE_HPP_
+#define LOGIC_SESSIONTRACE_HPP_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <Graphics/Scene/Camera.hpp>
+
+#include "VolumeLight.hpp"
+#include "Primitive.hpp"
+
+/*
+ * Binary session trace: A SessionTraceHeader followed by one SessionFrameHeader per frame, each followed by its
+ * events. An event is its SessionEventType (one byte) followed by the matching struct. The first frame contains the
+ * complete state, all others only the changes. Values are stored bit-exact, so a replay is deterministic.
+ */
+struct SessionTraceHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t numOccluders; // Occluders of the scene the trace was recorded with
+    uint32_t numFrames;
+};
+
+struct SessionFrameHeader {
+    float dt;
+    uint32_t numEvents;
+};
+
+enum SessionEventType : uint8_t {
+    SESSION_LIGHT_ADD, SESSION_LIGHT_CHANGE, SESSION_LIGHT_REMOVE, SESSION_OCCLUDER_MOVE, SESSION_CAMERA_MOVE
+};
+
+// SESSION_LIGHT_ADD and SESSION_LIGHT_CHANGE
+struct SessionLightState {
+    uint32_t id;
+    float position[2];
+    float radius;
+    uint8_t color[4];
+    uint32_t isStatic;
+};
+
+// SESSION_LIGHT_REMOVE
+struct SessionLightRemove {
+    uint32_t id;
+};
+
+// SESSION_OCCLUDER_MOVE
+struct SessionOccluderMove {
+    uint32_t index;
+    float position[2];
+};
+
+// SESSION_CAMERA_MOVE
+struct SessionCameraMove {
+    float position[3];
+};
+
+/**
+ * Records the lights, the occluder positions and the camera once per frame. Changes are found by comparing with the
+ * state of the last frame, so no interaction needs to report its changes.
+ */
+class SessionRecorder {
+public:
+    SessionRecorder(const std::string &filename, size_t numOccluders);
+    // Writes the number of frames into the header
+    ~SessionRecorder();
+    inline bool isOpen() { return file.is_open(); }
+    inline size_t getNumFrames() { return numFrames; }
+
+    void recordFrame(float dt, const std::vector<VolumeLightPtr> &lights, const std::vector<PrimitivePtr> &occluders,
+            const glm::vec3 &cameraPosition);
+
+private:
+    void writeEvent(SessionEventType type, const void *eventData, size_t size);
+
+    std::ofstream file;
+    size_t numOccluders;
+    size_t numFrames = 0;
+    std::vector<char> frameEvents;
+    uint32_t numFrameEvents = 0;
+
+    // State of the last frame
+    uint32_t nextLightId = 0;
+    std::map<VolumeLightPtr, SessionLightState> lightStates; // Keeps the lights alive, so addresses aren't reused
+    std::vector<glm::vec2> occluderPositions;
+    glm::vec3 lastCameraPosition;
+};
+
+/**
+ * Plays a session trace back one frame at a time. The whole trace is read up front, so no file accesses happen while
+ * the frames are measured.
+ */
+class SessionReplayer {
+public:
+    bool load(const std::string &filename);
+    inline size_t getNumFrames() { return numFrames; }
+    inline size_t getNumOccluders() { return numOccluders; }
+    // Total of the time steps of the recorded frames
+    inline double getRecordedDuration() { return recordedDuration; }
+
+    // Starts at the first frame again, which replaces all lights
+    void restart();
+    // Applies the changes of the next frame. Returns false at the end of the trace.
+    bool replayFrame(std::vector<VolumeLightPtr> &lights, std::vector<PrimitivePtr> &occluders,
+            sgl::CameraPtr camera);
+
+private:
+    bool read(void *dest, size_t size);
+
+    std::vector<char> data;
+    size_t offset = 0;
+    size_t frameIdx = 0;
+    size_t numFrames = 0;
+    size_t numOccluders = 0;
+    double recordedDuration = 0.0;
+    std::map<uint32_t, VolumeLightPtr> replayedLights;
+};
+
+#endif /* LOGIC_SESSIONTRACE_HPP_ */
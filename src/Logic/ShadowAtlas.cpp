@@ -0,0 +1,97 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <GL/glew.h>
+
+#include <Graphics/Renderer.hpp>
+#include <Graphics/OpenGL/Texture.hpp>
+
+#include "ShadowAtlas.hpp"
+
+void ShadowAtlas::pack(const std::vector<int> &widths, int atlasWidth, int depthFormat) {
+    // Next fit decreasing: Most widths are powers of two, so the rows are filled (nearly) without gaps
+    sortedIndices.resize(widths.size());
+    for (size_t i = 0; i < widths.size(); i++) {
+        sortedIndices.at(i) = i;
+    }
+    std::sort(sortedIndices.begin(), sortedIndices.end(), [&widths](size_t a, size_t b) {
+        return widths.at(a) > widths.at(b);
+    });
+
+    regions.resize(widths.size());
+    numUsedTexels = 0;
+    int x = 0, row = 0;
+    for (size_t i : sortedIndices) {
+        int regionWidth = std::min(widths.at(i), atlasWidth);
+        if (x + regionWidth > atlasWidth) {
+            x = 0;
+            row++;
+        }
+        regions.at(i) = { x, row, regionWidth };
+        x += regionWidth;
+        numUsedTexels += regionWidth;
+    }
+    int numRows = widths.empty() ? 1 : row + 1;
+
+    // Hysteresis, so that lights coming and going don't reallocate the texture every frame
+    if (!texture || atlasWidth != width || depthFormat != format || numRows > height || numRows * 4 <= height) {
+        width = atlasWidth;
+        format = depthFormat;
+        height = 1;
+        while (height < numRows * 2) {
+            height *= 2;
+        }
+        createTexture();
+    }
+}
+
+void ShadowAtlas::createTexture() {
+    GLuint textureID = 0;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, format, width, height, 3);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    sgl::TextureSettings settings(
+            sgl::TEXTURE_2D_ARRAY, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+    settings.internalFormat = format;
+    texture = sgl::TexturePtr(new sgl::TextureGL(textureID, width, height, 16, settings));
+    fbo = sgl::Renderer->createFBO();
+    fbo->bindTexture(texture, sgl::DEPTH_ATTACHMENT);
+    renderTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
+    renderTarget->bindFramebufferObject(fbo);
+}
@@ -0,0 +1,77 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOGIC_SHADOWATLAS_HPP_
+#define LOGIC_SHADOWATLAS_HPP_
+
+#include <vector>
+#include <Graphics/Buffers/FBO.hpp>
+#include <Graphics/Texture/TextureManager.hpp>
+#include <Graphics/Scene/RenderTarget.hpp>
+
+// Part of a row of the atlas (in texels). The same region is used in all three layers (one per light camera).
+struct ShadowAtlasRegion {
+    int x, row, width;
+};
+
+/**
+ * One depth texture array holding the 1D shadow maps of all lights rendered in a frame.
+ * Every light gets a part of a row sized to its needs. The regions are packed again every frame, and the texture
+ * only grows or shrinks if the number of needed rows changes by more than a factor of two.
+ */
+class ShadowAtlas {
+public:
+    // Assigns a region to each of the passed widths (in the same order) and reallocates the texture if needed
+    void pack(const std::vector<int> &widths, int atlasWidth, int depthFormat);
+    inline const ShadowAtlasRegion &getRegion(size_t i) { return regions.at(i); }
+
+    inline sgl::TexturePtr getTexture() { return texture; }
+    inline sgl::RenderTargetPtr getRenderTarget() { return renderTarget; }
+    inline int getWidth() { return width; }
+    inline int getHeight() { return height; }
+    // Number of texels of all regions (per layer), i.e., the part of the atlas that is actually used
+    inline int getNumUsedTexels() { return numUsedTexels; }
+
+private:
+    void createTexture();
+
+    std::vector<ShadowAtlasRegion> regions;
+    std::vector<size_t> sortedIndices;
+    int numUsedTexels = 0;
+
+    int width = 0, height = 0, format = 0;
+    sgl::TexturePtr texture;
+    sgl::FramebufferObjectPtr fbo;
+    sgl::RenderTargetPtr renderTarget;
+};
+
+#endif /* LOGIC_SHADOWATLAS_HPP_ */
@@ -0,0 +1,120 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <GL/glew.h>
+
+#include <Graphics/Renderer.hpp>
+#include <Graphics/Texture/TextureManager.hpp>
+#include <Math/Geometry/MatrixUtil.hpp>
+
+#include "StaticLightCache.hpp"
+
+StaticLightCache::StaticLightCache() : valid(false) {
+    cacheTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
+}
+
+void StaticLightCache::onResolutionChanged(int width, int height, GLint internalFormat) {
+    sgl::TextureSettings settings;
+    settings.internalFormat = internalFormat;
+    settings.pixelType = internalFormat == GL_RGBA8 ? GL_UNSIGNED_BYTE : GL_FLOAT;
+    cacheFBO = sgl::Renderer->createFBO();
+    cacheTex = sgl::TextureManager->createEmptyTexture(width, height, settings);
+    cacheFBO->bindTexture(cacheTex);
+    cacheTarget->bindFramebufferObject(cacheFBO);
+    valid = false;
+}
+
+bool StaticLightCache::lightStateEquals(const LightState &state, VolumeLightPtr &light) {
+    sgl::Color color = light->getColor();
+    return state.light == light.get() && state.position == light->getPosition() && state.radius == light->getRadius()
+            && state.color.getR() == color.getR() && state.color.getG() == color.getG()
+            && state.color.getB() == color.getB() && state.color.getA() == color.getA();
+}
+
+bool StaticLightCache::needsUpdate(std::vector<VolumeLightPtr> &lights, const glm::mat4 &viewProjMatrix) {
+    if (!valid || viewProjMatrix != cachedViewProjMatrix) {
+        return true;
+    }
+
+    // Compare the static lights in order with the state they had when the cache was rendered
+    size_t cachedLightIdx = 0;
+    for (VolumeLightPtr &light : lights) {
+        if (!light->isStatic()) {
+            continue;
+        }
+        if (cachedLightIdx >= cachedLights.size() || !lightStateEquals(cachedLights.at(cachedLightIdx), light)) {
+            return true;
+        }
+        cachedLightIdx++;
+    }
+    return cachedLightIdx != cachedLights.size();
+}
+
+void StaticLightCache::invalidateRegion(const sgl::AABB2 &region) {
+    for (LightState &state : cachedLights) {
+        // Distance of the light position to the closest point in the region
+        glm::vec2 closestPoint = glm::clamp(state.position, region.min, region.max);
+        if (glm::distance(closestPoint, state.position) <= state.radius) {
+            valid = false;
+            return;
+        }
+    }
+}
+
+void StaticLightCache::beginUpdate() {
+    cacheTarget->bindRenderTarget();
+    sgl::Renderer->clearFramebuffer(GL_COLOR_BUFFER_BIT, sgl::Color(0, 0, 0));
+}
+
+void StaticLightCache::endUpdate(std::vector<VolumeLightPtr> &lights, const glm::mat4 &viewProjMatrix) {
+    cachedLights.clear();
+    for (VolumeLightPtr &light : lights) {
+        if (light->isStatic()) {
+            LightState state;
+            state.light = light.get();
+            state.position = light->getPosition();
+            state.radius = light->getRadius();
+            state.color = light->getColor();
+            cachedLights.push_back(state);
+        }
+    }
+    cachedViewProjMatrix = viewProjMatrix;
+    valid = true;
+}
+
+void StaticLightCache::blitCachedLights() {
+    sgl::Renderer->setBlendMode(sgl::BLEND_OVERWRITE);
+    sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+    sgl::Renderer->blitTexture(cacheTex, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
+}
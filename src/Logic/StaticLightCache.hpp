@@ -0,0 +1,87 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOGIC_STATICLIGHTCACHE_HPP_
+#define LOGIC_STATICLIGHTCACHE_HPP_
+
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <Math/Geometry/AABB2.hpp>
+#include <Graphics/Scene/RenderTarget.hpp>
+#include "VolumeLight.hpp"
+
+/**
+ * Holds the accumulated contribution of all static lights in a screen-sized texture.
+ * The texture only needs to be rendered again if a static light was added, removed or modified, if an occluder
+ * changed within the radius of a static light, or if the camera or the resolution changed.
+ */
+class StaticLightCache {
+public:
+    StaticLightCache();
+    // The cache has the format of the light buffer it is copied to
+    void onResolutionChanged(int width, int height, GLint internalFormat = GL_RGBA8);
+
+    // Returns true if the cached texture doesn't match the passed static lights and camera anymore
+    bool needsUpdate(std::vector<VolumeLightPtr> &lights, const glm::mat4 &viewProjMatrix);
+    void invalidate() { valid = false; }
+    void invalidateRegion(const sgl::AABB2 &region);
+
+    // Binds and clears the cache render target. The static lights are then rendered by the light manager.
+    void beginUpdate();
+    void endUpdate(std::vector<VolumeLightPtr> &lights, const glm::mat4 &viewProjMatrix);
+
+    // Copies the cached lighting to the currently bound render target
+    void blitCachedLights();
+
+    inline sgl::RenderTargetPtr getRenderTarget() { return cacheTarget; }
+    inline sgl::TexturePtr getTexture() { return cacheTex; }
+
+private:
+    struct LightState {
+        VolumeLight *light;
+        glm::vec2 position;
+        float radius;
+        sgl::Color color;
+    };
+    static bool lightStateEquals(const LightState &state, VolumeLightPtr &light);
+
+    bool valid;
+    std::vector<LightState> cachedLights;
+    glm::mat4 cachedViewProjMatrix;
+
+    sgl::RenderTargetPtr cacheTarget;
+    sgl::FramebufferObjectPtr cacheFBO;
+    sgl::TexturePtr cacheTex;
+};
+
+#endif /* LOGIC_STATICLIGHTCACHE_HPP_ */
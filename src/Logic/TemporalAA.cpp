@@ -0,0 +1,114 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Graphics/Renderer.hpp>
+#include <Math/Geometry/MatrixUtil.hpp>
+
+#include "Utils/Profiler.hpp"
+#include "Utils/ShaderCache.hpp"
+#include "LightManagerInterface.hpp"
+#include "TemporalAA.hpp"
+
+// Weight of the current frame. Lower values converge to smoother edges, but take longer to follow changes.
+const float TAA_BLEND_FACTOR = 0.1f;
+// Length of the jitter sequence
+const int NUM_JITTER_PHASES = 8;
+
+// Low-discrepancy sequence in [0,1), i.e., consecutive offsets cover the pixel evenly
+static float halton(int index, int base) {
+    float result = 0.0f;
+    float fraction = 1.0f;
+    while (index > 0) {
+        fraction /= float(base);
+        result += fraction * float(index % base);
+        index /= base;
+    }
+    return result;
+}
+
+TemporalAA::TemporalAA() {
+    resolveShader = ShaderCache::get()->getShaderProgram({"TemporalAA.Vertex", "TemporalAA.Fragment"});
+    resolveShader->setUniform("blendFactor", TAA_BLEND_FACTOR);
+    quadRenderData = createFullscreenQuadRenderData(
+            resolveShader, sgl::AABB2(glm::vec2(-1, -1), glm::vec2(1, 1)));
+}
+
+void TemporalAA::onResolutionChanged(int width, int height) {
+    this->width = width;
+    this->height = height;
+
+    sgl::TextureSettings settings;
+    settings.internalFormat = GL_RGBA16F;
+    settings.pixelType = GL_FLOAT;
+    for (int i = 0; i < 2; i++) {
+        historyTextures[i] = sgl::TextureManager->createEmptyTexture(width, height, settings);
+        historyFBOs[i] = sgl::Renderer->createFBO();
+        historyFBOs[i]->bindTexture(historyTextures[i]);
+    }
+    historyValid = false;
+}
+
+FrameGraphTextureDesc TemporalAA::getHistoryDesc() {
+    return FrameGraphTextureDesc(width, height, GL_RGBA16F);
+}
+
+glm::vec2 TemporalAA::getJitter() {
+    // The sequence starts at 1, as index 0 would be the pixel corner in both dimensions
+    int phase = frameIndex % NUM_JITTER_PHASES + 1;
+    glm::vec2 pixelOffset(halton(phase, 2) - 0.5f, halton(phase, 3) - 0.5f);
+    return glm::vec2(2.0f * pixelOffset.x / float(width), 2.0f * pixelOffset.y / float(height));
+}
+
+sgl::TexturePtr TemporalAA::resolve(sgl::TexturePtr currentTexture, const glm::mat4 &viewProjMatrix) {
+    PROFILE_SCOPE("TemporalAA::resolve");
+    sgl::Renderer->bindFBO(historyFBOs[currentHistory]);
+    sgl::Renderer->setBlendMode(sgl::BLEND_OVERWRITE);
+    sgl::Renderer->setProjectionMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setViewMatrix(sgl::matrixIdentity());
+    sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
+    resolveShader->setUniform("viewProjMatrix", viewProjMatrix);
+    resolveShader->setUniform("invViewProjMatrix", glm::inverse(viewProjMatrix));
+    resolveShader->setUniform("prevViewProjMatrix", historyValid ? prevViewProjMatrix : viewProjMatrix);
+    resolveShader->setUniform("historyValid", historyValid);
+    resolveShader->setUniform("currentTexture", currentTexture, 0);
+    resolveShader->setUniform("historyTexture", historyTextures[1 - currentHistory], 1);
+    sgl::Renderer->render(quadRenderData);
+    sgl::Renderer->setBlendMode(sgl::BLEND_ALPHA);
+    sgl::Renderer->unbindFBO();
+
+    sgl::TexturePtr result = historyTextures[currentHistory];
+    currentHistory = 1 - currentHistory;
+    prevViewProjMatrix = viewProjMatrix;
+    historyValid = true;
+    frameIndex++;
+    return result;
+}
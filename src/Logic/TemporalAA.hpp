@@ -0,0 +1,82 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOGIC_TEMPORALAA_HPP_
+#define LOGIC_TEMPORALAA_HPP_
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <Graphics/Shader/ShaderManager.hpp>
+#include <Graphics/Shader/ShaderAttributes.hpp>
+#include <Graphics/Texture/TextureManager.hpp>
+#include <Graphics/Buffers/FBO.hpp>
+#include "Utils/FrameGraph.hpp"
+
+/**
+ * Temporal antialiasing of a light buffer. The light pass is rendered with a different sub-pixel offset (jitter) in
+ * every frame, and TemporalAA.glsl blends the result into a history texture. The history is reprojected if the camera
+ * moved and clamped to the neighborhood of the pixel in the current frame, so moving lights and occluders don't ghost.
+ * Over a few frames, the shadow edges converge to about the quality of 8x MSAA at the cost of one sample.
+ */
+class TemporalAA {
+public:
+    TemporalAA();
+    void onResolutionChanged(int width, int height);
+    // Restarts the accumulation (e.g., if the light buffer wasn't rendered in the last frame)
+    inline void invalidate() { historyValid = false; }
+
+    // Offset of the light pass in the current frame in normalized device coordinates
+    glm::vec2 getJitter();
+    // The history written by the next resolve and the one it reads (swapped after every resolve)
+    inline sgl::TexturePtr getHistoryTexture() { return historyTextures[currentHistory]; }
+    inline sgl::TexturePtr getPreviousHistoryTexture() { return historyTextures[1 - currentHistory]; }
+    FrameGraphTextureDesc getHistoryDesc();
+
+    // Blends the light of the current frame (rendered with getJitter) into the history and returns the result.
+    // viewProjMatrix is the one of the camera without the jitter.
+    sgl::TexturePtr resolve(sgl::TexturePtr currentTexture, const glm::mat4 &viewProjMatrix);
+
+private:
+    int width = 0, height = 0;
+    sgl::ShaderProgramPtr resolveShader;
+    sgl::ShaderAttributesPtr quadRenderData;
+
+    // 8-bit histories can't converge with small blend factors, so they always use half floats
+    sgl::TexturePtr historyTextures[2];
+    sgl::FramebufferObjectPtr historyFBOs[2];
+    int currentHistory = 0;
+    bool historyValid = false;
+    glm::mat4 prevViewProjMatrix;
+    int frameIndex = 0;
+};
+
+#endif /* LOGIC_TEMPORALAA_HPP_ */
@@ -0,0 +1,276 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <set>
+#include <cmath>
+#include <algorithm>
+#include "VisibilityPolygon.hpp"
+
+static const float PI_F = 3.14159265358979f;
+
+static inline float cross2(const glm::vec2 &a, const glm::vec2 &b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+// Distance from the center to the segment along the ray with the passed angle
+static inline float rayDistance(const glm::vec2 &center, const VisibilityScratch::Segment &segment, float angle) {
+    glm::vec2 direction(std::cos(angle), std::sin(angle));
+    glm::vec2 segmentDirection = segment.pt1 - segment.pt0;
+    float denominator = cross2(direction, segmentDirection);
+    if (denominator == 0.0f) {
+        return glm::min(glm::length(segment.pt0 - center), glm::length(segment.pt1 - center));
+    }
+    return cross2(segment.pt0 - center, segmentDirection) / denominator;
+}
+
+static void addSegment(const glm::vec2 &center, glm::vec2 pt0, glm::vec2 pt1, VisibilityScratch &scratch) {
+    glm::vec2 dir0 = pt0 - center, dir1 = pt1 - center;
+    if (std::abs(cross2(dir0, dir1)) <= 1e-12f * glm::dot(dir0, dir0) * glm::dot(dir1, dir1)
+            && glm::dot(dir0, dir1) >= 0.0f) {
+        // Collinear with the center, covers no angle
+        return;
+    }
+
+    float angle0 = std::atan2(dir0.y, dir0.x), angle1 = std::atan2(dir1.y, dir1.x);
+    if (std::abs(angle0 - angle1) > PI_F) {
+        // The segment crosses the start/end angle of the sweep (the negative x axis from the center)
+        if (dir0.y == 0.0f) {
+            angle0 = angle1 < 0.0f ? -PI_F : PI_F;
+        } else if (dir1.y == 0.0f) {
+            angle1 = angle0 < 0.0f ? -PI_F : PI_F;
+        } else {
+            // Split at the negative x axis
+            float t = dir0.y / (dir0.y - dir1.y);
+            glm::vec2 splitPoint = pt0 + t * (pt1 - pt0);
+            splitPoint.y = center.y;
+            addSegment(center, pt0, splitPoint, scratch);
+            addSegment(center, splitPoint, pt1, scratch);
+            return;
+        }
+    }
+
+    VisibilityScratch::Segment segment;
+    segment.pt0 = pt0;
+    segment.pt1 = pt1;
+    segment.angleBegin = std::min(angle0, angle1);
+    segment.angleEnd = std::max(angle0, angle1);
+    if (segment.angleBegin == segment.angleEnd) {
+        return;
+    }
+    int segmentIndex = int(scratch.segments.size());
+    scratch.segments.push_back(segment);
+    scratch.events.push_back({ segment.angleBegin, false, segmentIndex });
+    scratch.events.push_back({ segment.angleEnd, true, segmentIndex });
+}
+
+/**
+ * Splits the segments (line list) where they intersect or where an end point touches the interior of another segment.
+ * A uniform grid over the bounding box limits the tested pairs, so scenes without intersections stay close to O(n).
+ */
+static void splitIntersectingSegments(const std::vector<glm::vec2> &segmentPoints, VisibilityScratch &scratch) {
+    const float epsilon = 1e-5f;
+    int numSegments = int(segmentPoints.size() / 2);
+    scratch.splitPoints.clear();
+    scratch.splits.clear();
+    if (numSegments < 2) {
+        scratch.splitPoints.assign(segmentPoints.begin(), segmentPoints.begin() + numSegments * 2);
+        return;
+    }
+
+    glm::vec2 boxMin = segmentPoints.front(), boxMax = segmentPoints.front();
+    for (const glm::vec2 &pt : segmentPoints) {
+        boxMin = glm::min(boxMin, pt);
+        boxMax = glm::max(boxMax, pt);
+    }
+    int gridSize = std::min(std::max(int(std::sqrt(float(numSegments))), 1), 256);
+    glm::vec2 cellScale = float(gridSize) / glm::max(boxMax - boxMin, glm::vec2(1e-12f));
+    scratch.gridCells.resize(size_t(gridSize * gridSize));
+    for (std::vector<int> &cell : scratch.gridCells) {
+        cell.clear();
+    }
+    auto getCell = [&](float value, float min, float scale) {
+        return std::min(std::max(int((value - min) * scale), 0), gridSize - 1);
+    };
+    for (int i = 0; i < numSegments; i++) {
+        glm::vec2 segmentMin = glm::min(segmentPoints.at(i * 2), segmentPoints.at(i * 2 + 1));
+        glm::vec2 segmentMax = glm::max(segmentPoints.at(i * 2), segmentPoints.at(i * 2 + 1));
+        for (int y = getCell(segmentMin.y, boxMin.y, cellScale.y); y <= getCell(segmentMax.y, boxMin.y, cellScale.y);
+                y++) {
+            for (int x = getCell(segmentMin.x, boxMin.x, cellScale.x);
+                    x <= getCell(segmentMax.x, boxMin.x, cellScale.x); x++) {
+                scratch.gridCells.at(size_t(y * gridSize + x)).push_back(i);
+            }
+        }
+    }
+
+    // Pairs sharing several cells are tested several times, which only adds duplicate split parameters
+    for (const std::vector<int> &cell : scratch.gridCells) {
+        for (size_t a = 0; a < cell.size(); a++) {
+            for (size_t b = a + 1; b < cell.size(); b++) {
+                int i = cell.at(a), j = cell.at(b);
+                glm::vec2 p = segmentPoints.at(i * 2), r = segmentPoints.at(i * 2 + 1) - p;
+                glm::vec2 q = segmentPoints.at(j * 2), s = segmentPoints.at(j * 2 + 1) - q;
+                float denominator = cross2(r, s);
+                if (std::abs(denominator) <= 1e-12f) {
+                    // Parallel segments don't cross
+                    continue;
+                }
+                float t = cross2(q - p, s) / denominator;
+                float u = cross2(q - p, r) / denominator;
+                bool tInside = t > epsilon && t < 1.0f - epsilon, uInside = u > epsilon && u < 1.0f - epsilon;
+                bool tOnSegment = t >= -epsilon && t <= 1.0f + epsilon;
+                bool uOnSegment = u >= -epsilon && u <= 1.0f + epsilon;
+                if (tInside && uOnSegment) {
+                    scratch.splits.push_back(std::make_pair(i, t));
+                }
+                if (uInside && tOnSegment) {
+                    scratch.splits.push_back(std::make_pair(j, u));
+                }
+            }
+        }
+    }
+
+    std::sort(scratch.splits.begin(), scratch.splits.end());
+    size_t splitIdx = 0;
+    for (int i = 0; i < numSegments; i++) {
+        glm::vec2 pt0 = segmentPoints.at(i * 2), pt1 = segmentPoints.at(i * 2 + 1);
+        float lastT = 0.0f;
+        for (; splitIdx < scratch.splits.size() && scratch.splits.at(splitIdx).first == i; splitIdx++) {
+            float t = scratch.splits.at(splitIdx).second;
+            if (t - lastT > epsilon) {
+                scratch.splitPoints.push_back(pt0 + lastT * (pt1 - pt0));
+                scratch.splitPoints.push_back(pt0 + t * (pt1 - pt0));
+                lastT = t;
+            }
+        }
+        scratch.splitPoints.push_back(pt0 + lastT * (pt1 - pt0));
+        scratch.splitPoints.push_back(pt1);
+    }
+}
+
+/**
+ * Orders the active segments by their distance to the center. All active segments overlap the current sweep angle
+ * and don't intersect, so their order is the same at every angle they share. The segments are compared in the middle
+ * of their common angle range to be independent of shared end points.
+ */
+struct SegmentDistanceComparator {
+    const glm::vec2 *center;
+    const std::vector<VisibilityScratch::Segment> *segments;
+    bool operator()(int index0, int index1) const {
+        if (index0 == index1) {
+            return false;
+        }
+        const VisibilityScratch::Segment &segment0 = segments->at(index0);
+        const VisibilityScratch::Segment &segment1 = segments->at(index1);
+        float angle = 0.5f * (std::max(segment0.angleBegin, segment1.angleBegin)
+                + std::min(segment0.angleEnd, segment1.angleEnd));
+        float distance0 = rayDistance(*center, segment0, angle);
+        float distance1 = rayDistance(*center, segment1, angle);
+        if (distance0 != distance1) {
+            return distance0 < distance1;
+        }
+        return index0 < index1;
+    }
+};
+
+void computeVisibilityPolygon(
+        const glm::vec2 &center, const std::vector<glm::vec2> &segmentPoints, const sgl::AABB2 &bounds,
+        VisibilityScratch &scratch, std::vector<glm::vec2> &triangleFan) {
+    scratch.segments.clear();
+    scratch.events.clear();
+    triangleFan.clear();
+
+    // The bounding box guarantees that every ray hits a segment. It may not intersect any of the occluder segments.
+    glm::vec2 boxMin = glm::min(bounds.min, center), boxMax = glm::max(bounds.max, center);
+    for (const glm::vec2 &pt : segmentPoints) {
+        boxMin = glm::min(boxMin, pt);
+        boxMax = glm::max(boxMax, pt);
+    }
+    boxMin -= glm::vec2(1e-3f);
+    boxMax += glm::vec2(1e-3f);
+    glm::vec2 corners[4] = { boxMin, glm::vec2(boxMax.x, boxMin.y), boxMax, glm::vec2(boxMin.x, boxMax.y) };
+    for (int i = 0; i < 4; i++) {
+        addSegment(center, corners[i], corners[(i + 1) % 4], scratch);
+    }
+    // The ordering of the active segments is only consistent if no two of them cross
+    splitIntersectingSegments(segmentPoints, scratch);
+    for (size_t i = 0; i + 1 < scratch.splitPoints.size(); i += 2) {
+        addSegment(center, scratch.splitPoints.at(i), scratch.splitPoints.at(i + 1), scratch);
+    }
+
+    // Segments ending at an angle are removed before the ones beginning there are added
+    std::sort(scratch.events.begin(), scratch.events.end(),
+            [](const VisibilityScratch::Event &event0, const VisibilityScratch::Event &event1) {
+        if (event0.angle != event1.angle) {
+            return event0.angle < event1.angle;
+        }
+        return event0.isEnd && !event1.isEnd;
+    });
+
+    SegmentDistanceComparator comparator = { &center, &scratch.segments };
+    std::set<int, SegmentDistanceComparator> activeSegments(comparator);
+    std::vector<std::set<int, SegmentDistanceComparator>::iterator> segmentIterators(scratch.segments.size());
+
+    triangleFan.push_back(center);
+    size_t eventIdx = 0;
+    while (eventIdx < scratch.events.size()) {
+        float angle = scratch.events.at(eventIdx).angle;
+        int nearestBefore = activeSegments.empty() ? -1 : *activeSegments.begin();
+        for (; eventIdx < scratch.events.size() && scratch.events.at(eventIdx).angle == angle; eventIdx++) {
+            const VisibilityScratch::Event &event = scratch.events.at(eventIdx);
+            if (event.isEnd) {
+                activeSegments.erase(segmentIterators.at(event.segmentIndex));
+            } else {
+                segmentIterators.at(event.segmentIndex) = activeSegments.insert(event.segmentIndex).first;
+            }
+        }
+        int nearestAfter = activeSegments.empty() ? -1 : *activeSegments.begin();
+
+        // The visible segment changed: Add the points where the ray hits the old and the new one
+        if (nearestBefore != nearestAfter) {
+            glm::vec2 direction(std::cos(angle), std::sin(angle));
+            if (nearestBefore >= 0) {
+                triangleFan.push_back(center + direction * rayDistance(
+                        center, scratch.segments.at(nearestBefore), angle));
+            }
+            if (nearestAfter >= 0) {
+                triangleFan.push_back(center + direction * rayDistance(
+                        center, scratch.segments.at(nearestAfter), angle));
+            }
+        }
+    }
+
+    // Close the fan
+    if (triangleFan.size() > 1) {
+        triangleFan.push_back(triangleFan.at(1));
+    }
+}
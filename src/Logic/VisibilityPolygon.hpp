@@ -0,0 +1,73 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOGIC_VISIBILITYPOLYGON_HPP_
+#define LOGIC_VISIBILITYPOLYGON_HPP_
+
+#include <vector>
+#include <utility>
+#include <glm/glm.hpp>
+#include <Math/Geometry/AABB2.hpp>
+
+/**
+ * Reusable buffers for computeVisibilityPolygon. Keep one per thread to avoid allocations in every call.
+ */
+struct VisibilityScratch {
+    struct Segment {
+        glm::vec2 pt0, pt1;
+        float angleBegin, angleEnd;
+    };
+    struct Event {
+        float angle;
+        bool isEnd;
+        int segmentIndex;
+    };
+    std::vector<Segment> segments;
+    std::vector<Event> events;
+    // Splitting of intersecting segments
+    std::vector<glm::vec2> splitPoints;
+    std::vector<std::pair<int, float>> splits; // Segment index and parameter along the segment
+    std::vector<std::vector<int>> gridCells;
+};
+
+/**
+ * Computes the region visible from the passed point with an angular sweep over the occluder segments in
+ * O(n log n). The segments are passed as a line list. The sweep needs segments that only touch at their end points,
+ * so intersecting segments (e.g., of overlapping occluders) are split at their intersections first.
+ * The region is clipped to the passed bounds, which are extended to contain the point and the segments if necessary.
+ * The output is a triangle fan around the point (including the center and the closing vertex).
+ */
+void computeVisibilityPolygon(
+        const glm::vec2 &center, const std::vector<glm::vec2> &segmentPoints, const sgl::AABB2 &bounds,
+        VisibilityScratch &scratch, std::vector<glm::vec2> &triangleFan);
+
+#endif /* LOGIC_VISIBILITYPOLYGON_HPP_ */
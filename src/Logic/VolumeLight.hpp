@@ -53,10 +53,15 @@ public:
     inline float getRadius() { return radius; }
     inline sgl::Color getColor() { return color; }
 
+    // Static lights are accumulated once into a cached light texture (see StaticLightCache)
+    inline void setStatic(bool _isStatic) { isStaticLight = _isStatic; }
+    inline bool isStatic() { return isStaticLight; }
+
 private:
     glm::vec2 position;
     float radius;
     sgl::Color color;
+    bool isStaticLight = false;
 };
 
 typedef boost::shared_ptr<VolumeLight> VolumeLightPtr;
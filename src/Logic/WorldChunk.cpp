@@ -0,0 +1,189 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <cmath>
+#include <boost/filesystem.hpp>
+#include <Math/Math.hpp>
+#include <Utils/Convert.hpp>
+#include <Utils/Random/Xorshift.hpp>
+
+#include "WorldChunk.hpp"
+
+static const char WORLD_CHUNK_MAGIC[4] = {'V', 'L', 'W', 'C'};
+static const uint32_t WORLD_CHUNK_VERSION = 1;
+// Outlines with more points are considered to be corrupt
+static const uint32_t MAX_OUTLINE_POINTS = 1 << 16;
+
+std::string getWorldChunkFilename(const std::string &worldDirectory, const glm::ivec2 &chunkCoord) {
+    return worldDirectory + "/chunk_" + sgl::toString(chunkCoord.x) + "_" + sgl::toString(chunkCoord.y) + ".bin";
+}
+
+bool readWorldChunk(const std::string &filename, WorldChunkData &chunk) {
+    chunk.occluders.clear();
+    chunk.lights.clear();
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t offset = 0;
+    auto read = [&data, &offset](void *dest, size_t size) {
+        if (offset + size > data.size()) {
+            return false;
+        }
+        memcpy(dest, &data.at(offset), size);
+        offset += size;
+        return true;
+    };
+
+    WorldChunkHeader header;
+    if (!read(&header, sizeof(header)) || memcmp(header.magic, WORLD_CHUNK_MAGIC, sizeof(header.magic)) != 0
+            || header.version != WORLD_CHUNK_VERSION) {
+        return false;
+    }
+    for (uint32_t i = 0; i < header.numOccluders; i++) {
+        WorldChunkOccluderHeader occluderHeader;
+        if (!read(&occluderHeader, sizeof(occluderHeader)) || occluderHeader.numPoints < 3
+                || occluderHeader.numPoints > MAX_OUTLINE_POINTS) {
+            return false;
+        }
+        WorldChunkOccluder occluder;
+        occluder.outline.resize(occluderHeader.numPoints);
+        occluder.color = sgl::Color(
+                occluderHeader.color[0], occluderHeader.color[1], occluderHeader.color[2], occluderHeader.color[3]);
+        if (!read(&occluder.outline.front(), sizeof(glm::vec2) * occluderHeader.numPoints)) {
+            return false;
+        }
+        chunk.occluders.push_back(occluder);
+    }
+    if (size_t(header.numLights) * sizeof(WorldChunkLight) != data.size() - offset) {
+        return false;
+    }
+    chunk.lights.resize(header.numLights);
+    return header.numLights == 0 || read(&chunk.lights.front(), sizeof(WorldChunkLight) * header.numLights);
+}
+
+bool writeWorldChunk(const std::string &filename, const glm::ivec2 &chunkCoord, const WorldChunkData &chunk) {
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    WorldChunkHeader header;
+    memcpy(header.magic, WORLD_CHUNK_MAGIC, sizeof(header.magic));
+    header.version = WORLD_CHUNK_VERSION;
+    header.chunkX = chunkCoord.x;
+    header.chunkY = chunkCoord.y;
+    header.numOccluders = uint32_t(chunk.occluders.size());
+    header.numLights = uint32_t(chunk.lights.size());
+    file.write((const char*)&header, sizeof(header));
+    for (const WorldChunkOccluder &occluder : chunk.occluders) {
+        WorldChunkOccluderHeader occluderHeader;
+        occluderHeader.numPoints = uint32_t(occluder.outline.size());
+        sgl::Color color = occluder.color;
+        occluderHeader.color[0] = color.getR();
+        occluderHeader.color[1] = color.getG();
+        occluderHeader.color[2] = color.getB();
+        occluderHeader.color[3] = color.getA();
+        file.write((const char*)&occluderHeader, sizeof(occluderHeader));
+        file.write((const char*)&occluder.outline.front(), sizeof(glm::vec2) * occluder.outline.size());
+    }
+    if (!chunk.lights.empty()) {
+        file.write((const char*)&chunk.lights.front(), sizeof(WorldChunkLight) * chunk.lights.size());
+    }
+    return file.good();
+}
+
+bool readWorldChunkSize(const std::string &worldDirectory, float &chunkSize) {
+    std::ifstream file((worldDirectory + "/world.txt").c_str());
+    return file.is_open() && (file >> chunkSize) && chunkSize > 0.0f;
+}
+
+bool writeWorldChunkSize(const std::string &worldDirectory, float chunkSize) {
+    std::ofstream file((worldDirectory + "/world.txt").c_str());
+    file << chunkSize << "\n";
+    return file.good();
+}
+
+bool generateWorld(const std::string &worldDirectory, int numChunks, float chunkSize, uint32_t seed) {
+    const int OCCLUDERS_PER_CHUNK = 8;
+    const int LIGHTS_PER_CHUNK = 2;
+    boost::system::error_code errorCode;
+    boost::filesystem::create_directories(worldDirectory, errorCode);
+    if (errorCode || !writeWorldChunkSize(worldDirectory, chunkSize)) {
+        return false;
+    }
+
+    sgl::XorshiftRandomGenerator random(seed);
+    for (int chunkY = 0; chunkY < numChunks; chunkY++) {
+        for (int chunkX = 0; chunkX < numChunks; chunkX++) {
+            glm::ivec2 chunkCoord(chunkX, chunkY);
+            glm::vec2 chunkMin = glm::vec2(chunkCoord) * chunkSize;
+            WorldChunkData chunk;
+            // Star-shaped polygons that stay inside of the chunk they belong to
+            float maxRadius = chunkSize * 0.1f;
+            for (int i = 0; i < OCCLUDERS_PER_CHUNK; i++) {
+                glm::vec2 center = chunkMin + glm::vec2(
+                        random.getRandomFloatBetween(maxRadius, chunkSize - maxRadius),
+                        random.getRandomFloatBetween(maxRadius, chunkSize - maxRadius));
+                WorldChunkOccluder occluder;
+                occluder.color = sgl::Color(60, 60, 60);
+                int numPoints = random.getRandomIntBetween(3, 16);
+                float startAngle = random.getRandomFloatBetween(0.0f, sgl::TWO_PI);
+                for (int j = 0; j < numPoints; j++) {
+                    float angle = startAngle + sgl::TWO_PI * float(j) / float(numPoints);
+                    float radius = maxRadius * random.getRandomFloatBetween(0.4f, 1.0f);
+                    occluder.outline.push_back(center + radius * glm::vec2(std::cos(angle), std::sin(angle)));
+                }
+                chunk.occluders.push_back(occluder);
+            }
+            for (int i = 0; i < LIGHTS_PER_CHUNK; i++) {
+                WorldChunkLight light;
+                light.position[0] = chunkMin.x + random.getRandomFloatBetween(0.0f, chunkSize);
+                light.position[1] = chunkMin.y + random.getRandomFloatBetween(0.0f, chunkSize);
+                light.radius = chunkSize * random.getRandomFloatBetween(0.25f, 1.0f);
+                for (int c = 0; c < 3; c++) {
+                    light.color[c] = uint8_t(random.getRandomIntBetween(20, 60));
+                }
+                light.color[3] = 255;
+                chunk.lights.push_back(light);
+            }
+            if (!writeWorldChunk(getWorldChunkFilename(worldDirectory, chunkCoord), chunkCoord, chunk)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
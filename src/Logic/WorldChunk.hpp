@@ -0,0 +1,88 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef LOGIC_WORLDCHUNK_HPP_
+#define LOGIC_WORLDCHUNK_HPP_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <Graphics/Color.hpp>
+
+/**
+ * A world directory holds world.txt with the chunk size (in world units) and one file per non-empty chunk
+ * (chunk_<x>_<y>.bin, covering [x, x+1) * [y, y+1) chunk sizes). File layout: WorldChunkHeader, for each occluder a
+ * WorldChunkOccluderHeader followed by numPoints * float[2] (outline in world space), header.numLights *
+ * WorldChunkLight. All lights of the chunks are static.
+ */
+struct WorldChunkHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t chunkX, chunkY;
+    uint32_t numOccluders, numLights;
+};
+
+struct WorldChunkOccluderHeader {
+    uint32_t numPoints;
+    uint8_t color[4];
+};
+
+struct WorldChunkLight {
+    float position[2];
+    float radius;
+    uint8_t color[4];
+};
+
+struct WorldChunkOccluder {
+    std::vector<glm::vec2> outline;
+    sgl::Color color;
+};
+
+struct WorldChunkData {
+    std::vector<WorldChunkOccluder> occluders;
+    std::vector<WorldChunkLight> lights;
+};
+
+std::string getWorldChunkFilename(const std::string &worldDirectory, const glm::ivec2 &chunkCoord);
+// Doesn't log anything, so it can be called on a loader thread. Returns false if the file is invalid.
+bool readWorldChunk(const std::string &filename, WorldChunkData &chunk);
+bool writeWorldChunk(const std::string &filename, const glm::ivec2 &chunkCoord, const WorldChunkData &chunk);
+// Returns false if the directory isn't a world directory
+bool readWorldChunkSize(const std::string &worldDirectory, float &chunkSize);
+bool writeWorldChunkSize(const std::string &worldDirectory, float chunkSize);
+// Creates a world directory with numChunks * numChunks chunks, starting at the chunk (0, 0), with random polygons and
+// static lights in every chunk. The same seed always creates the same world.
+bool generateWorld(const std::string &worldDirectory, int numChunks, float chunkSize, uint32_t seed);
+
+#endif /* LOGIC_WORLDCHUNK_HPP_ */
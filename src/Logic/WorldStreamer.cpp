@@ -0,0 +1,296 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <boost/filesystem.hpp>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
+
+#include "Utils/Profiler.hpp"
+#include "WorldStreamer.hpp"
+
+WorldStreamer::WorldStreamer(const std::string &worldDirectory, float chunkSize, sgl::ShaderProgramPtr plainShader,
+        sgl::ShaderProgramPtr edgeShader)
+        : worldDirectory(worldDirectory), chunkSize(chunkSize), plainShader(plainShader), edgeShader(edgeShader) {
+    loaderThread = std::thread(&WorldStreamer::loaderLoop, this);
+}
+
+WorldStreamer::~WorldStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        quitLoader = true;
+    }
+    queueCondition.notify_one();
+    loaderThread.join();
+}
+
+void WorldStreamer::loaderLoop() {
+    while (true) {
+        ChunkKey key;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this]{ return quitLoader || !requestQueue.empty(); });
+            if (quitLoader) {
+                return;
+            }
+            key = requestQueue.front();
+            requestQueue.pop_front();
+        }
+
+        // Reading, decoding and triangulating happen without holding the lock. Missing files are empty chunks.
+        LoadedChunk loadedChunk;
+        loadedChunk.key = key;
+        loadedChunk.valid = true;
+        WorldChunkData chunkData;
+        std::string filename = getWorldChunkFilename(worldDirectory, glm::ivec2(key.first, key.second));
+        if (boost::filesystem::exists(filename)) {
+            loadedChunk.valid = readWorldChunk(filename, chunkData);
+        }
+        for (WorldChunkOccluder &occluder : chunkData.occluders) {
+            boost::shared_ptr<PolygonPrimitive> primitive(new PolygonPrimitive(occluder.outline));
+            primitive->setColor(occluder.color);
+            primitive->setStatic(true);
+            loadedChunk.primitives.push_back(primitive);
+        }
+        loadedChunk.lights = chunkData.lights;
+
+        std::lock_guard<std::mutex> lock(queueMutex);
+        loadedChunks.push_back(loadedChunk);
+    }
+}
+
+float WorldStreamer::getDistanceToView(const ChunkKey &key, const glm::vec2 &viewCenter) {
+    glm::vec2 chunkCenter = (glm::vec2(float(key.first), float(key.second)) + glm::vec2(0.5f)) * chunkSize;
+    return glm::length(chunkCenter - viewCenter);
+}
+
+bool WorldStreamer::update(const sgl::AABB2 &viewRect, float dt) {
+    PROFILE_SCOPE("WorldStreamer::update");
+    addedPrimitives.clear();
+    addedLights.clear();
+    removedLights.clear();
+    changedRegions.clear();
+
+    // Request the chunks that entered the load radius, closest first
+    glm::vec2 viewCenter = (viewRect.min + viewRect.max) * 0.5f;
+    int minX = int(std::floor(viewRect.min.x / chunkSize)) - loadRadius;
+    int minY = int(std::floor(viewRect.min.y / chunkSize)) - loadRadius;
+    int maxX = int(std::floor(viewRect.max.x / chunkSize)) + loadRadius;
+    int maxY = int(std::floor(viewRect.max.y / chunkSize)) + loadRadius;
+    for (auto &chunkEntry : chunks) {
+        const ChunkKey &key = chunkEntry.first;
+        chunkEntry.second.inLoadRadius =
+                key.first >= minX && key.first <= maxX && key.second >= minY && key.second <= maxY;
+    }
+    std::vector<ChunkKey> newRequests;
+    for (int y = minY; y <= maxY; y++) {
+        for (int x = minX; x <= maxX; x++) {
+            ChunkKey key(x, y);
+            if (chunks.find(key) == chunks.end()) {
+                chunks[key] = Chunk();
+                newRequests.push_back(key);
+            }
+        }
+    }
+    std::sort(newRequests.begin(), newRequests.end(), [this, &viewCenter](const ChunkKey &a, const ChunkKey &b) {
+        return getDistanceToView(a, viewCenter) < getDistanceToView(b, viewCenter);
+    });
+
+    std::vector<LoadedChunk> finishedChunks;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        // Requests that left the load radius before the loader got to them are dropped
+        for (auto it = requestQueue.begin(); it != requestQueue.end(); ) {
+            if (!chunks.at(*it).inLoadRadius) {
+                chunks.erase(*it);
+                it = requestQueue.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        requestQueue.insert(requestQueue.end(), newRequests.begin(), newRequests.end());
+        finishedChunks.swap(loadedChunks);
+    }
+    if (!newRequests.empty()) {
+        queueCondition.notify_one();
+    }
+
+    for (LoadedChunk &loadedChunk : finishedChunks) {
+        auto chunkIt = chunks.find(loadedChunk.key);
+        if (!loadedChunk.valid) {
+            numInvalidChunks++;
+            sgl::Logfile::get()->writeError(std::string() + "Error in WorldStreamer::update: Invalid chunk file \""
+                    + getWorldChunkFilename(worldDirectory, glm::ivec2(loadedChunk.key.first, loadedChunk.key.second))
+                    + "\".");
+        }
+        if (!chunkIt->second.inLoadRadius) {
+            chunks.erase(chunkIt);
+            continue;
+        }
+        Chunk &chunk = chunkIt->second;
+        chunk.state = CHUNK_UPLOADING;
+        chunk.primitives = loadedChunk.primitives;
+        chunk.lightData = loadedChunk.lights;
+        for (boost::shared_ptr<PolygonPrimitive> &primitive : chunk.primitives) {
+            chunk.geometrySize += primitive->getGeometrySize();
+        }
+    }
+
+    // Upload within the budget, closest chunks first. Chunks that left the load radius aren't uploaded anymore.
+    std::vector<std::pair<float, ChunkKey>> uploadingChunks;
+    for (auto it = chunks.begin(); it != chunks.end(); ) {
+        if (it->second.state == CHUNK_UPLOADING && !it->second.inLoadRadius) {
+            it = chunks.erase(it);
+            continue;
+        }
+        if (it->second.state == CHUNK_UPLOADING) {
+            uploadingChunks.push_back(std::make_pair(getDistanceToView(it->first, viewCenter), it->first));
+        }
+        ++it;
+    }
+    std::sort(uploadingChunks.begin(), uploadingChunks.end());
+    bool budgetExhausted = false;
+    for (auto &uploadingChunk : uploadingChunks) {
+        Chunk &chunk = chunks.at(uploadingChunk.second);
+        while (chunk.numUploadedPrimitives < chunk.primitives.size()) {
+            boost::shared_ptr<PolygonPrimitive> &primitive = chunk.primitives.at(chunk.numUploadedPrimitives);
+            if (!uploader.canUpload(primitive->getGeometrySize())) {
+                budgetExhausted = true;
+                break;
+            }
+            primitive->upload(plainShader, edgeShader, &uploader);
+            chunk.numUploadedPrimitives++;
+        }
+        if (budgetExhausted) {
+            break;
+        }
+        makeResident(chunk);
+    }
+    uploader.endFrame();
+
+    // Evict the chunks farthest away from the view while over the memory cap
+    while (residentBytes > memoryCap) {
+        auto farthestIt = chunks.end();
+        float farthestDistance = -1.0f;
+        for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+            float distance = getDistanceToView(it->first, viewCenter);
+            if (it->second.state == CHUNK_RESIDENT && !it->second.inLoadRadius && distance > farthestDistance) {
+                farthestIt = it;
+                farthestDistance = distance;
+            }
+        }
+        if (farthestIt == chunks.end()) {
+            // The chunks in the load radius alone exceed the cap, evicting them would only load them again
+            break;
+        }
+        evict(farthestIt);
+    }
+
+    bandwidthWindowBytes += uploader.getUploadedBytesLastFrame();
+    bandwidthWindowTime += dt;
+    if (bandwidthWindowTime >= 1.0f) {
+        uploadMiBPerSecond = double(bandwidthWindowBytes) / double(bandwidthWindowTime) / (1024.0 * 1024.0);
+        bandwidthWindowBytes = 0;
+        bandwidthWindowTime = 0.0f;
+    }
+
+    return !addedLights.empty() || !removedLights.empty() || !addedPrimitives.empty() || !changedRegions.empty();
+}
+
+void WorldStreamer::makeResident(Chunk &chunk) {
+    chunk.state = CHUNK_RESIDENT;
+    residentBytes += chunk.geometrySize;
+    for (size_t i = 0; i < chunk.primitives.size(); i++) {
+        sgl::AABB2 primitiveBounds = chunk.primitives.at(i)->getAABB();
+        chunk.bounds = i == 0 ? primitiveBounds : sgl::AABB2(
+                glm::min(chunk.bounds.min, primitiveBounds.min), glm::max(chunk.bounds.max, primitiveBounds.max));
+        addedPrimitives.push_back(chunk.primitives.at(i));
+    }
+    if (!chunk.primitives.empty()) {
+        changedRegions.push_back(chunk.bounds);
+    }
+    for (const WorldChunkLight &lightData : chunk.lightData) {
+        VolumeLightPtr light(new VolumeLight(
+                glm::vec2(lightData.position[0], lightData.position[1]), lightData.radius,
+                sgl::Color(lightData.color[0], lightData.color[1], lightData.color[2], lightData.color[3])));
+        light->setStatic(true);
+        chunk.lights.push_back(light);
+        addedLights.push_back(light);
+    }
+}
+
+void WorldStreamer::evict(std::map<ChunkKey, Chunk>::iterator chunkIt) {
+    Chunk &chunk = chunkIt->second;
+    residentBytes -= chunk.geometrySize;
+    if (!chunk.primitives.empty()) {
+        changedRegions.push_back(chunk.bounds);
+    }
+    removedLights.insert(removedLights.end(), chunk.lights.begin(), chunk.lights.end());
+    numEvictedChunks++;
+    chunks.erase(chunkIt);
+}
+
+void WorldStreamer::getResidentPrimitives(std::vector<PrimitivePtr> &primitives) {
+    for (auto &chunkEntry : chunks) {
+        if (chunkEntry.second.state == CHUNK_RESIDENT) {
+            const std::vector<boost::shared_ptr<PolygonPrimitive>> &chunkPrimitives = chunkEntry.second.primitives;
+            primitives.insert(primitives.end(), chunkPrimitives.begin(), chunkPrimitives.end());
+        }
+    }
+}
+
+void WorldStreamer::getResidentLights(std::vector<VolumeLightPtr> &lights) {
+    for (auto &chunkEntry : chunks) {
+        lights.insert(lights.end(), chunkEntry.second.lights.begin(), chunkEntry.second.lights.end());
+    }
+}
+
+WorldStreamerStats WorldStreamer::getStats() {
+    WorldStreamerStats stats;
+    for (auto &chunkEntry : chunks) {
+        if (chunkEntry.second.state == CHUNK_RESIDENT) {
+            stats.numResidentChunks++;
+        } else if (chunkEntry.second.state == CHUNK_UPLOADING) {
+            stats.numUploadingChunks++;
+        } else {
+            stats.numLoadingChunks++;
+        }
+    }
+    stats.residentBytes = residentBytes;
+    stats.numEvictedChunks = numEvictedChunks;
+    stats.numInvalidChunks = numInvalidChunks;
+    stats.uploadedBytesLastFrame = uploader.getUploadedBytesLastFrame();
+    stats.uploadMiBPerSecond = uploadMiBPerSecond;
+    return stats;
+}
@@ -0,0 +1,154 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef LOGIC_WORLDSTREAMER_HPP_
+#define LOGIC_WORLDSTREAMER_HPP_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <Math/Geometry/AABB2.hpp>
+#include <Graphics/Shader/ShaderManager.hpp>
+
+#include "Utils/StagingUploader.hpp"
+#include "VolumeLight.hpp"
+#include "Polygon.hpp"
+#include "WorldChunk.hpp"
+
+struct WorldStreamerStats {
+    int numResidentChunks = 0;
+    int numLoadingChunks = 0; // Requested or being decoded by the loader thread
+    int numUploadingChunks = 0; // Decoded and waiting for the upload budget
+    size_t residentBytes = 0; // Vertex data of the resident chunks
+    size_t numEvictedChunks = 0;
+    size_t numInvalidChunks = 0;
+    size_t uploadedBytesLastFrame = 0;
+    double uploadMiBPerSecond = 0.0; // Average over about one second
+};
+
+/**
+ * Keeps the chunks of a world directory (see WorldChunk.hpp) around the view resident. Chunk files are read, decoded
+ * and triangulated on a loader thread, closest chunks first. The vertex data of decoded chunks is uploaded through a
+ * staging buffer within a per-frame budget, and a chunk becomes resident once all of its occluders are uploaded.
+ * Once the vertex data of the resident chunks exceeds the memory cap, the chunks farthest away from the view outside
+ * of the load radius are evicted. The render thread never waits for the loader thread or the GPU.
+ */
+class WorldStreamer {
+public:
+    WorldStreamer(const std::string &worldDirectory, float chunkSize, sgl::ShaderProgramPtr plainShader,
+            sgl::ShaderProgramPtr edgeShader);
+    ~WorldStreamer();
+
+    // Chunks overlapping the view rectangle extended by this many chunks in every direction are loaded
+    inline void setLoadRadius(int chunks) { loadRadius = chunks; }
+    inline void setMemoryCap(size_t bytes) { memoryCap = bytes; }
+    inline size_t getMemoryCap() { return memoryCap; }
+    inline void setUploadBudget(size_t bytesPerFrame) { uploader.setBudget(bytesPerFrame); }
+    inline size_t getUploadBudget() { return uploader.getBudget(); }
+    inline float getChunkSize() { return chunkSize; }
+
+    // Called once per frame on the render thread. Returns true if chunks became resident or were evicted.
+    bool update(const sgl::AABB2 &viewRect, float dt);
+
+    // Occluders and lights of all resident chunks
+    void getResidentPrimitives(std::vector<PrimitivePtr> &primitives);
+    void getResidentLights(std::vector<VolumeLightPtr> &lights);
+    // Changes of the last update
+    inline const std::vector<PrimitivePtr> &getAddedPrimitives() { return addedPrimitives; }
+    inline const std::vector<VolumeLightPtr> &getAddedLights() { return addedLights; }
+    inline const std::vector<VolumeLightPtr> &getRemovedLights() { return removedLights; }
+    // Bounds of the occluders of the chunks that became resident or were evicted
+    inline const std::vector<sgl::AABB2> &getChangedRegions() { return changedRegions; }
+
+    WorldStreamerStats getStats();
+
+private:
+    enum ChunkState {
+        CHUNK_LOADING, CHUNK_UPLOADING, CHUNK_RESIDENT
+    };
+    typedef std::pair<int, int> ChunkKey;
+    struct Chunk {
+        ChunkState state = CHUNK_LOADING;
+        bool inLoadRadius = true;
+        std::vector<boost::shared_ptr<PolygonPrimitive>> primitives;
+        size_t numUploadedPrimitives = 0;
+        std::vector<WorldChunkLight> lightData;
+        std::vector<VolumeLightPtr> lights; // Only while resident
+        size_t geometrySize = 0;
+        sgl::AABB2 bounds; // Of the occluders, only valid if there are any
+    };
+    // Result of the loader thread. Nothing of it is uploaded yet, so it may be destroyed on any thread.
+    struct LoadedChunk {
+        ChunkKey key;
+        bool valid;
+        std::vector<boost::shared_ptr<PolygonPrimitive>> primitives;
+        std::vector<WorldChunkLight> lights;
+    };
+
+    void loaderLoop();
+    float getDistanceToView(const ChunkKey &key, const glm::vec2 &viewCenter);
+    void makeResident(Chunk &chunk);
+    void evict(std::map<ChunkKey, Chunk>::iterator chunkIt);
+
+    std::string worldDirectory;
+    float chunkSize;
+    sgl::ShaderProgramPtr plainShader, edgeShader;
+    int loadRadius = 1;
+    size_t memoryCap = 64 * 1024 * 1024;
+    std::map<ChunkKey, Chunk> chunks;
+    StagingUploader uploader;
+    size_t residentBytes = 0;
+
+    std::vector<PrimitivePtr> addedPrimitives;
+    std::vector<VolumeLightPtr> addedLights, removedLights;
+    std::vector<sgl::AABB2> changedRegions;
+
+    size_t numEvictedChunks = 0, numInvalidChunks = 0;
+    size_t bandwidthWindowBytes = 0;
+    float bandwidthWindowTime = 0.0f;
+    double uploadMiBPerSecond = 0.0;
+
+    // Loader thread data
+    std::thread loaderThread;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<ChunkKey> requestQueue;
+    std::vector<LoadedChunk> loadedChunks;
+    bool quitLoader = false;
+};
+
+#endif /* LOGIC_WORLDSTREAMER_HPP_ */
@@ -31,13 +31,251 @@
  */
 
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
 #include <Utils/File/FileUtils.hpp>
+#include <Utils/File/Logfile.hpp>
 #include <Utils/AppSettings.hpp>
+#include <Utils/Convert.hpp>
 #include <Graphics/Window.hpp>
 
+#include "Utils/Profiler.hpp"
+#include "Utils/ShaderCache.hpp"
+#include "Logic/WorldChunk.hpp"
 #include "MainApp.hpp"
 
+// Comma-separated list, e.g. "1,10,100"
+static std::vector<int> parseIntList(const char *list) {
+    std::vector<int> values;
+    for (const char *value = list; value != nullptr; value = strchr(value, ',')) {
+        if (*value == ',') {
+            value++;
+        }
+        values.push_back(atoi(value));
+    }
+    return values;
+}
+
 int main(int argc, char *argv[]) {
+    auto startupStartTime = std::chrono::steady_clock::now();
+    // --bake [texels per unit] [--manager 0-5]: Bakes the static lights of the scene and exits
+    bool bake = false;
+    float bakeTexelsPerUnit = 1024.0f;
+    // --headless [frames] [--size WxH] [--manager 0-5] [--lights n] [--static-lights] [--timings file.csv]
+    // [--png file.png] [--compare-cpu] [--switch-every n] [--shadow-ring n] [--shadow-lod px]
+    // [--light-blur off|kawase|gaussian [radius]] [--msaa samples [light samples]]
+    // [--light-format rgba8|r11g11b10f|rgb9e5|rgba16f|all] [--taa] [--light-cluster px] [--minimap]
+    // [--world directory [pan speed]] [--frames-in-flight 1-3] [--replay trace]:
+    // Renders a fixed number of frames without a display, saves the timings and the frame graph report and exits.
+    // With --frames-in-flight, frames are paced with fences instead of waiting for each frame, and the throughput
+    // and the input latency percentiles are reported.
+    // With "all", the benchmark is repeated for every light format and the format is appended to the timings file
+    // (combined with "--manager all", for every light format and light manager).
+    // --replay renders the frames of a recorded session instead (implies --headless). With "--manager all", it is
+    // repeated for every light manager and "_manager<type>" is appended to the timings file.
+    bool allLightFormats = false;
+    bool allManagers = false;
+    bool headless = false;
+    HeadlessSettings headlessSettings;
+    // --sweep [file.csv] [--size WxH] [--sweep-occluders list] [--sweep-edges list] [--sweep-lights list]
+    // [--sweep-managers list|all] [--sweep-frames n] [--shape box|circle|polygon]
+    // [--distribution uniform|clustered|grid] [--light-radius min max [log]] [--motion fraction] [--seed n]:
+    // Measures generated scenes for all combinations of the lists (e.g., "10,100,1000") and fits the cost per light
+    // and per edge of each light manager. All lights are treated as dynamic, so the static light caches are skipped,
+    // and --motion only sets the fraction of the lights and occluders that move.
+    bool sweep = false;
+    SweepSettings sweepSettings;
+    // --record [trace]: Records the session (lights, occluders and camera of every frame) for --replay (GUI only)
+    std::string recordFilename;
+    // --profile [file]: Records CPU timings from the start and saves them as a Chrome trace at exit
+    std::string traceFilename = "trace.json";
+    // --capture video|png [path]: Captures all rendered frames to a video file or a directory of PNG files
+    bool capture = false;
+    CaptureFormat captureFormat = CAPTURE_VIDEO;
+    std::string capturePath;
+    // --world directory [pan speed]: Streams the chunks of a world around the camera. The arrow keys move the camera,
+    // in headless mode it moves to the right with the pan speed.
+    // --generate-world directory [chunks]: Writes a random world of chunks * chunks chunks for --world and exits
+    std::string generateWorldDirectory;
+    int generateWorldChunks = 16;
+    // --no-program-cache: Neither loads nor stores program binaries on disk (i.e., measures a cold start)
+    bool useProgramCache = true;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bake") == 0) {
+            bake = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                bakeTexelsPerUnit = float(atof(argv[++i]));
+            }
+        } else if ((strcmp(argv[i], "--manager") == 0 || strcmp(argv[i], "--bake-manager") == 0) && i + 1 < argc) {
+            allManagers = strcmp(argv[i + 1], "all") == 0;
+            headlessSettings.lightManagerType = allManagers ? 0 : atoi(argv[i + 1]);
+            if (headlessSettings.lightManagerType < 0 || headlessSettings.lightManagerType >= NUM_LIGHT_MANAGER_TYPES) {
+                sgl::Logfile::get()->writeError(std::string() + "Error in main: The light manager " + argv[i + 1]
+                        + " of " + argv[i] + " isn't in the range 0-" + sgl::toString(NUM_LIGHT_MANAGER_TYPES - 1)
+                        + ".");
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                headlessSettings.numFrames = atoi(argv[++i]);
+            }
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            sscanf(argv[++i], "%dx%d", &headlessSettings.width, &headlessSettings.height);
+        } else if (strcmp(argv[i], "--lights") == 0 && i + 1 < argc) {
+            headlessSettings.numLights = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--static-lights") == 0) {
+            headlessSettings.staticLights = true;
+        } else if (strcmp(argv[i], "--compare-cpu") == 0) {
+            headlessSettings.compareWithCPU = true;
+        } else if (strcmp(argv[i], "--switch-every") == 0 && i + 1 < argc) {
+            headlessSettings.switchInterval = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--shadow-ring") == 0 && i + 1 < argc) {
+            headlessSettings.shadowAtlasRingSize = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--shadow-lod") == 0 && i + 1 < argc) {
+            headlessSettings.shadowLodError = float(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--light-cluster") == 0 && i + 1 < argc) {
+            headlessSettings.lightClusterError = float(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--light-blur") == 0 && i + 1 < argc) {
+            const char *mode = argv[++i];
+            headlessSettings.lightBlurMode = strcmp(mode, "kawase") == 0 ? LIGHT_BLUR_DUAL_KAWASE
+                    : strcmp(mode, "gaussian") == 0 ? LIGHT_BLUR_GAUSSIAN : LIGHT_BLUR_OFF;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                headlessSettings.lightBlurRadius = float(atof(argv[++i]));
+            }
+        } else if (strcmp(argv[i], "--msaa") == 0) {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') {
+                sgl::Logfile::get()->writeError("Error in main: --msaa needs the number of samples.");
+                return 1;
+            }
+            headlessSettings.sceneSamples = headlessSettings.lightSamples = atoi(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                headlessSettings.lightSamples = atoi(argv[++i]);
+            }
+        } else if (strcmp(argv[i], "--world") == 0 && i + 1 < argc) {
+            headlessSettings.worldDirectory = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                headlessSettings.worldPanSpeed = float(atof(argv[++i]));
+            }
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            headless = true;
+            headlessSettings.replayFilename = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0) {
+            recordFilename = "session.trace";
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                recordFilename = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--sweep") == 0) {
+            sweep = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                sweepSettings.csvFilename = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--sweep-occluders") == 0 && i + 1 < argc) {
+            sweepSettings.occluderCounts = parseIntList(argv[++i]);
+        } else if (strcmp(argv[i], "--sweep-edges") == 0 && i + 1 < argc) {
+            sweepSettings.edgeCounts = parseIntList(argv[++i]);
+        } else if (strcmp(argv[i], "--sweep-lights") == 0 && i + 1 < argc) {
+            sweepSettings.lightCounts = parseIntList(argv[++i]);
+        } else if (strcmp(argv[i], "--sweep-managers") == 0 && i + 1 < argc) {
+            if (strcmp(argv[++i], "all") == 0) {
+                sweepSettings.lightManagerTypes.clear();
+                for (int type = 0; type < NUM_LIGHT_MANAGER_TYPES; type++) {
+                    sweepSettings.lightManagerTypes.push_back(type);
+                }
+            } else {
+                sweepSettings.lightManagerTypes.clear();
+                for (int type : parseIntList(argv[i])) {
+                    if (type < 0 || type >= NUM_LIGHT_MANAGER_TYPES) {
+                        sgl::Logfile::get()->writeError(std::string() + "Error in main: Skipping light manager "
+                                + sgl::toString(type) + " of --sweep-managers, as it isn't in the range 0-"
+                                + sgl::toString(NUM_LIGHT_MANAGER_TYPES - 1) + ".");
+                        continue;
+                    }
+                    sweepSettings.lightManagerTypes.push_back(type);
+                }
+            }
+        } else if (strcmp(argv[i], "--sweep-frames") == 0 && i + 1 < argc) {
+            sweepSettings.numFrames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--shape") == 0 && i + 1 < argc) {
+            const char *shape = argv[++i];
+            sweepSettings.scene.occluderShape = strcmp(shape, "box") == 0 ? OCCLUDER_BOX
+                    : strcmp(shape, "polygon") == 0 ? OCCLUDER_RANDOM_POLYGON : OCCLUDER_CIRCLE;
+        } else if (strcmp(argv[i], "--distribution") == 0 && i + 1 < argc) {
+            const char *distribution = argv[++i];
+            sweepSettings.scene.distribution = strcmp(distribution, "clustered") == 0 ? DISTRIBUTION_CLUSTERED
+                    : strcmp(distribution, "grid") == 0 ? DISTRIBUTION_GRID : DISTRIBUTION_UNIFORM;
+        } else if (strcmp(argv[i], "--light-radius") == 0 && i + 2 < argc) {
+            sweepSettings.scene.minLightRadius = float(atof(argv[++i]));
+            sweepSettings.scene.maxLightRadius = float(atof(argv[++i]));
+            if (i + 1 < argc && strcmp(argv[i + 1], "log") == 0) {
+                sweepSettings.scene.lightRadiusDistribution = LIGHT_RADIUS_LOG_UNIFORM;
+                i++;
+            }
+        } else if (strcmp(argv[i], "--motion") == 0 && i + 1 < argc) {
+            sweepSettings.scene.motionFraction = float(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            sweepSettings.scene.seed = uint32_t(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc) {
+            headlessSettings.framesInFlight = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--minimap") == 0) {
+            headlessSettings.minimap = true;
+        } else if (strcmp(argv[i], "--taa") == 0) {
+            headlessSettings.temporalAA = true;
+        } else if (strcmp(argv[i], "--light-format") == 0 && i + 1 < argc) {
+            const char *format = argv[++i];
+            const char *formatArgs[] = {"rgba8", "r11g11b10f", "rgb9e5", "rgba16f"};
+            allLightFormats = strcmp(format, "all") == 0;
+            for (int formatIdx = 0; formatIdx < NUM_LIGHT_FORMATS; formatIdx++) {
+                if (strcmp(format, formatArgs[formatIdx]) == 0) {
+                    headlessSettings.lightFormat = formatIdx;
+                }
+            }
+        } else if (strcmp(argv[i], "--timings") == 0 && i + 1 < argc) {
+            headlessSettings.timingsFilename = argv[++i];
+        } else if (strcmp(argv[i], "--png") == 0 && i + 1 < argc) {
+            headlessSettings.pngFilename = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            Profiler::get()->setEnabled(true);
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                traceFilename = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            capture = true;
+            captureFormat = strcmp(argv[++i], "png") == 0 ? CAPTURE_PNG : CAPTURE_VIDEO;
+            capturePath = captureFormat == CAPTURE_PNG ? "frames" : "video.mp4";
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                capturePath = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--no-program-cache") == 0) {
+            useProgramCache = false;
+        } else if (strcmp(argv[i], "--generate-world") == 0 && i + 1 < argc) {
+            generateWorldDirectory = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                generateWorldChunks = atoi(argv[++i]);
+            }
+        }
+    }
+
+    // Sessions are only recorded while the GUI runs
+    if (!recordFilename.empty() && (headless || bake || sweep)) {
+        sgl::Logfile::get()->writeError(
+                "Error in main: --record can't be combined with --headless, --replay, --bake or --sweep.");
+        return 1;
+    }
+
+    // Doesn't need a window, as the chunks are only written to disk
+    if (!generateWorldDirectory.empty()) {
+        if (!generateWorld(generateWorldDirectory, generateWorldChunks, 1.0f, 1)) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in main: Couldn't write the world \""
+                    + generateWorldDirectory + "\".");
+            return 1;
+        }
+        return 0;
+    }
+
     // Initialize the filesystem utilities
     sgl::FileUtils::get()->initialize("shadow-volumes-2d", argc, argv);
 
@@ -49,16 +287,82 @@ int main(int argc, char *argv[]) {
         sgl::AppSettings::get()->setDataDirectory(DATA_PATH);
     }
 #endif
-    sgl::AppSettings::get()->setLoadGUI();
+    if (headless || bake || sweep) {
+        // SDL's offscreen video driver creates an EGL context without a display server (e.g., with Mesa llvmpipe).
+        // No GUI is loaded, as no frame is ever presented.
+#ifdef _WIN32
+        _putenv_s("SDL_VIDEODRIVER", "offscreen");
+#else
+        setenv("SDL_VIDEODRIVER", "offscreen", 1);
+#endif
+    } else {
+        sgl::AppSettings::get()->setLoadGUI();
+    }
 
     sgl::AppSettings::get()->createWindow();
     sgl::AppSettings::get()->initializeSubsystems();
+    if (useProgramCache) {
+        ShaderCache::get()->setDirectory(sgl::FileUtils::get()->getConfigDirectory() + "ProgramCache/");
+    }
 
-    sgl::AppLogic *app = new VolumeLightApp();
-    app->run();
+    VolumeLightApp *app = new VolumeLightApp();
+    const ShaderCacheStatistics &shaderStatistics = ShaderCache::get()->getStatistics();
+    double startupTimeMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - startupStartTime).count();
+    sgl::Logfile::get()->writeInfo(std::string() + "Startup took " + sgl::toString(startupTimeMs) + "ms, "
+            + sgl::toString(shaderStatistics.loadTimeMs) + "ms of it for the shader programs ("
+            + sgl::toString(shaderStatistics.numCompiled) + " compiled, "
+            + sgl::toString(shaderStatistics.numDiskHits) + " loaded from the program binary cache).");
+    // Batch scripts detect failed runs by the exit code
+    bool success = true;
+    if (bake) {
+        success = app->bakeStaticLights(headlessSettings.lightManagerType, bakeTexelsPerUnit);
+    } else if (sweep) {
+        sweepSettings.width = headlessSettings.width;
+        sweepSettings.height = headlessSettings.height;
+        success = app->runSweep(sweepSettings);
+    } else if (headless && (allLightFormats || allManagers)) {
+        // With both, every light manager is measured with every light format
+        std::string timingsFilename = headlessSettings.timingsFilename;
+        std::string timingsBasename = timingsFilename.substr(0, timingsFilename.find_last_of('.'));
+        std::vector<int> formats, types;
+        for (int formatIdx = 0; formatIdx < (allLightFormats ? NUM_LIGHT_FORMATS : 1); formatIdx++) {
+            formats.push_back(allLightFormats ? formatIdx : headlessSettings.lightFormat);
+        }
+        for (int type = 0; type < (allManagers ? NUM_LIGHT_MANAGER_TYPES : 1); type++) {
+            types.push_back(allManagers ? type : headlessSettings.lightManagerType);
+        }
+        for (int formatIdx : formats) {
+            for (int type : types) {
+                headlessSettings.lightFormat = formatIdx;
+                headlessSettings.lightManagerType = type;
+                headlessSettings.timingsFilename = timingsBasename
+                        + (allLightFormats ? std::string("_") + LIGHT_FORMAT_NAMES[formatIdx] : std::string())
+                        + (allManagers ? "_manager" + sgl::toString(type) : std::string()) + ".csv";
+                success = app->runHeadless(headlessSettings) && success;
+            }
+        }
+    } else if (headless) {
+        success = app->runHeadless(headlessSettings);
+    } else {
+        if (capture) {
+            app->startCapture(captureFormat, capturePath);
+        }
+        if (!headlessSettings.worldDirectory.empty()) {
+            app->loadWorld(headlessSettings.worldDirectory);
+        }
+        if (!recordFilename.empty()) {
+            app->startRecording(recordFilename);
+        }
+        app->run();
+    }
     delete app;
 
+    if (Profiler::get()->isEnabled()) {
+        Profiler::get()->saveTrace(traceFilename);
+    }
+
     sgl::AppSettings::get()->release();
 
-    return 0;
+    return success ? 0 : 1;
 }
@@ -31,6 +31,8 @@
  */
 
 #include <climits>
+#include <fstream>
+#include <chrono>
 #include <GL/glew.h>
 
 #include <Input/Keyboard.hpp>
@@ -47,10 +49,17 @@
 #include <Utils/File/FileUtils.hpp>
 #include <Graphics/Renderer.hpp>
 #include <Graphics/Shader/ShaderManager.hpp>
+#include <Graphics/Texture/TextureManager.hpp>
+#include <Graphics/Texture/Bitmap.hpp>
+#include <Graphics/OpenGL/Texture.hpp>
 #include <ImGui/ImGuiWrapper.hpp>
 
+#include <boost/filesystem.hpp>
+
 #include "Logic/Circle.hpp"
 #include "Logic/Arc.hpp"
+#include "Utils/Profiler.hpp"
+#include "Utils/ShaderCache.hpp"
 #include "MainApp.hpp"
 #include <glm/gtx/color_space.hpp>
 
@@ -58,9 +67,9 @@ void openglErrorCallback() {
     std::cerr << "Application callback" << std::endl;
 }
 
-VolumeLightApp::VolumeLightApp() : camera(new sgl::Camera()), random(10203), videoWriter(NULL) {
-    plainShader = sgl::ShaderManager->getShaderProgram({"Mesh.Vertex.Plain", "Mesh.Fragment.Plain"});
-    whiteSolidShader = sgl::ShaderManager->getShaderProgram({"WhiteSolid.Vertex", "WhiteSolid.Fragment"});
+VolumeLightApp::VolumeLightApp() : camera(new sgl::Camera()), random(10203), frameCapture(NULL) {
+    plainShader = ShaderCache::get()->getShaderProgram({"Mesh.Vertex.Plain", "Mesh.Fragment.Plain"});
+    whiteSolidShader = ShaderCache::get()->getShaderProgram({"WhiteSolid.Vertex", "WhiteSolid.Fragment"});
 
     sgl::EventManager::get()->addListener(
             sgl::RESOLUTION_CHANGED_EVENT, [this](sgl::EventPtr event){ this->resolutionChanged(event); });
@@ -74,14 +83,28 @@ VolumeLightApp::VolumeLightApp() : camera(new sgl::Camera()), random(10203), vid
     camera->setFOVy(fovy);
     camera->setPosition(glm::vec3(0.5f, 0.5f, 1.0f));
 
+    // Three times farther away than the main camera
+    minimapCamera = sgl::CameraPtr(new sgl::Camera());
+    minimapCamera->setNearClipDistance(0.01f);
+    minimapCamera->setFarClipDistance(100.0f);
+    minimapCamera->setOrientation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    minimapCamera->setYaw(-sgl::PI / 2.0f);
+    minimapCamera->setPitch(0.0f);
+    minimapCamera->setFOVy(fovy);
+    minimapCamera->setPosition(glm::vec3(0.5f, 0.5f, 3.0f));
+    minimapView = LightViewPtr(new LightView(
+            minimapCamera, sgl::AABB2(glm::vec2(0.5f, 0.5f), glm::vec2(1.0f, 1.0f))));
+
     sgl::Renderer->setErrorCallback(&openglErrorCallback);
     sgl::Renderer->setDebugVerbosity(sgl::DEBUG_OUTPUT_CRITICAL_ONLY);
 
-    lightManager = boost::shared_ptr<LightManagerInterface>(new LightManagerMap(camera)); // LightManagerMap
     lightManagerType = 0;
+    createLightManagers();
+    lightManager = lightManagers.at(lightManagerType);
     edgeShader = lightManager->getEdgeShader();
     //VolumeLightPtr light = lightManager->addLight(glm::vec2(0.5,0.5));
     VolumeLightPtr light = lightManager->addLight(glm::vec2(0.5,0.5));
+    light->setStatic(true);
 
     // Add objects to scene
     // A
@@ -99,8 +122,26 @@ VolumeLightApp::VolumeLightApp() : camera(new sgl::Camera()), random(10203), vid
     specialTransform = sgl::matrixSkewY(0.3f);
     cube = new Cube(plainShader, edgeShader, glm::vec2(0.1f, 0.2f), specialTransform);
     cube->setPosition(glm::vec2(0.2f, 0.7f));
+    cube->setEmission(sgl::Color(255, 160, 60)); // Only visible with global illumination
     primitives.push_back(PrimitivePtr(cube));
 
+    // The level geometry doesn't move
+    for (PrimitivePtr &primitive : primitives) {
+        primitive->setStatic(true);
+        primitiveBounds.push_back(primitive->getAABB());
+    }
+
+    // Bind the edge data of the primitives to the edge shaders of all light managers once
+    for (boost::shared_ptr<LightManagerInterface> &manager : lightManagers) {
+        manager->setOccluders(primitives);
+        for (PrimitivePtr &primitive : primitives) {
+            primitive->setEdgeShader(manager->getEdgeShader());
+        }
+    }
+    for (PrimitivePtr &primitive : primitives) {
+        primitive->setEdgeShader(edgeShader);
+    }
+
 
     // Create grab point data for user interaction
     vector<glm::vec2> vertices;
@@ -117,6 +158,11 @@ VolumeLightApp::VolumeLightApp() : camera(new sgl::Camera()), random(10203), vid
 
     resolutionChanged(sgl::EventPtr());
 
+    // Use the precomputed lighting of the static lights if it was baked before
+    if (boost::filesystem::exists(getBakedLightmapFilename())) {
+        loadBakedLightmap();
+    }
+
     // Benchmark mode
     benchmark = false;
     benchmarkFinished = false;
@@ -161,15 +207,562 @@ VolumeLightApp::~VolumeLightApp() {
     }
 
     lightManager = boost::shared_ptr<LightManagerInterface>();
+    lightManagers.clear();
+
+    if (frameCapture != NULL) {
+        delete frameCapture;
+    }
+}
+
+boost::shared_ptr<LightManagerInterface> VolumeLightApp::createLightManager(int type) {
+    boost::shared_ptr<LightManagerInterface> manager;
+    if (type == 0) {
+        manager = boost::shared_ptr<LightManagerInterface>(new LightManagerMap(camera));
+    } else if (type == 1) {
+        manager = boost::shared_ptr<LightManagerInterface>(new LightManagerVolume(camera));
+    } else if (type == 2) {
+        manager = boost::shared_ptr<LightManagerInterface>(new LightManagerCPU(camera));
+    } else if (type == 3) {
+        manager = boost::shared_ptr<LightManagerInterface>(new LightManagerVisibility(camera));
+    } else if (type == 4) {
+        manager = boost::shared_ptr<LightManagerInterface>(new LightManagerSDF(camera));
+    } else if (type == 5) {
+        manager = boost::shared_ptr<LightManagerInterface>(new LightManagerRadianceCascades(camera));
+    } else {
+        sgl::Logfile::get()->writeError(std::string() + "Error in VolumeLightApp::createLightManager: Invalid light "
+                + "manager type " + sgl::toString(type) + ".");
+        return manager;
+    }
+    manager->setOccluders(primitives);
+    manager->setShadowLodError(shadowLodError);
+    manager->setLightClusterError(lightClusterError);
+    return manager;
+}
+
+void VolumeLightApp::createLightManagers() {
+    LightStorePtr lightStore(new std::vector<VolumeLightPtr>());
+    for (int type = 0; type < NUM_LIGHT_MANAGER_TYPES; type++) {
+        boost::shared_ptr<LightManagerInterface> manager = createLightManager(type);
+        manager->setLightStore(lightStore);
+        lightManagers.push_back(manager);
+    }
+    lightManagerResolutionOutdated.resize(NUM_LIGHT_MANAGER_TYPES, false);
+}
+
+void VolumeLightApp::setMinimapEnabled(bool enabled) {
+    showMinimap = enabled;
+    std::vector<LightViewPtr> views;
+    if (enabled) {
+        views.push_back(minimapView);
+    }
+    for (boost::shared_ptr<LightManagerInterface> &manager : lightManagers) {
+        manager->setAdditionalViews(views);
+    }
+}
+
+void VolumeLightApp::setLightManagerType(int type) {
+    // Only selects the light manager used for rendering, nothing is allocated unless the resolution changed
+    lightManagerType = type;
+    lightManager = lightManagers.at(type);
+    if (lightManagerResolutionOutdated.at(type)) {
+        lightManagerResolutionOutdated.at(type) = false;
+        lightManager->onResolutionChanged();
+    }
+    edgeShader = lightManager->getEdgeShader();
+    for (PrimitivePtr &primitive : primitives) {
+        primitive->setEdgeShader(edgeShader);
+    }
+}
+
+std::string VolumeLightApp::getBakedLightmapFilename() {
+    return sgl::AppSettings::get()->getDataDirectory() + "Scenes/" + sceneName + ".lightmap";
+}
 
-    if (videoWriter != NULL) {
-        delete videoWriter;
+bool VolumeLightApp::bakeStaticLights(int type, float texelsPerUnit) {
+    // Render the static lights with a separate light manager that contains no dynamic lights
+    boost::shared_ptr<LightManagerInterface> bakeLightManager = createLightManager(type);
+    if (!bakeLightManager) {
+        return false;
     }
+    for (PrimitivePtr &primitive : primitives) {
+        primitive->setEdgeShader(bakeLightManager->getEdgeShader());
+    }
+    for (VolumeLightPtr &light : lightManager->getLights()) {
+        if (light->isStatic()) {
+            bakeLightManager->addLight(light->getPosition(), light->getRadius(), light->getColor())->setStatic(true);
+        }
+    }
+
+    std::string filename = getBakedLightmapFilename();
+    boost::filesystem::create_directories(boost::filesystem::path(filename).parent_path());
+    bool success = BakedLightmap::bake(
+            filename, bakeLightManager.get(), [this, &bakeLightManager]{ renderEdges(bakeLightManager.get()); },
+            camera, texelsPerUnit);
+
+    for (PrimitivePtr &primitive : primitives) {
+        primitive->setEdgeShader(edgeShader);
+    }
+    if (success) {
+        sgl::Logfile::get()->writeInfo(std::string() + "Baked static lights to \"" + filename + "\".");
+    }
+    return success;
+}
+
+void VolumeLightApp::loadBakedLightmap() {
+    bakedLightmap = BakedLightmap::load(getBakedLightmapFilename());
+    for (boost::shared_ptr<LightManagerInterface> &manager : lightManagers) {
+        manager->setBakedLightmap(bakedLightmap);
+    }
+}
+
+bool VolumeLightApp::loadWorld(const std::string &worldDirectory) {
+    float chunkSize = 0.0f;
+    if (!readWorldChunkSize(worldDirectory, chunkSize)) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in VolumeLightApp::loadWorld: \"" + worldDirectory
+                + "\" contains no world.");
+        return false;
+    }
+    // Only the scene is kept when a world is loaded again (e.g., for each headless run), and the camera starts where it
+    // started in the first run, so every run pans over the same part of the world
+    if (worldStreamer) {
+        camera->setPosition(worldStartPosition);
+        std::vector<VolumeLightPtr> &lights = lightManager->getLights();
+        for (size_t i = numScenePrimitives; i < primitives.size(); i++) {
+            for (boost::shared_ptr<LightManagerInterface> &manager : lightManagers) {
+                manager->onOccluderChanged(primitiveBounds.at(i));
+            }
+        }
+        std::vector<VolumeLightPtr> streamedLights;
+        worldStreamer->getResidentLights(streamedLights);
+        for (const VolumeLightPtr &streamedLight : streamedLights) {
+            lights.erase(std::remove(lights.begin(), lights.end(), streamedLight), lights.end());
+        }
+        primitives.resize(numScenePrimitives);
+        primitiveBounds.resize(numScenePrimitives);
+        for (boost::shared_ptr<LightManagerInterface> &manager : lightManagers) {
+            manager->setOccluders(primitives);
+        }
+    } else {
+        numScenePrimitives = primitives.size();
+        worldStartPosition = camera->getPosition();
+    }
+    worldStreamer = boost::shared_ptr<WorldStreamer>(new WorldStreamer(
+            worldDirectory, chunkSize, plainShader, edgeShader));
+    return true;
+}
+
+void VolumeLightApp::updateOccluderBounds() {
+    // Cached static lighting needs to be updated where dynamic occluders moved
+    for (size_t i = 0; i < primitives.size(); i++) {
+        PrimitivePtr &primitive = primitives.at(i);
+        if (primitive->isStatic()) {
+            continue;
+        }
+        sgl::AABB2 &oldBounds = primitiveBounds.at(i);
+        sgl::AABB2 newBounds = primitive->getAABB();
+        if (oldBounds.min != newBounds.min || oldBounds.max != newBounds.max) {
+            for (boost::shared_ptr<LightManagerInterface> &manager : lightManagers) {
+                manager->onOccluderChanged(oldBounds);
+                manager->onOccluderChanged(newBounds);
+            }
+            oldBounds = newBounds;
+        }
+    }
+}
+
+void VolumeLightApp::setScene(const std::vector<PrimitivePtr> &occluders, const std::vector<VolumeLightPtr> &lights) {
+    // Cached static lighting is invalid wherever the old or the new occluders are
+    std::vector<sgl::AABB2> changedRegions = primitiveBounds;
+    primitives = occluders;
+    primitiveBounds.clear();
+    for (PrimitivePtr &primitive : primitives) {
+        primitiveBounds.push_back(primitive->getAABB());
+        changedRegions.push_back(primitiveBounds.back());
+    }
+    numScenePrimitives = primitives.size();
+    for (boost::shared_ptr<LightManagerInterface> &manager : lightManagers) {
+        manager->setOccluders(primitives);
+        for (PrimitivePtr &primitive : primitives) {
+            primitive->setEdgeShader(manager->getEdgeShader());
+        }
+        for (const sgl::AABB2 &region : changedRegions) {
+            manager->onOccluderChanged(region);
+        }
+    }
+    for (PrimitivePtr &primitive : primitives) {
+        primitive->setEdgeShader(edgeShader);
+    }
+    lightManager->getLights() = lights;
+}
+
+bool VolumeLightApp::startRecording(const std::string &filename) {
+    stopRecording();
+    if (worldStreamer) {
+        sgl::Logfile::get()->writeError(
+                "Error in VolumeLightApp::startRecording: Sessions in streamed worlds can't be recorded.");
+        return false;
+    }
+    sessionRecorder = boost::shared_ptr<SessionRecorder>(new SessionRecorder(filename, primitives.size()));
+    unrecordedTime = 0.0f;
+    if (!sessionRecorder->isOpen()) {
+        sessionRecorder = boost::shared_ptr<SessionRecorder>();
+        return false;
+    }
+    return true;
+}
+
+void VolumeLightApp::stopRecording() {
+    if (sessionRecorder) {
+        sgl::Logfile::get()->writeInfo(std::string() + "Recorded a session of "
+                + sgl::toString(int(sessionRecorder->getNumFrames())) + " frames.");
+        sessionRecorder = boost::shared_ptr<SessionRecorder>();
+    }
+}
+
+void VolumeLightApp::updateWorldStreaming(float dt) {
+    if (!worldStreamer || !worldStreamer->update(camera->getAABB2(0.0f), dt)) {
+        return;
+    }
+
+    primitives.resize(numScenePrimitives);
+    primitiveBounds.resize(numScenePrimitives);
+    worldStreamer->getResidentPrimitives(primitives);
+    for (size_t i = numScenePrimitives; i < primitives.size(); i++) {
+        primitiveBounds.push_back(primitives.at(i)->getAABB());
+    }
+    for (const PrimitivePtr &primitive : worldStreamer->getAddedPrimitives()) {
+        for (boost::shared_ptr<LightManagerInterface> &manager : lightManagers) {
+            primitive->setEdgeShader(manager->getEdgeShader());
+        }
+        primitive->setEdgeShader(edgeShader);
+    }
+    for (boost::shared_ptr<LightManagerInterface> &manager : lightManagers) {
+        manager->setOccluders(primitives);
+        for (const sgl::AABB2 &region : worldStreamer->getChangedRegions()) {
+            manager->onOccluderChanged(region);
+        }
+    }
+
+    // The light store is shared by all light managers
+    std::vector<VolumeLightPtr> &lights = lightManager->getLights();
+    for (const VolumeLightPtr &removedLight : worldStreamer->getRemovedLights()) {
+        lights.erase(std::remove(lights.begin(), lights.end(), removedLight), lights.end());
+    }
+    const std::vector<VolumeLightPtr> &addedLights = worldStreamer->getAddedLights();
+    lights.insert(lights.end(), addedLights.begin(), addedLights.end());
+}
+
+void VolumeLightApp::startCapture(CaptureFormat format, const std::string &outputPath) {
+    stopCapture();
+    frameCapture = new FrameCapture(format, outputPath);
+}
+
+void VolumeLightApp::stopCapture() {
+    if (frameCapture != NULL) {
+        delete frameCapture;
+        frameCapture = NULL;
+    }
+}
+
+// Reads back an RGBA texture (bottom row first)
+static void readTexture(sgl::TexturePtr texture, int width, int height, std::vector<uint8_t> &pixels) {
+    pixels.resize(width * height * 4);
+    sgl::TextureGL *textureGL = static_cast<sgl::TextureGL*>(texture.get());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, textureGL->getTexture());
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, &pixels.front());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+sgl::TexturePtr VolumeLightApp::createHeadlessOutput(int width, int height) {
+    // The camera takes its aspect ratio from the window, which isn't visible in headless mode
+    sgl::AppSettings::get()->getMainWindow()->setWindowSize(width, height);
+    resolutionChanged(sgl::EventPtr());
+
+    renderResolution = glm::ivec2(width, height);
+    sgl::TexturePtr outputTexture = sgl::TextureManager->createEmptyTexture(width, height);
+    outputFBO = sgl::Renderer->createFBO();
+    outputFBO->bindTexture(outputTexture);
+    return outputTexture;
+}
+
+bool VolumeLightApp::runHeadless(const HeadlessSettings &settings) {
+    sgl::TexturePtr outputTexture = createHeadlessOutput(settings.width, settings.height);
+    if (settings.shadowAtlasRingSize > 0) {
+        LightManagerMap::setShadowAtlasRingSize(settings.shadowAtlasRingSize);
+    }
+    if (settings.shadowLodError >= 0.0f) {
+        shadowLodError = settings.shadowLodError;
+    }
+    if (settings.lightClusterError >= 0.0f) {
+        lightClusterError = settings.lightClusterError;
+    }
+    if (settings.lightBlurMode >= 0) {
+        LightManagerVolume::setLightBlur(LightBlurMode(settings.lightBlurMode), settings.lightBlurRadius);
+    }
+    LightManagerMap::setMultisampling(settings.sceneSamples);
+    LightManagerVolume::setMultisampling(settings.sceneSamples, settings.lightSamples);
+    LightManagerMap::setTemporalAA(settings.temporalAA);
+    setMinimapEnabled(settings.minimap);
+    LightManagerVolume::setTemporalAA(settings.temporalAA);
+    if (settings.lightFormat >= 0) {
+        LightManagerMap::setLightFormat(LightFormat(settings.lightFormat));
+        LightManagerVolume::setLightFormat(LightFormat(settings.lightFormat));
+    }
+    for (int type = 0; type < NUM_LIGHT_MANAGER_TYPES; type++) {
+        lightManagers.at(type)->setShadowLodError(shadowLodError);
+        lightManagers.at(type)->setLightClusterError(lightClusterError);
+        lightManagers.at(type)->setRenderResolution(renderResolution.x, renderResolution.y);
+        lightManagerResolutionOutdated.at(type) = false;
+    }
+    setLightManagerType(settings.lightManagerType);
+
+    if (settings.numLights >= 0) {
+        lightManager->getLights().clear();
+        sgl::AABB2 camRect = camera->getAABB2(0.0f);
+        for (int i = 0; i < settings.numLights; i++) {
+            glm::vec2 position(
+                    random.getRandomFloatBetween(camRect.min.x, camRect.max.x),
+                    random.getRandomFloatBetween(camRect.min.y, camRect.max.y));
+            glm::vec3 hsvVec(random.getRandomFloatBetween(0.0f, 360.0f), 1.0f, 0.1f);
+            glm::vec3 rgbVec = glm::rgbColor(hsvVec);
+            sgl::Color color(rgbVec.x*255, rgbVec.y*255, rgbVec.z*255);
+            lightManager->addLight(position, 10.0f, color)->setStatic(settings.staticLights);
+        }
+    }
+
+    if (!settings.worldDirectory.empty() && !loadWorld(settings.worldDirectory)) {
+        return false;
+    }
+
+    // A replay renders every frame of the trace, starting with its first frame
+    bool replay = !settings.replayFilename.empty();
+    int numFrames = settings.numFrames;
+    if (replay) {
+        if (!sessionReplayer.load(settings.replayFilename)) {
+            return false;
+        }
+        if (worldStreamer) {
+            sgl::Logfile::get()->writeError(
+                    "Error in VolumeLightApp::runHeadless: Sessions can't be replayed in streamed worlds.");
+            return false;
+        }
+        if (sessionReplayer.getNumOccluders() != primitives.size()) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in VolumeLightApp::runHeadless: \""
+                    + settings.replayFilename + "\" was recorded in a different scene.");
+            return false;
+        }
+        sessionReplayer.restart();
+        numFrames = int(sessionReplayer.getNumFrames());
+    }
+
+    // CPU time: Submitting the commands; GPU time: Timer query; Frame time: Submitting and waiting for the GPU.
+    // With frame pacing, the frame time only waits until fewer than framesInFlight frames are queued, and the timer
+    // query of a frame is read once the frame is done.
+    std::vector<double> cpuTimes, gpuTimes(numFrames, 0.0), frameTimes;
+    std::vector<int> frameManagerTypes;
+    std::vector<bool> switchFrames;
+    int framesInFlight = std::min(std::max(settings.framesInFlight, 0), 3);
+    std::vector<GLuint> timerQueries(framesInFlight + 1);
+    glGenQueries(GLsizei(timerQueries.size()), &timerQueries.front());
+    auto readTimerQuery = [&](int frame) {
+        GLuint64 gpuTimeNs = 0;
+        glGetQueryObjectui64v(timerQueries.at(frame % timerQueries.size()), GL_QUERY_RESULT, &gpuTimeNs);
+        gpuTimes.at(frame) = double(gpuTimeNs) * 1e-6;
+    };
+    if (framesInFlight > 0) {
+        framePacer.setMaxFramesInFlight(framesInFlight);
+        framePacer.resetStats();
+    }
+    for (int frame = 0; frame < numFrames; frame++) {
+        auto startTime = std::chrono::steady_clock::now();
+        if (framesInFlight > 0) {
+            framePacer.beginFrame();
+            // There are no input events without a display, so every frame simulates input when it starts
+            framePacer.recordInput(std::chrono::steady_clock::now());
+        }
+        if (replay) {
+            sessionReplayer.replayFrame(lightManager->getLights(), primitives, camera);
+            updateOccluderBounds();
+        }
+        if (worldStreamer) {
+            // Fixed time steps, so the streamed chunks don't depend on the frame times
+            const float dt = 1.0f / 60.0f;
+            camera->setPosition(camera->getPosition() + glm::vec3(settings.worldPanSpeed * dt, 0.0f, 0.0f));
+            updateWorldStreaming(dt);
+        }
+        // The switch is part of the measured frame, so its latency shows up as a frame time spike
+        bool switchManager = settings.switchInterval > 0 && frame > 0 && frame % settings.switchInterval == 0;
+        if (switchManager) {
+            setLightManagerType((lightManagerType + 1) % NUM_LIGHT_MANAGER_TYPES);
+        }
+        glBeginQuery(GL_TIME_ELAPSED, timerQueries.at(frame % timerQueries.size()));
+        renderFrame();
+        glEndQuery(GL_TIME_ELAPSED);
+        auto submitTime = std::chrono::steady_clock::now();
+        if (framesInFlight > 0) {
+            framePacer.endFrame();
+        } else {
+            glFinish();
+        }
+        auto endTime = std::chrono::steady_clock::now();
+
+        if (frame >= framesInFlight) {
+            readTimerQuery(frame - framesInFlight);
+        }
+        cpuTimes.push_back(std::chrono::duration<double, std::milli>(submitTime - startTime).count());
+        frameTimes.push_back(std::chrono::duration<double, std::milli>(endTime - startTime).count());
+        frameManagerTypes.push_back(lightManagerType);
+        switchFrames.push_back(switchManager);
+    }
+    glFinish();
+    for (int frame = std::max(numFrames - framesInFlight, 0); frame < numFrames; frame++) {
+        readTimerQuery(frame);
+    }
+    glDeleteQueries(GLsizei(timerQueries.size()), &timerQueries.front());
+    sgl::Renderer->unbindFBO();
+
+    bool success = true;
+    std::ofstream file(settings.timingsFilename.c_str());
+    if (file.is_open()) {
+        file << "frame,cpu_ms,gpu_ms,frame_ms,manager,switched\n";
+        for (size_t i = 0; i < frameTimes.size(); i++) {
+            file << i << "," << cpuTimes.at(i) << "," << gpuTimes.at(i) << "," << frameTimes.at(i) << ","
+                    << frameManagerTypes.at(i) << "," << (switchFrames.at(i) ? 1 : 0) << "\n";
+        }
+        file.close();
+    } else {
+        sgl::Logfile::get()->writeError(std::string() + "Error in VolumeLightApp::runHeadless: Couldn't open file \""
+                + settings.timingsFilename + "\" for writing.");
+        success = false;
+    }
+
+    if (settings.compareWithCPU) {
+        std::vector<uint8_t> lightBuffer;
+        readTexture(lightManager->getLightTexture(), settings.width, settings.height, lightBuffer);
+
+        LightManagerCPU referenceManager(camera);
+        referenceManager.setOccluders(primitives);
+        referenceManager.setRenderResolution(settings.width, settings.height);
+        referenceManager.setLightStore(lightManager->getLightStore());
+        referenceManager.beginRenderLightmap();
+        referenceManager.renderLightmap([]{});
+        referenceManager.endRenderLightmap();
+
+        const std::vector<uint8_t> &referenceBuffer = referenceManager.getLightBuffer();
+        int numDifferentPixels = 0, maxDifference = 0;
+        for (size_t i = 0; i < lightBuffer.size(); i += 4) {
+            int pixelDifference = 0;
+            for (size_t j = i; j < i + 3; j++) {
+                int difference = std::abs(int(lightBuffer.at(j)) - int(referenceBuffer.at(j)));
+                pixelDifference = std::max(pixelDifference, difference);
+            }
+            numDifferentPixels += pixelDifference > 0 ? 1 : 0;
+            maxDifference = std::max(maxDifference, pixelDifference);
+        }
+        sgl::Logfile::get()->writeInfo(std::string() + "Comparison with LightManagerCPU: "
+                + sgl::toString(numDifferentPixels) + " of " + sgl::toString(settings.width * settings.height)
+                + " pixels differ, maximum difference: " + sgl::toString(maxDifference));
+    }
+
+    if (!settings.pngFilename.empty()) {
+        std::vector<uint8_t> pixels;
+        readTexture(outputTexture, settings.width, settings.height, pixels);
+        sgl::Bitmap bitmap;
+        bitmap.fromMemory(&pixels.front(), settings.width, settings.height, 32);
+        // OpenGL stores the bottom row first
+        bitmap.savePNG(settings.pngFilename.c_str(), true);
+    }
+
+    if (settings.switchInterval > 0) {
+        std::vector<double> switchFrameTimes, otherFrameTimes;
+        for (size_t i = 0; i < frameTimes.size(); i++) {
+            (switchFrames.at(i) ? switchFrameTimes : otherFrameTimes).push_back(frameTimes.at(i));
+        }
+        if (!switchFrameTimes.empty() && !otherFrameTimes.empty()) {
+            std::sort(switchFrameTimes.begin(), switchFrameTimes.end());
+            std::sort(otherFrameTimes.begin(), otherFrameTimes.end());
+            sgl::Logfile::get()->writeInfo(std::string() + "Light manager switches: "
+                    + sgl::toString(int(switchFrameTimes.size())) + ", median frame time with switch: "
+                    + sgl::toString(switchFrameTimes.at(switchFrameTimes.size()/2)) + "ms (maximum: "
+                    + sgl::toString(switchFrameTimes.back()) + "ms), without switch: "
+                    + sgl::toString(otherFrameTimes.at(otherFrameTimes.size()/2)) + "ms");
+        }
+    }
+
+    if (!frameTimes.empty()) {
+        std::sort(frameTimes.begin(), frameTimes.end());
+        std::sort(gpuTimes.begin(), gpuTimes.end());
+        sgl::Logfile::get()->writeInfo(std::string() + "Rendered " + sgl::toString(numFrames)
+                + " frames with " + sgl::toString(int(lightManager->getLights().size()))
+                + " lights. Median frame time: "
+                + sgl::toString(frameTimes.at(frameTimes.size()/2)) + "ms, median GPU time: "
+                + sgl::toString(gpuTimes.at(gpuTimes.size()/2)) + "ms");
+    }
+    if (replay && !frameTimes.empty()) {
+        sgl::Logfile::get()->writeInfo(std::string() + "Replayed \"" + settings.replayFilename + "\" ("
+                + sgl::toString(sessionReplayer.getRecordedDuration()) + "s recorded). Frame time p95/p99/max: "
+                + sgl::toString(frameTimes.at(frameTimes.size() * 95 / 100)) + "/"
+                + sgl::toString(frameTimes.at(frameTimes.size() * 99 / 100)) + "/"
+                + sgl::toString(frameTimes.back()) + "ms");
+    }
+    if (framesInFlight > 0) {
+        FramePacerStats stats = framePacer.getStats();
+        sgl::Logfile::get()->writeInfo(std::string() + "Frame pacing with " + sgl::toString(framesInFlight)
+                + " frames in flight: " + sgl::toString(stats.framesPerSecond)
+                + " frames/s, input latency p50/p95/p99: " + sgl::toString(stats.latencyP50Ms) + "/"
+                + sgl::toString(stats.latencyP95Ms) + "/" + sgl::toString(stats.latencyP99Ms)
+                + "ms, CPU wait per frame: " + sgl::toString(stats.meanWaitMs) + "ms");
+    }
+    if (worldStreamer) {
+        WorldStreamerStats stats = worldStreamer->getStats();
+        sgl::Logfile::get()->writeInfo(std::string() + "World streaming: " + sgl::toString(stats.numResidentChunks)
+                + " resident chunks (" + sgl::toString(double(stats.residentBytes) / (1024.0 * 1024.0)) + " MiB), "
+                + sgl::toString(stats.numEvictedChunks) + " evicted, " + sgl::toString(stats.numInvalidChunks)
+                + " invalid, " + sgl::toString(stats.uploadMiBPerSecond) + " MiB/s uploaded");
+    }
+    if (lightClusterError > 0.0f && lightManager->getNumLightGroups() > 0) {
+        sgl::Logfile::get()->writeInfo(std::string() + "Light clustering with " + sgl::toString(lightClusterError)
+                + "px error: " + sgl::toString(lightManager->getNumLightGroups()) + " shadow passes in the last frame");
+    }
+
+    // Cost of one light in the light buffer, to compare the light formats. The traffic is the estimate of the light
+    // manager (reads and writes of the blended light buffer, and of the stencil buffer for shadow volumes), and the
+    // GPU time covers the whole frame, not only the light passes.
+    int lightBytesPerPixel = lightManager->getLightBytesPerPixel();
+    size_t numLights = lightManager->getLights().size();
+    if (lightBytesPerPixel > 0 && numLights > 0 && !gpuTimes.empty()) {
+        LightFormat format = getSupportedLightFormat(
+                LightFormat(settings.lightFormat >= 0 ? settings.lightFormat : LIGHT_FORMAT_RGBA8));
+        double mebibytesPerLight = double(lightBytesPerPixel) * settings.width * settings.height / (1024.0 * 1024.0);
+        sgl::Logfile::get()->writeInfo(std::string() + "Light format " + LIGHT_FORMAT_NAMES[format] + ": "
+                + sgl::toString(lightBytesPerPixel) + " bytes per pixel and light, i.e., "
+                + sgl::toString(mebibytesPerLight) + " MiB of estimated framebuffer reads and writes per light. "
+                + "Median frame GPU time divided by the number of lights: "
+                + sgl::toString(gpuTimes.at(gpuTimes.size()/2) / double(numLights)) + "ms");
+    }
+
+    FrameGraph *frameGraph = lightManager->getFrameGraph();
+    if (frameGraph) {
+        sgl::Logfile::get()->writeInfo(std::string() + "Frame graph of light manager "
+                + sgl::toString(int(lightManagerType)) + " at " + sgl::toString(settings.width) + "x"
+                + sgl::toString(settings.height) + " with MSAA " + sgl::toString(settings.sceneSamples) + "x (scene), "
+                + sgl::toString(settings.lightSamples) + "x (light)" + (settings.temporalAA ? ", TAA" : "")
+                + ":\n" + frameGraph->getReport());
+    }
+
+    outputFBO = sgl::FramebufferObjectPtr();
+    return success;
 }
 
 void VolumeLightApp::renderScene() {
-    sgl::Renderer->setProjectionMatrix(camera->getProjectionMatrix());
-    sgl::Renderer->setViewMatrix(camera->getViewMatrix());
+    renderScene(camera);
+}
+
+void VolumeLightApp::renderScene(sgl::CameraPtr viewCamera) {
+    PROFILE_SCOPE("VolumeLightApp::renderScene");
+    sgl::Renderer->setProjectionMatrix(viewCamera->getProjectionMatrix());
+    sgl::Renderer->setViewMatrix(viewCamera->getViewMatrix());
     sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
 
     for (PrimitivePtr &p : primitives) {
@@ -177,39 +770,258 @@ void VolumeLightApp::renderScene() {
     }
 }
 
-void VolumeLightApp::renderEdges() {
-    sgl::Renderer->setProjectionMatrix(camera->getProjectionMatrix());
+void VolumeLightApp::renderEdges(LightManagerInterface *manager) {
+    PROFILE_SCOPE("VolumeLightApp::renderEdges");
+    sgl::Renderer->setProjectionMatrix(manager->getJitteredProjectionMatrix(camera->getProjectionMatrix()));
     sgl::Renderer->setViewMatrix(camera->getViewMatrix());
     sgl::Renderer->setModelMatrix(sgl::matrixIdentity());
 
     for (PrimitivePtr &p : primitives) {
-        p->renderEdges();
+        p->renderEdges(manager->selectEdgeLod(*p));
     }
 }
 
-void VolumeLightApp::render()
+void VolumeLightApp::renderFrame()
 {
-    bool wireframe = false;
-
-    if (videoWriter == NULL) {
-        //videoWriter = new VideoWriter("video.mp4");
-    }
-
     sgl::Renderer->setCamera(camera);
 
     lightManager->beginRenderScene();
-    // Render scene
-    renderScene();
+    // Render scene (unless only the light is shown)
+    if (lightManager->isSceneNeeded()) {
+        renderScene();
+    }
     lightManager->endRenderScene();
 
     lightManager->beginRenderLightmap();
     // Render edge silhouettes that get extruded to infinity to create shadow volumes
-    lightManager->renderLightmap([this]{ renderEdges(); });
+    LightManagerInterface *manager = lightManager.get();
+    lightManager->renderLightmap([this, manager]{ renderEdges(manager); });
     lightManager->endRenderLightmap();
 
-    // Blit compostited scene to screen framebuffer
+    // Blit compostited scene to screen framebuffer (or the offscreen target in headless mode)
+    if (outputFBO) {
+        sgl::Renderer->bindFBO(outputFBO);
+        glViewport(0, 0, renderResolution.x, renderResolution.y);
+    }
     lightManager->blitMixSceneAndLights();
 
+    // The additional views reuse the shadow data of the frame (if the manager supports it)
+    if (showMinimap) {
+        lightManager->renderAdditionalViews([this](sgl::CameraPtr viewCamera){ renderScene(viewCamera); });
+    }
+}
+
+// Least squares fit of values = sum_j coefficients[j] * features[i][j]. The columns are scaled to a maximum of one,
+// as the normal equations of features that differ by orders of magnitude are badly conditioned.
+static bool fitLeastSquares(
+        const std::vector<std::vector<double>> &features, const std::vector<double> &values,
+        std::vector<double> &coefficients) {
+    size_t numCoefficients = features.empty() ? 0 : features.front().size();
+    if (features.size() < numCoefficients || numCoefficients == 0) {
+        return false;
+    }
+    std::vector<double> scales(numCoefficients, 0.0);
+    for (const std::vector<double> &row : features) {
+        for (size_t j = 0; j < numCoefficients; j++) {
+            scales.at(j) = std::max(scales.at(j), std::abs(row.at(j)));
+        }
+    }
+
+    // Normal equations (A^T A) x = A^T b as augmented matrix
+    std::vector<std::vector<double>> system(numCoefficients, std::vector<double>(numCoefficients + 1, 0.0));
+    for (size_t i = 0; i < features.size(); i++) {
+        for (size_t j = 0; j < numCoefficients; j++) {
+            double aj = scales.at(j) > 0.0 ? features.at(i).at(j) / scales.at(j) : 0.0;
+            for (size_t k = 0; k < numCoefficients; k++) {
+                double ak = scales.at(k) > 0.0 ? features.at(i).at(k) / scales.at(k) : 0.0;
+                system.at(j).at(k) += aj * ak;
+            }
+            system.at(j).at(numCoefficients) += aj * values.at(i);
+        }
+    }
+
+    // Gaussian elimination with partial pivoting
+    for (size_t col = 0; col < numCoefficients; col++) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < numCoefficients; row++) {
+            if (std::abs(system.at(row).at(col)) > std::abs(system.at(pivot).at(col))) {
+                pivot = row;
+            }
+        }
+        if (std::abs(system.at(pivot).at(col)) < 1e-12) {
+            // The grid doesn't vary this parameter
+            return false;
+        }
+        std::swap(system.at(col), system.at(pivot));
+        for (size_t row = 0; row < numCoefficients; row++) {
+            if (row != col) {
+                double factor = system.at(row).at(col) / system.at(col).at(col);
+                for (size_t k = col; k <= numCoefficients; k++) {
+                    system.at(row).at(k) -= factor * system.at(col).at(k);
+                }
+            }
+        }
+    }
+    coefficients.resize(numCoefficients);
+    for (size_t j = 0; j < numCoefficients; j++) {
+        coefficients.at(j) = system.at(j).at(numCoefficients) / system.at(j).at(j) / scales.at(j);
+    }
+    return true;
+}
+
+bool VolumeLightApp::runSweep(const SweepSettings &settings) {
+    createHeadlessOutput(settings.width, settings.height);
+    for (int type = 0; type < NUM_LIGHT_MANAGER_TYPES; type++) {
+        lightManagers.at(type)->setRenderResolution(renderResolution.x, renderResolution.y);
+        lightManagerResolutionOutdated.at(type) = false;
+    }
+
+    std::ofstream file(settings.csvFilename.c_str());
+    if (!file.is_open()) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in VolumeLightApp::runSweep: Couldn't open file \""
+                + settings.csvFilename + "\" for writing.");
+        return false;
+    }
+    file << "manager,occluders,edges_per_occluder,edges,lights,shape,distribution,motion,frame_ms,gpu_ms\n";
+
+    // Per light manager: Features (1, edges, lights, lights * edges) and median GPU times of all cells
+    std::vector<std::vector<std::vector<double>>> cellFeatures(NUM_LIGHT_MANAGER_TYPES);
+    std::vector<std::vector<double>> cellGpuTimes(NUM_LIGHT_MANAGER_TYPES);
+    GLuint timerQuery;
+    glGenQueries(1, &timerQuery);
+    sgl::AABB2 area = camera->getAABB2(0.0f);
+    for (int numOccluders : settings.occluderCounts) {
+        for (int edgesPerOccluder : settings.edgeCounts) {
+            if (settings.scene.occluderShape == OCCLUDER_BOX && edgesPerOccluder != settings.edgeCounts.front()) {
+                continue;
+            }
+            for (int numLights : settings.lightCounts) {
+                // The same scene for all light managers
+                SceneGeneratorSettings sceneSettings = settings.scene;
+                sceneSettings.numOccluders = numOccluders;
+                sceneSettings.edgesPerOccluder = edgesPerOccluder;
+                sceneSettings.numLights = numLights;
+                GeneratedScene scene(sceneSettings, area, plainShader, edgeShader);
+                // Static lights would only be blitted from the cache of the light managers after the first frame, so
+                // all lights are dynamic and every frame renders all of them. The motion only decides what moves.
+                for (const VolumeLightPtr &light : scene.getLights()) {
+                    light->setStatic(false);
+                }
+                setScene(scene.getOccluders(), scene.getLights());
+
+                for (int type : settings.lightManagerTypes) {
+                    setLightManagerType(type);
+                    std::vector<double> frameTimes, gpuTimes;
+                    for (int frame = 0; frame < settings.numWarmupFrames + settings.numFrames; frame++) {
+                        // The same motion for every light manager
+                        scene.animate(float(frame) / 60.0f);
+                        updateOccluderBounds();
+                        auto startTime = std::chrono::steady_clock::now();
+                        glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+                        renderFrame();
+                        glEndQuery(GL_TIME_ELAPSED);
+                        glFinish();
+                        auto endTime = std::chrono::steady_clock::now();
+                        GLuint64 gpuTimeNs = 0;
+                        glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &gpuTimeNs);
+                        if (frame >= settings.numWarmupFrames) {
+                            frameTimes.push_back(
+                                    std::chrono::duration<double, std::milli>(endTime - startTime).count());
+                            gpuTimes.push_back(double(gpuTimeNs) * 1e-6);
+                        }
+                    }
+                    if (frameTimes.empty()) {
+                        continue;
+                    }
+                    std::sort(frameTimes.begin(), frameTimes.end());
+                    std::sort(gpuTimes.begin(), gpuTimes.end());
+                    double frameMs = frameTimes.at(frameTimes.size() / 2);
+                    double gpuMs = gpuTimes.at(gpuTimes.size() / 2);
+                    double numEdges = double(scene.getNumEdges());
+                    // Boxes always have four edges, independent of the swept edge count
+                    size_t sceneEdgesPerOccluder = numOccluders > 0 ? scene.getNumEdges() / size_t(numOccluders) : 0;
+                    file << type << "," << numOccluders << "," << sceneEdgesPerOccluder << "," << scene.getNumEdges()
+                            << "," << numLights << "," << OCCLUDER_SHAPE_NAMES[sceneSettings.occluderShape] << ","
+                            << SPATIAL_DISTRIBUTION_NAMES[sceneSettings.distribution] << ","
+                            << sceneSettings.motionFraction << "," << frameMs << "," << gpuMs << "\n";
+                    cellFeatures.at(type).push_back({ 1.0, numEdges, double(numLights), numLights * numEdges });
+                    cellGpuTimes.at(type).push_back(gpuMs);
+                }
+            }
+        }
+    }
+    glDeleteQueries(1, &timerQuery);
+    sgl::Renderer->unbindFBO();
+    file.close();
+
+    // gpu_ms = fixed + edges * per_edge + lights * per_light + lights * edges * per_light_edge
+    std::string fitFilename =
+            settings.csvFilename.substr(0, settings.csvFilename.find_last_of('.')) + "_fit.csv";
+    std::ofstream fitFile(fitFilename.c_str());
+    fitFile << "manager,fixed_ms,per_edge_ms,per_light_ms,per_light_edge_ms,r2\n";
+    std::vector<std::vector<double>> fits(NUM_LIGHT_MANAGER_TYPES);
+    for (int type : settings.lightManagerTypes) {
+        const std::vector<double> &values = cellGpuTimes.at(type);
+        std::vector<double> &coefficients = fits.at(type);
+        if (!fitLeastSquares(cellFeatures.at(type), values, coefficients)) {
+            sgl::Logfile::get()->writeInfo(std::string() + LIGHT_MANAGER_NAMES[type]
+                    + ": Not enough varied cells to fit the costs.");
+            continue;
+        }
+        double mean = 0.0, residualSum = 0.0, totalSum = 0.0;
+        for (double value : values) {
+            mean += value / double(values.size());
+        }
+        for (size_t i = 0; i < values.size(); i++) {
+            double predicted = 0.0;
+            for (size_t j = 0; j < coefficients.size(); j++) {
+                predicted += coefficients.at(j) * cellFeatures.at(type).at(i).at(j);
+            }
+            residualSum += (values.at(i) - predicted) * (values.at(i) - predicted);
+            totalSum += (values.at(i) - mean) * (values.at(i) - mean);
+        }
+        double r2 = totalSum > 0.0 ? 1.0 - residualSum / totalSum : 1.0;
+        fitFile << type << "," << coefficients.at(0) << "," << coefficients.at(1) << "," << coefficients.at(2) << ","
+                << coefficients.at(3) << "," << r2 << "\n";
+        sgl::Logfile::get()->writeInfo(std::string() + LIGHT_MANAGER_NAMES[type] + ": "
+                + sgl::toString(coefficients.at(0)) + "ms + " + sgl::toString(coefficients.at(2) * 1e3)
+                + "us per light + " + sgl::toString(coefficients.at(3) * 1e6) + "ns per light and edge + "
+                + sgl::toString(coefficients.at(1) * 1e6) + "ns per edge (R^2 = " + sgl::toString(r2) + ")");
+    }
+
+    // Shadow maps minus shadow volumes is linear in the number of edges for a fixed number of lights
+    const std::vector<double> &mapFit = fits.at(0), &volumeFit = fits.at(1);
+    if (!mapFit.empty() && !volumeFit.empty()) {
+        for (int numLights : settings.lightCounts) {
+            double offset = (mapFit.at(0) - volumeFit.at(0)) + (mapFit.at(2) - volumeFit.at(2)) * numLights;
+            double slope = (mapFit.at(1) - volumeFit.at(1)) + (mapFit.at(3) - volumeFit.at(3)) * numLights;
+            double crossoverEdges = slope != 0.0 ? -offset / slope : -1.0;
+            if (crossoverEdges > 0.0) {
+                sgl::Logfile::get()->writeInfo(std::string() + "With " + sgl::toString(numLights)
+                        + " lights, shadow maps are faster " + (slope < 0.0 ? "above " : "below ")
+                        + sgl::toString(int(crossoverEdges)) + " edges.");
+            } else {
+                // No crossover at a positive number of edges
+                bool mapFaster = slope != 0.0 ? slope < 0.0 : offset < 0.0;
+                sgl::Logfile::get()->writeInfo(std::string() + "With " + sgl::toString(numLights) + " lights, "
+                        + (mapFaster ? "shadow maps" : "shadow volumes") + " are always faster.");
+            }
+        }
+    }
+    return true;
+}
+
+void VolumeLightApp::render()
+{
+    PROFILE_SCOPE("VolumeLightApp::render");
+    bool wireframe = false;
+
+    // The state after all updates since the last frame is the one that is rendered
+    if (sessionRecorder) {
+        sessionRecorder->recordFrame(unrecordedTime, lightManager->getLights(), primitives, camera->getPosition());
+        unrecordedTime = 0.0f;
+    }
+    renderFrame();
 
     // User interaction: Render light handles
     sgl::Renderer->setViewMatrix(camera->getViewMatrix());
@@ -231,7 +1043,11 @@ void VolumeLightApp::render()
 
     renderGUI();
 
-    //videoWriter->pushWindowFrame();
+    if (frameCapture != NULL) {
+        sgl::Window *window = sgl::AppSettings::get()->getMainWindow();
+        frameCapture->captureFrame(window->getWidth(), window->getHeight());
+    }
+    framePacer.endFrame();
 }
 
 void VolumeLightApp::renderGUI() {
@@ -244,20 +1060,101 @@ void VolumeLightApp::renderGUI() {
         bool changeMode = false;
         static int mode = 0;
         changeMode |= ImGui::RadioButton("Shadow Maps", &lightManagerType, 0); ImGui::SameLine();
-        changeMode |= ImGui::RadioButton("Shadow Volumes", &lightManagerType, 1);
+        changeMode |= ImGui::RadioButton("Shadow Volumes", &lightManagerType, 1); ImGui::SameLine();
+        changeMode |= ImGui::RadioButton("CPU", &lightManagerType, 2); ImGui::SameLine();
+        changeMode |= ImGui::RadioButton("Visibility Polygons", &lightManagerType, 3); ImGui::SameLine();
+        changeMode |= ImGui::RadioButton("Distance Field", &lightManagerType, 4); ImGui::SameLine();
+        changeMode |= ImGui::RadioButton("Radiance Cascades", &lightManagerType, 5);
         if (changeMode) {
-            auto lights = lightManager->getLights();
-            if (lightManagerType == 0) {
-                lightManager = boost::shared_ptr<LightManagerInterface>(new LightManagerMap(camera));
+            setLightManagerType(lightManagerType);
+        }
+
+        if (ImGui::SliderFloat("Shadow LOD Error (px)", &shadowLodError, 0.0f, 8.0f)) {
+            for (boost::shared_ptr<LightManagerInterface> &manager : lightManagers) {
+                manager->setShadowLodError(shadowLodError);
+            }
+        }
+        if (ImGui::SliderFloat("Light Cluster Error (px)", &lightClusterError, 0.0f, 16.0f)) {
+            for (boost::shared_ptr<LightManagerInterface> &manager : lightManagers) {
+                manager->setLightClusterError(lightClusterError);
+            }
+        }
+        if (ImGui::Checkbox("Minimap (shadow maps only)", &showMinimap)) {
+            setMinimapEnabled(showMinimap);
+        }
+        // Only the managers with shadow passes (shadow maps and shadow volumes) cluster the lights
+        if (lightClusterError > 0.0f && lightManager->getNumLightGroups() > 0) {
+            ImGui::Text("Shadow passes: %d", lightManager->getNumLightGroups());
+        }
+
+        if (worldStreamer) {
+            WorldStreamerStats stats = worldStreamer->getStats();
+            ImGui::Text("Chunks: %d resident, %d loading, %d uploading, %d evicted",
+                    stats.numResidentChunks, stats.numLoadingChunks, stats.numUploadingChunks,
+                    int(stats.numEvictedChunks));
+            ImGui::Text("Resident: %.1f/%.1f MiB, upload: %.2f MiB/s",
+                    double(stats.residentBytes) / (1024.0 * 1024.0),
+                    double(worldStreamer->getMemoryCap()) / (1024.0 * 1024.0), stats.uploadMiBPerSecond);
+            int uploadBudgetKiB = int(worldStreamer->getUploadBudget() / 1024);
+            if (ImGui::SliderInt("Upload Budget (KiB/frame)", &uploadBudgetKiB, 64, 16384)) {
+                worldStreamer->setUploadBudget(size_t(uploadBudgetKiB) * 1024);
+            }
+            int memoryCapMiB = int(worldStreamer->getMemoryCap() / (1024 * 1024));
+            if (ImGui::SliderInt("Memory Cap (MiB)", &memoryCapMiB, 1, 1024)) {
+                worldStreamer->setMemoryCap(size_t(memoryCapMiB) * 1024 * 1024);
+            }
+        }
+
+        ImGui::SliderFloat("Texels/Unit", &bakeTexelsPerUnit, 64.0f, 4096.0f);
+        if (ImGui::Button("Bake Static Lights")) {
+            bakeRequested = true;
+        }
+        if (bakedLightmap) {
+            ImGui::SameLine();
+            if (bakedLightmap->matchesLights(lightManager->getLights())) {
+                ImGui::Text("Using baked lightmap (%d lights)", int(bakedLightmap->getNumBakedLights()));
             } else {
-                lightManager = boost::shared_ptr<LightManagerInterface>(new LightManagerVolume(camera));
+                ImGui::Text("Baked lightmap outdated");
             }
-            edgeShader = lightManager->getEdgeShader();
-            for (PrimitivePtr &primitive : primitives) {
-                primitive->setEdgeShader(edgeShader);
+        }
+
+        int framesInFlight = framePacer.getMaxFramesInFlight();
+        if (ImGui::SliderInt("Frames in Flight", &framesInFlight, 1, 3)) {
+            framePacer.setMaxFramesInFlight(framesInFlight);
+            framePacer.resetStats();
+        }
+        FramePacerStats pacerStats = framePacer.getStats();
+        ImGui::Text("%.1f fps, input latency p50/p95/p99: %.1f/%.1f/%.1f ms", pacerStats.framesPerSecond,
+                pacerStats.latencyP50Ms, pacerStats.latencyP95Ms, pacerStats.latencyP99Ms);
+        ImGui::SameLine();
+        if (ImGui::Button("Reset")) {
+            framePacer.resetStats();
+        }
+
+        bool profilerEnabled = Profiler::get()->isEnabled();
+        if (ImGui::Checkbox("CPU Profiler", &profilerEnabled)) {
+            Profiler::get()->setEnabled(profilerEnabled);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Save Trace")) {
+            Profiler::get()->saveTrace("trace.json");
+        }
+
+        bool recordSession = sessionRecorder.get() != NULL;
+        if (ImGui::Checkbox("Record Session", &recordSession)) {
+            if (recordSession) {
+                startRecording("session.trace");
+            } else {
+                stopRecording();
             }
-            for (VolumeLightPtr &light : lights) {
-                lightManager->addLight(light->getPosition(), light->getRadius(), light->getColor());
+        }
+        ImGui::SameLine();
+        bool recordVideo = frameCapture != NULL;
+        if (ImGui::Checkbox("Record Video", &recordVideo)) {
+            if (recordVideo) {
+                startCapture(CAPTURE_VIDEO, "video.mp4");
+            } else {
+                stopCapture();
             }
         }
 
@@ -271,15 +1168,30 @@ void VolumeLightApp::renderGUI() {
 
 void VolumeLightApp::processSDLEvent(const SDL_Event &event) {
     sgl::ImGuiWrapper::get()->processSDLEvent(event);
+    if (event.type == SDL_MOUSEMOTION || event.type == SDL_MOUSEBUTTONDOWN || event.type == SDL_MOUSEBUTTONUP
+            || event.type == SDL_KEYDOWN) {
+        // The timestamp of the event (milliseconds since SDL was initialized) includes the time it was queued
+        uint32_t eventAgeMs = SDL_GetTicks() - event.common.timestamp;
+        framePacer.recordInput(std::chrono::steady_clock::now() - std::chrono::milliseconds(eventAgeMs));
+    }
 }
 
 void VolumeLightApp::resolutionChanged(sgl::EventPtr event) {
     camera->onResolutionChanged(event);
+    // A quarter of the window in each dimension, i.e., the aspect ratio of the main camera
+    minimapCamera->onResolutionChanged(event);
+    sgl::Window *window = sgl::AppSettings::get()->getMainWindow();
+    minimapView->setResolution(std::max(window->getWidth() / 4, 1), std::max(window->getHeight() / 4, 1));
     lightManager->onResolutionChanged();
+    for (int type = 0; type < NUM_LIGHT_MANAGER_TYPES; type++) {
+        lightManagerResolutionOutdated.at(type) = type != lightManagerType;
+    }
     camera->onResolutionChanged(event);
 }
 
 void VolumeLightApp::update(float dt) {
+    PROFILE_SCOPE("VolumeLightApp::update");
+    framePacer.beginFrame();
     AppLogic::update(dt);
 
     if (benchmark) {
@@ -307,8 +1219,19 @@ void VolumeLightApp::update(float dt) {
         }
     }
 
+    updateOccluderBounds();
+    unrecordedTime += dt;
 
 
+    updateWorldStreaming(dt);
+
+    if (bakeRequested) {
+        bakeRequested = false;
+        if (bakeStaticLights(lightManagerType, bakeTexelsPerUnit)) {
+            loadBakedLightmap();
+        }
+    }
+
     ImGuiIO &io = ImGui::GetIO();
     if (io.WantCaptureKeyboard) {
         // Ignore inputs below
@@ -318,23 +1241,16 @@ void VolumeLightApp::update(float dt) {
     glm::vec2 mousepos = camera->mousePositionInPlane(0.0f);
 
     if (sgl::Keyboard->keyPressed(SDLK_RETURN)) {
-        auto lights = lightManager->getLights();
-        if (lightManagerType == 0) {
-            lightManagerType = 1;
-            lightManager = boost::shared_ptr<LightManagerInterface>(new LightManagerVolume(camera));
-        } else {
-            lightManagerType = 0;
-            lightManager = boost::shared_ptr<LightManagerInterface>(new LightManagerMap(camera));
-        }
-        edgeShader = lightManager->getEdgeShader();
-        for (PrimitivePtr &primitive : primitives) {
-            primitive->setEdgeShader(edgeShader);
-        }
-        for (VolumeLightPtr &light : lights) {
-            lightManager->addLight(light->getPosition(), light->getRadius(), light->getColor());
-        }
+        setLightManagerType((lightManagerType + 1) % NUM_LIGHT_MANAGER_TYPES);
+    }
+    if (worldStreamer) {
+        glm::vec3 panDirection(0.0f);
+        panDirection.x = (sgl::Keyboard->isKeyDown(SDLK_RIGHT) ? 1.0f : 0.0f)
+                - (sgl::Keyboard->isKeyDown(SDLK_LEFT) ? 1.0f : 0.0f);
+        panDirection.y = (sgl::Keyboard->isKeyDown(SDLK_UP) ? 1.0f : 0.0f)
+                - (sgl::Keyboard->isKeyDown(SDLK_DOWN) ? 1.0f : 0.0f);
+        camera->setPosition(camera->getPosition() + panDirection * cameraPanSpeed * dt);
     }
-
 
     if (io.WantCaptureMouse) {
         // Ignore inputs below
@@ -358,7 +1274,10 @@ void VolumeLightApp::update(float dt) {
     if (sgl::Mouse->buttonPressed(1)) {
         for (VolumeLightPtr &light : lightManager->getLights()) {
             if (glm::distance(light->getPosition(), mousepos) <= grabPointRadius) {
+                // Lights being dragged are treated as dynamic to keep the static light cache valid
                 grabbedLight = light;
+                grabbedLightIsStatic = light->isStatic();
+                grabbedLight->setStatic(false);
                 break;
             }
         }
@@ -371,6 +1290,7 @@ void VolumeLightApp::update(float dt) {
         glm::vec3 rgbVec = glm::rgbColor(hsvVec);
         sgl::Color col = sgl::colorFromFloat(rgbVec.x, rgbVec.y, rgbVec.z, 1.0f);
         VolumeLightPtr light = lightManager->addLight(mousepos, 10.0f, col);
+        light->setStatic(true);
     }
 
     // Mouse dragged: Move light
@@ -379,7 +1299,8 @@ void VolumeLightApp::update(float dt) {
     }
 
     // Left mouse button released: Un-grab light
-    if (sgl::Mouse->buttonReleased(1)) {
+    if (sgl::Mouse->buttonReleased(1) && grabbedLight) {
+        grabbedLight->setStatic(grabbedLightIsStatic);
         grabbedLight = VolumeLightPtr();
     }
 }
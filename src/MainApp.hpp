@@ -42,42 +42,158 @@
 #include <Math/Geometry/Point2.hpp>
 #include <Graphics/Mesh/Mesh.hpp>
 #include <Graphics/Scene/Camera.hpp>
-#include <Graphics/Video/VideoWriter.hpp>
+#include <Graphics/Buffers/FBO.hpp>
 
 #include "Logic/Cube.hpp"
 #include "Logic/Primitive.hpp"
 #include "Logic/LightManagerMap.hpp"
 #include "Logic/LightManagerVolume.hpp"
+#include "Logic/LightManagerCPU.hpp"
+#include "Logic/LightManagerVisibility.hpp"
+#include "Logic/LightManagerSDF.hpp"
+#include "Logic/LightManagerRadianceCascades.hpp"
+#include "Logic/WorldStreamer.hpp"
+#include "Logic/SessionTrace.hpp"
+#include "Logic/SceneGenerator.hpp"
+#include "Utils/FrameCapture.hpp"
+#include "Utils/FramePacer.hpp"
 
 class Shape;
 typedef boost::shared_ptr<Shape> ShapePtr;
 
+// Shadow maps, shadow volumes, CPU, visibility polygons, distance field, radiance cascades (see createLightManager)
+const int NUM_LIGHT_MANAGER_TYPES = 6;
+const char *const LIGHT_MANAGER_NAMES[] = {
+        "Shadow Maps", "Shadow Volumes", "CPU", "Visibility Polygons", "Distance Field", "Radiance Cascades"
+};
+
+// Settings for rendering without a display (see VolumeLightApp::runHeadless)
+struct HeadlessSettings {
+    int width = 1280, height = 720;
+    int numFrames = 100;
+    int lightManagerType = 0;
+    int numLights = -1; // Negative: Keep the lights of the scene
+    bool staticLights = false;
+    bool compareWithCPU = false; // Compares the last light buffer with the one of LightManagerCPU
+    std::string timingsFilename = "timings.csv";
+    std::string pngFilename; // Empty: Don't save the last frame
+    int switchInterval = 0; // > 0: Switches to the next light manager every n frames to measure the switch latency
+    int shadowAtlasRingSize = 0; // > 0: Overrides the number of shadow atlases of LightManagerMap
+    float shadowLodError = -1.0f; // >= 0: Overrides the maximum on-screen error of simplified occluder outlines
+    float lightClusterError = -1.0f; // >= 0: Overrides the maximum on-screen diameter of merged light groups
+    int lightBlurMode = -1; // >= 0: Overrides the LightBlurMode of LightManagerVolume
+    float lightBlurRadius = 8.0f;
+    // MSAA sample counts of the scene (LightManagerMap and LightManagerVolume) and of the shadow volumes
+    int sceneSamples = 1, lightSamples = 1;
+    int lightFormat = -1; // >= 0: Overrides the LightFormat of LightManagerMap and LightManagerVolume
+    bool temporalAA = false; // Temporal antialiasing of the light of LightManagerMap and LightManagerVolume
+    bool minimap = false; // Renders the minimap as an additional view
+    std::string worldDirectory; // Non-empty: Streams the chunks of this world (see WorldStreamer)
+    float worldPanSpeed = 0.5f; // Units per second the camera moves to the right while streaming
+    int framesInFlight = 0; // > 0: Paces the frames with fences instead of waiting for every frame (see FramePacer)
+    std::string replayFilename; // Non-empty: Replays this session trace instead of rendering numFrames frames
+};
+
+// Settings of the scalability sweep over generated scenes (see VolumeLightApp::runSweep)
+struct SweepSettings {
+    int width = 1280, height = 720;
+    int numWarmupFrames = 5, numFrames = 20; // Per cell
+    // The grid of the sweep, all combinations are measured with every light manager
+    std::vector<int> occluderCounts = {10, 100, 1000};
+    std::vector<int> edgeCounts = {4, 16, 64}; // Edges per occluder (boxes always have four)
+    std::vector<int> lightCounts = {1, 10, 50};
+    std::vector<int> lightManagerTypes = {0, 1};
+    SceneGeneratorSettings scene; // The counts are set by the grid
+    std::string csvFilename = "sweep.csv"; // The fitted costs are saved to "<name>_fit.csv"
+};
+
 class VolumeLightApp : public sgl::AppLogic {
 public:
     VolumeLightApp();
     ~VolumeLightApp();
     void render();
+    void renderFrame(); // Renders the lit scene without user interface
     void renderGUI();
     void processSDLEvent(const SDL_Event &event);
     void renderScene(); // Renders lighted scene
-    void renderEdges(); // Renders edge lines of scene that get extruded by the geometry of "edgeShader"
+    void renderScene(sgl::CameraPtr viewCamera);
+    // Renders edge lines of scene that get extruded by the geometry of "edgeShader". The manager selects the level of
+    // detail of each occluder for the lights of its current shadow pass.
+    void renderEdges(LightManagerInterface *manager);
     void update(float dt);
     void resolutionChanged(sgl::EventPtr event);
 
+    // Renders the static lights once and saves them next to the scene (see BakedLightmap)
+    bool bakeStaticLights(int type, float texelsPerUnit);
+
+    // Asynchronous capturing of the rendered frames (see FrameCapture)
+    void startCapture(CaptureFormat format, const std::string &outputPath);
+    void stopCapture();
+
+    // Records the lights, occluders and the camera of every frame (see SessionRecorder)
+    bool startRecording(const std::string &filename);
+    void stopRecording();
+
+    // Streams the occluders and static lights of a chunked world around the camera (see WorldStreamer)
+    bool loadWorld(const std::string &worldDirectory);
+
+    // Renders a fixed number of frames to an offscreen framebuffer and saves the frame timings
+    bool runHeadless(const HeadlessSettings &settings);
+    // Measures the frame times of generated scenes for a grid of scene parameters and fits the cost per light and
+    // per edge of each light manager
+    bool runSweep(const SweepSettings &settings);
+
 private:
+    boost::shared_ptr<LightManagerInterface> createLightManager(int type);
+    // Creates all light managers up front. They share the light store and stay resident.
+    void createLightManagers();
+    void setLightManagerType(int type);
+    // Overview of the scene in the upper right corner, lit with the shadow data of the main view
+    void setMinimapEnabled(bool enabled);
+    void updateWorldStreaming(float dt);
+    // Notifies the light managers of moved dynamic occluders
+    void updateOccluderBounds();
+    // Replaces all occluders and lights, e.g. with a generated scene
+    void setScene(const std::vector<PrimitivePtr> &occluders, const std::vector<VolumeLightPtr> &lights);
+    // Resizes the window and creates the offscreen target of headless runs
+    sgl::TexturePtr createHeadlessOutput(int width, int height);
+    std::string getBakedLightmapFilename();
+    void loadBakedLightmap();
+
     // Lighting & rendering
     sgl::CameraPtr camera;
-    boost::shared_ptr<LightManagerInterface> lightManager;
+    boost::shared_ptr<LightManagerInterface> lightManager; // The active light manager
+    std::vector<boost::shared_ptr<LightManagerInterface>> lightManagers;
+    std::vector<bool> lightManagerResolutionOutdated; // Inactive managers are resized when they are activated
     int lightManagerType;
     vector<PrimitivePtr> primitives;
+    float shadowLodError = 0.5f; // In pixels, see LightManagerInterface::setShadowLodError
+    float lightClusterError = 0.0f; // In pixels, see LightManagerInterface::setLightClusterError
+    sgl::CameraPtr minimapCamera;
+    LightViewPtr minimapView;
+    bool showMinimap = false;
+    vector<sgl::AABB2> primitiveBounds; // For detecting changes of dynamic occluders
+    boost::shared_ptr<WorldStreamer> worldStreamer;
+    size_t numScenePrimitives = 0; // The streamed primitives follow the ones of the scene
+    glm::vec3 worldStartPosition; // Camera position when the first world was loaded
+    float cameraPanSpeed = 0.5f; // Arrow keys, in units per second
     sgl::ShaderProgramPtr plainShader;
     sgl::ShaderProgramPtr edgeShader;
     sgl::ShaderProgramPtr whiteSolidShader;
+    std::string sceneName = "default";
+    sgl::FramebufferObjectPtr outputFBO; // Headless mode: Offscreen target instead of the window framebuffer
+    glm::ivec2 renderResolution = glm::ivec2(0, 0); // Headless mode: Overrides the window resolution
+
+    // Precomputed lighting of the static lights
+    BakedLightmapPtr bakedLightmap;
+    float bakeTexelsPerUnit = 1024.0f;
+    bool bakeRequested = false;
 
     // User interaction
     sgl::ShaderAttributesPtr grabPointRenderData;
     float grabPointRadius;
     VolumeLightPtr grabbedLight;
+    bool grabbedLightIsStatic = false;
     sgl::XorshiftRandomGenerator random;
 
     // GUI
@@ -93,7 +209,15 @@ private:
     std::vector<int> fps;
 
     // Save video stream to file
-    sgl::VideoWriter *videoWriter;
+    FrameCapture *frameCapture;
+
+    // Limits the frames queued by the driver and measures the input latency
+    FramePacer framePacer;
+
+    // Deterministic benchmarks of recorded sessions
+    boost::shared_ptr<SessionRecorder> sessionRecorder;
+    float unrecordedTime = 0.0f; // Time steps since the last recorded frame
+    SessionReplayer sessionReplayer;
 };
 
 #endif /* LOGIC_MainApp_HPP_ */
@@ -0,0 +1,218 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstring>
+#include <cstdio>
+#include <boost/filesystem.hpp>
+
+#include <Graphics/Video/VideoWriter.hpp>
+#include <Graphics/Texture/Bitmap.hpp>
+#include <Utils/File/Logfile.hpp>
+
+#include "Profiler.hpp"
+#include "FrameCapture.hpp"
+
+FrameCapture::FrameCapture(CaptureFormat format, const std::string &outputPath, int framerate)
+        : format(format), outputPath(outputPath), framerate(framerate) {
+    // ffmpeg expects tightly packed RGB24 data, PNG files are written from RGBA data
+    bytesPerPixel = format == CAPTURE_VIDEO ? 3 : 4;
+    if (format == CAPTURE_PNG) {
+        boost::filesystem::create_directories(outputPath);
+    }
+    workerThread = std::thread(&FrameCapture::workerLoop, this);
+}
+
+FrameCapture::~FrameCapture() {
+    // Flush the frames still in flight in frame order
+    for (size_t i = 0; i < NUM_PIXEL_BUFFERS; i++) {
+        PixelBufferSlot &slot = slots[(frameIndex + i) % NUM_PIXEL_BUFFERS];
+        if (slot.pending) {
+            glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            finishReadback(slot);
+        }
+    }
+    for (size_t i = 0; i < NUM_PIXEL_BUFFERS; i++) {
+        if (slots[i].pbo != 0) {
+            glDeleteBuffers(1, &slots[i].pbo);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        quitWorker = true;
+    }
+    queueCondition.notify_all();
+    workerThread.join();
+
+    if (numDroppedFrames > 0) {
+        sgl::Logfile::get()->writeInfo(std::string() + "FrameCapture: Dropped " + std::to_string(numDroppedFrames)
+                + " of " + std::to_string(numCapturedFrames + numDroppedFrames) + " frames.");
+    }
+}
+
+void FrameCapture::captureFrame(int width, int height) {
+    PROFILE_SCOPE("FrameCapture::captureFrame");
+
+    // Hand over all readbacks that are at least two frames old and have finished on the GPU (in frame order)
+    for (size_t i = 0; i < NUM_PIXEL_BUFFERS; i++) {
+        PixelBufferSlot &slot = slots[(frameIndex + i) % NUM_PIXEL_BUFFERS];
+        if (!slot.pending || frameIndex - slot.frameIndex < 2) {
+            continue;
+        }
+        GLenum waitResult = glClientWaitSync(slot.fence, 0, 0);
+        if (waitResult != GL_ALREADY_SIGNALED && waitResult != GL_CONDITION_SATISFIED) {
+            break;
+        }
+        finishReadback(slot);
+    }
+
+    // The slot of the current frame is only still in use if the GPU is more than NUM_PIXEL_BUFFERS frames behind
+    PixelBufferSlot &slot = slots[frameIndex % NUM_PIXEL_BUFFERS];
+    if (slot.pending) {
+        glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        finishReadback(slot);
+    }
+
+    size_t bufferSize = size_t(width) * size_t(height) * size_t(bytesPerPixel);
+    if (slot.pbo == 0) {
+        glGenBuffers(1, &slot.pbo);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (slot.bufferSize != bufferSize) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, bufferSize, nullptr, GL_STREAM_READ);
+        slot.bufferSize = bufferSize;
+    }
+
+    // Asynchronous transfer to the PBO, glReadPixels returns immediately
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, format == CAPTURE_VIDEO ? GL_RGB : GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.frameIndex = frameIndex;
+    slot.width = width;
+    slot.height = height;
+    slot.pending = true;
+    frameIndex++;
+}
+
+void FrameCapture::finishReadback(PixelBufferSlot &slot) {
+    glDeleteSync(slot.fence);
+    slot.fence = 0;
+    slot.pending = false;
+
+    CapturedFrame frame;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (frameQueue.size() >= MAX_QUEUED_FRAMES) {
+            numDroppedFrames++;
+            return;
+        }
+        if (!freePixelArrays.empty()) {
+            frame.pixels.swap(freePixelArrays.back());
+            freePixelArrays.pop_back();
+        }
+    }
+
+    frame.pixels.resize(slot.bufferSize);
+    frame.width = slot.width;
+    frame.height = slot.height;
+    frame.frameIndex = slot.frameIndex;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    void *mappedData = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.bufferSize, GL_MAP_READ_BIT);
+    if (mappedData) {
+        memcpy(&frame.pixels.front(), mappedData, slot.bufferSize);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!mappedData) {
+        numDroppedFrames++;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        frameQueue.push_back(std::move(frame));
+    }
+    queueCondition.notify_one();
+    numCapturedFrames++;
+}
+
+void FrameCapture::workerLoop() {
+    while (true) {
+        CapturedFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return quitWorker || !frameQueue.empty(); });
+            if (frameQueue.empty()) {
+                break;
+            }
+            frame = std::move(frameQueue.front());
+            frameQueue.pop_front();
+        }
+
+        encodeFrame(frame);
+
+        std::lock_guard<std::mutex> lock(queueMutex);
+        freePixelArrays.push_back(std::move(frame.pixels));
+    }
+
+    if (videoWriter) {
+        delete videoWriter;
+        videoWriter = nullptr;
+    }
+}
+
+void FrameCapture::encodeFrame(CapturedFrame &frame) {
+    PROFILE_SCOPE("FrameCapture::encodeFrame");
+
+    if (format == CAPTURE_VIDEO) {
+        if (!videoWriter) {
+            videoWidth = frame.width;
+            videoHeight = frame.height;
+            videoWriter = new sgl::VideoWriter(outputPath.c_str(), videoWidth, videoHeight, framerate);
+        }
+        // The video resolution is fixed by the first frame
+        if (frame.width == videoWidth && frame.height == videoHeight) {
+            videoWriter->pushFrame(&frame.pixels.front());
+        }
+    } else {
+        char filename[32];
+        snprintf(filename, sizeof(filename), "frame_%06d.png", int(frame.frameIndex));
+        sgl::Bitmap bitmap;
+        bitmap.fromMemory(&frame.pixels.front(), frame.width, frame.height, 32);
+        // OpenGL stores the bottom row first
+        bitmap.savePNG((outputPath + "/" + filename).c_str(), true);
+    }
+}
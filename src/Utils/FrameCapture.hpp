@@ -0,0 +1,112 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef UTILS_FRAMECAPTURE_HPP_
+#define UTILS_FRAMECAPTURE_HPP_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <GL/glew.h>
+
+namespace sgl {
+class VideoWriter;
+}
+
+enum CaptureFormat {
+    CAPTURE_VIDEO, CAPTURE_PNG
+};
+
+/**
+ * Captures the window framebuffer without stalling the GPU. The pixels of frame N are read into one of a ring of
+ * pixel buffer objects and mapped two frames later, when the transfer has finished. Encoding (video or PNG files)
+ * happens on a worker thread. If the worker can't keep up, frames are dropped instead of blocking the main thread.
+ */
+class FrameCapture {
+public:
+    // outputPath: Video file for CAPTURE_VIDEO, directory for CAPTURE_PNG
+    FrameCapture(CaptureFormat format, const std::string &outputPath, int framerate = 30);
+    ~FrameCapture();
+
+    // Call after a frame was rendered to the window framebuffer
+    void captureFrame(int width, int height);
+
+    inline size_t getNumCapturedFrames() { return numCapturedFrames; }
+    inline size_t getNumDroppedFrames() { return numDroppedFrames; }
+
+private:
+    struct PixelBufferSlot {
+        GLuint pbo = 0;
+        GLsync fence = 0;
+        size_t bufferSize = 0;
+        size_t frameIndex = 0;
+        int width = 0, height = 0;
+        bool pending = false;
+    };
+    struct CapturedFrame {
+        std::vector<uint8_t> pixels;
+        int width, height;
+        size_t frameIndex;
+    };
+
+    // Maps the PBO of a finished readback and hands the pixels to the worker thread
+    void finishReadback(PixelBufferSlot &slot);
+    void workerLoop();
+    void encodeFrame(CapturedFrame &frame);
+
+    static const int NUM_PIXEL_BUFFERS = 4;
+    static const size_t MAX_QUEUED_FRAMES = 8;
+    CaptureFormat format;
+    std::string outputPath;
+    int framerate;
+    int bytesPerPixel;
+    PixelBufferSlot slots[NUM_PIXEL_BUFFERS];
+    size_t frameIndex = 0;
+    size_t numCapturedFrames = 0;
+    size_t numDroppedFrames = 0;
+
+    // Worker thread data
+    std::thread workerThread;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<CapturedFrame> frameQueue;
+    std::vector<std::vector<uint8_t>> freePixelArrays;
+    bool quitWorker = false;
+    sgl::VideoWriter *videoWriter = nullptr;
+    int videoWidth = 0, videoHeight = 0;
+};
+
+#endif /* UTILS_FRAMECAPTURE_HPP_ */
@@ -0,0 +1,316 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <Graphics/Renderer.hpp>
+#include <Utils/Convert.hpp>
+
+#include "FrameGraph.hpp"
+
+// Pooled textures that weren't used for this many frames are released (e.g., the MSAA buffers after disabling MSAA)
+const int MAX_UNUSED_FRAMES = 60;
+
+size_t FrameGraphTextureDesc::getNumBytes() const {
+    size_t bytesPerTexel = 4;
+    if (internalFormat == GL_RGBA16F || internalFormat == GL_RGBA16) {
+        bytesPerTexel = 8;
+    } else if (internalFormat == GL_RGBA32F) {
+        bytesPerTexel = 16;
+    } else if (internalFormat == GL_DEPTH_COMPONENT16 || internalFormat == GL_R16F) {
+        bytesPerTexel = 2;
+    } else if (internalFormat == GL_R8) {
+        bytesPerTexel = 1;
+    }
+    if (stencil) {
+        // 24-bit depth and 8-bit stencil
+        bytesPerTexel += 4;
+    }
+    return size_t(width) * size_t(height) * size_t(numLayers) * size_t(std::max(numSamples, 1)) * bytesPerTexel;
+}
+
+static std::string formatMiB(size_t numBytes) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.1f MiB", double(numBytes) / (1024.0 * 1024.0));
+    return buffer;
+}
+
+void FrameGraph::reset() {
+    resources.clear();
+    passes.clear();
+}
+
+FrameGraphResource FrameGraph::createTexture(const std::string &name, const FrameGraphTextureDesc &desc) {
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resources.push_back(resource);
+    return FrameGraphResource(resources.size() - 1);
+}
+
+FrameGraphResource FrameGraph::importTexture(
+        const std::string &name, sgl::TexturePtr texture, const FrameGraphTextureDesc &desc) {
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resource.importedTexture = texture;
+    resource.imported = true;
+    resources.push_back(resource);
+    return FrameGraphResource(resources.size() - 1);
+}
+
+void FrameGraph::setClearColor(FrameGraphResource resource, const sgl::Color &color) {
+    resources.at(resource).clear = true;
+    resources.at(resource).clearColor = color;
+}
+
+void FrameGraph::markOutput(FrameGraphResource resource) {
+    resources.at(resource).output = true;
+}
+
+FrameGraphPass FrameGraph::addPass(
+        const std::string &name, const std::vector<FrameGraphResource> &reads,
+        const std::vector<FrameGraphResource> &writes) {
+    Pass pass;
+    pass.name = name;
+    pass.reads = reads;
+    pass.writes = writes;
+    passes.push_back(pass);
+    return FrameGraphPass(passes.size() - 1);
+}
+
+void FrameGraph::compile() {
+    // Walk backwards from the outputs: A pass is needed if a later needed pass reads what it writes
+    std::vector<bool> needed(resources.size(), false);
+    for (size_t i = 0; i < resources.size(); i++) {
+        needed.at(i) = resources.at(i).output;
+    }
+    statistics = FrameGraphStatistics();
+    statistics.numPasses = int(passes.size());
+    for (int passIdx = int(passes.size()) - 1; passIdx >= 0; passIdx--) {
+        Pass &pass = passes.at(passIdx);
+        pass.alive = pass.writes.empty();
+        for (FrameGraphResource resource : pass.writes) {
+            pass.alive = pass.alive || needed.at(resource);
+        }
+        if (pass.alive) {
+            for (FrameGraphResource resource : pass.reads) {
+                needed.at(resource) = true;
+            }
+        } else {
+            statistics.numCulledPasses++;
+        }
+    }
+
+    for (Resource &resource : resources) {
+        resource.firstPass = resource.lastPass = -1;
+        resource.physicalIndex = -1;
+    }
+    for (int passIdx = 0; passIdx < int(passes.size()); passIdx++) {
+        Pass &pass = passes.at(passIdx);
+        if (!pass.alive) {
+            continue;
+        }
+        for (const std::vector<FrameGraphResource> *accesses : { &pass.reads, &pass.writes }) {
+            for (FrameGraphResource resourceIdx : *accesses) {
+                Resource &resource = resources.at(resourceIdx);
+                resource.firstPass = resource.firstPass < 0 ? passIdx : resource.firstPass;
+                resource.lastPass = std::max(resource.lastPass, passIdx);
+            }
+        }
+    }
+    for (Resource &resource : resources) {
+        if (resource.output && resource.firstPass >= 0) {
+            resource.lastPass = int(passes.size());
+        }
+    }
+
+    // Assign the pooled textures in pass order, a texture becomes free after the last pass of its resource
+    for (PhysicalTexture &physical : pool) {
+        physical.busyUntilPass = -1;
+    }
+    std::vector<bool> physicalUsed;
+    for (int passIdx = 0; passIdx < int(passes.size()); passIdx++) {
+        for (Resource &resource : resources) {
+            if (resource.imported || resource.firstPass != passIdx) {
+                continue;
+            }
+            resource.physicalIndex = allocatePhysicalTexture(resource.desc, passIdx);
+            pool.at(resource.physicalIndex).busyUntilPass = resource.lastPass;
+            physicalUsed.resize(pool.size(), false);
+            physicalUsed.at(resource.physicalIndex) = true;
+        }
+    }
+
+    // Release pooled textures that weren't needed for a while. The indices of the used ones are remapped.
+    physicalUsed.resize(pool.size(), false);
+    std::vector<int> newIndices(pool.size(), -1);
+    std::vector<PhysicalTexture> newPool;
+    for (size_t i = 0; i < pool.size(); i++) {
+        PhysicalTexture &physical = pool.at(i);
+        physical.numUnusedFrames = physicalUsed.at(i) ? 0 : physical.numUnusedFrames + 1;
+        if (physical.numUnusedFrames <= MAX_UNUSED_FRAMES) {
+            newIndices.at(i) = int(newPool.size());
+            newPool.push_back(physical);
+        }
+    }
+    pool = newPool;
+    for (Resource &resource : resources) {
+        if (resource.physicalIndex >= 0) {
+            resource.physicalIndex = newIndices.at(resource.physicalIndex);
+        }
+    }
+
+    std::vector<bool> physicalCounted(pool.size(), false);
+    for (Resource &resource : resources) {
+        if (resource.imported) {
+            statistics.persistentBytes += resource.desc.getNumBytes();
+        } else if (resource.physicalIndex >= 0) {
+            statistics.unaliasedTransientBytes += resource.desc.getNumBytes();
+            if (!physicalCounted.at(resource.physicalIndex)) {
+                physicalCounted.at(resource.physicalIndex) = true;
+                statistics.transientBytes += pool.at(resource.physicalIndex).desc.getNumBytes();
+            }
+        }
+    }
+}
+
+void FrameGraph::releaseTextures() {
+    pool.clear();
+    for (Resource &resource : resources) {
+        resource.physicalIndex = -1;
+    }
+}
+
+int FrameGraph::allocatePhysicalTexture(const FrameGraphTextureDesc &desc, int firstPass) {
+    for (size_t i = 0; i < pool.size(); i++) {
+        PhysicalTexture &physical = pool.at(i);
+        if (physical.desc == desc && physical.busyUntilPass < firstPass) {
+            return int(i);
+        }
+    }
+
+    PhysicalTexture physical;
+    physical.desc = desc;
+    if (desc.numSamples > 0) {
+        physical.texture = sgl::TextureManager->createMultisampledTexture(
+                desc.width, desc.height, desc.numSamples, desc.internalFormat);
+    } else {
+        sgl::TextureSettings settings;
+        settings.internalFormat = desc.internalFormat;
+        settings.pixelType = desc.internalFormat == GL_RGBA8 ? GL_UNSIGNED_BYTE : GL_FLOAT;
+        physical.texture = sgl::TextureManager->createEmptyTexture(desc.width, desc.height, settings);
+    }
+    physical.fbo = sgl::Renderer->createFBO();
+    physical.fbo->bindTexture(physical.texture);
+    if (desc.stencil) {
+        physical.stencilRbo = sgl::Renderer->createRBO(
+                desc.width, desc.height, sgl::RBO_DEPTH24_STENCIL8, desc.numSamples);
+        physical.fbo->bindRenderbuffer(physical.stencilRbo, sgl::DEPTH_STENCIL_ATTACHMENT);
+    }
+    physical.renderTarget = sgl::RenderTargetPtr(new sgl::RenderTarget());
+    physical.renderTarget->bindFramebufferObject(physical.fbo);
+    pool.push_back(physical);
+    return int(pool.size() - 1);
+}
+
+bool FrameGraph::beginPass(FrameGraphPass passIdx) {
+    if (isPassCulled(passIdx)) {
+        return false;
+    }
+    Pass &pass = passes.at(passIdx);
+    sgl::RenderTargetPtr mainTarget;
+    for (FrameGraphResource resourceIdx : pass.writes) {
+        Resource &resource = resources.at(resourceIdx);
+        if (resource.imported) {
+            continue;
+        }
+        sgl::RenderTargetPtr renderTarget = pool.at(resource.physicalIndex).renderTarget;
+        if (resource.clear && resource.firstPass == passIdx) {
+            renderTarget->bindRenderTarget();
+            GLbitfield clearMask = GL_COLOR_BUFFER_BIT | (resource.desc.stencil ? GL_STENCIL_BUFFER_BIT : 0);
+            sgl::Renderer->clearFramebuffer(clearMask, resource.clearColor);
+        }
+        if (!mainTarget) {
+            mainTarget = renderTarget;
+        }
+    }
+    if (mainTarget) {
+        mainTarget->bindRenderTarget();
+    }
+    return true;
+}
+
+sgl::TexturePtr FrameGraph::getTexture(FrameGraphResource resourceIdx) {
+    Resource &resource = resources.at(resourceIdx);
+    if (resource.imported) {
+        return resource.importedTexture;
+    }
+    return resource.physicalIndex >= 0 ? pool.at(resource.physicalIndex).texture : sgl::TexturePtr();
+}
+
+sgl::RenderTargetPtr FrameGraph::getRenderTarget(FrameGraphResource resourceIdx) {
+    Resource &resource = resources.at(resourceIdx);
+    return resource.physicalIndex >= 0 ? pool.at(resource.physicalIndex).renderTarget : sgl::RenderTargetPtr();
+}
+
+std::string FrameGraph::getReport() {
+    std::string report;
+    for (Pass &pass : passes) {
+        report += std::string() + "Pass " + pass.name + (pass.alive ? "" : " (culled)") + "\n";
+    }
+    for (Resource &resource : resources) {
+        const FrameGraphTextureDesc &desc = resource.desc;
+        report += std::string() + "Texture " + resource.name + ": " + sgl::toString(desc.width) + "x"
+                + sgl::toString(desc.height) + (desc.numSamples > 0 ? " x" + sgl::toString(desc.numSamples) : "")
+                + (desc.stencil ? " + stencil" : "")
+                + ", " + formatMiB(desc.getNumBytes());
+        if (resource.imported) {
+            report += ", persistent\n";
+        } else if (resource.firstPass < 0) {
+            report += ", unused\n";
+        } else {
+            report += ", passes " + sgl::toString(resource.firstPass) + "-"
+                    + (resource.lastPass >= int(passes.size()) ? std::string("end") : sgl::toString(resource.lastPass))
+                    + ", pooled texture " + sgl::toString(resource.physicalIndex) + "\n";
+        }
+    }
+    report += getMemorySummary() + ", " + sgl::toString(statistics.numPasses - statistics.numCulledPasses) + " of "
+            + sgl::toString(statistics.numPasses) + " passes\n";
+    return report;
+}
+
+std::string FrameGraph::getMemorySummary() {
+    return "GPU memory: " + formatMiB(statistics.transientBytes) + " transient ("
+            + formatMiB(statistics.unaliasedTransientBytes) + " without aliasing), "
+            + formatMiB(statistics.persistentBytes) + " persistent";
+}
@@ -0,0 +1,150 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef UTILS_FRAMEGRAPH_HPP_
+#define UTILS_FRAMEGRAPH_HPP_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include <GL/glew.h>
+#include <Graphics/Color.hpp>
+#include <Graphics/Buffers/FBO.hpp>
+#include <Graphics/Scene/RenderTarget.hpp>
+#include <Graphics/Texture/TextureManager.hpp>
+
+typedef int FrameGraphResource;
+typedef int FrameGraphPass;
+const FrameGraphResource FRAME_GRAPH_NONE = -1;
+
+struct FrameGraphTextureDesc {
+    FrameGraphTextureDesc() {}
+    FrameGraphTextureDesc(int width, int height, GLint internalFormat = GL_RGBA8, int numSamples = 0)
+            : width(width), height(height), internalFormat(internalFormat), numSamples(numSamples) {}
+    bool operator==(const FrameGraphTextureDesc &other) const {
+        return width == other.width && height == other.height && internalFormat == other.internalFormat
+                && numSamples == other.numSamples && numLayers == other.numLayers && stencil == other.stencil;
+    }
+    size_t getNumBytes() const;
+
+    int width = 0, height = 0;
+    GLint internalFormat = GL_RGBA8;
+    int numSamples = 0; // 0: Not multisampled
+    int numLayers = 1;
+    bool stencil = false; // Also attaches a depth-stencil renderbuffer with the same number of samples
+};
+
+struct FrameGraphStatistics {
+    int numPasses = 0;
+    int numCulledPasses = 0;
+    size_t transientBytes = 0; // Pooled textures used by the frame, i.e., after aliasing
+    size_t unaliasedTransientBytes = 0; // If every transient texture had its own memory
+    size_t persistentBytes = 0; // Imported textures (caches, shadow atlases, ...)
+};
+
+/**
+ * Small frame graph for the render targets of a light manager.
+ * - The passes of a frame are declared up front with the textures they read and write. Transient textures only
+ *   exist during the frame and are created by the graph, persistent ones (e.g., caches) are imported.
+ * - compile culls the passes whose results are neither read by a later pass nor marked as an output. Passes without
+ *   any outputs write to the currently bound framebuffer (e.g., the window) and are never culled.
+ * - Transient textures with the same description and disjoint lifetimes share one pooled texture. Pooled textures
+ *   are kept across frames, so nothing is allocated unless the configuration changes.
+ * - beginPass clears a texture before it is written for the first time (only if a clear color was set) and binds
+ *   the first transient output of the pass.
+ */
+class FrameGraph {
+public:
+    // Removes all passes and resources of the last frame. The pooled textures are kept.
+    void reset();
+    FrameGraphResource createTexture(const std::string &name, const FrameGraphTextureDesc &desc);
+    FrameGraphResource importTexture(
+            const std::string &name, sgl::TexturePtr texture, const FrameGraphTextureDesc &desc);
+    void setClearColor(FrameGraphResource resource, const sgl::Color &color);
+    // The texture is still needed after the frame (e.g., for getLightTexture)
+    void markOutput(FrameGraphResource resource);
+    // Passes are executed in the order they were added
+    FrameGraphPass addPass(
+            const std::string &name, const std::vector<FrameGraphResource> &reads,
+            const std::vector<FrameGraphResource> &writes);
+    void compile();
+    // Releases all pooled textures (e.g., if the resolution changed)
+    void releaseTextures();
+
+    // Returns false if the pass was culled
+    bool beginPass(FrameGraphPass pass);
+    inline bool isPassCulled(FrameGraphPass pass) { return pass < 0 || !passes.at(pass).alive; }
+    sgl::TexturePtr getTexture(FrameGraphResource resource);
+    sgl::RenderTargetPtr getRenderTarget(FrameGraphResource resource);
+
+    inline const FrameGraphStatistics &getStatistics() { return statistics; }
+    // Passes, lifetimes and the assigned pooled textures of the compiled frame (one line each)
+    std::string getReport();
+    // E.g., "GPU memory: 31.6 MiB transient (47.5 MiB without aliasing), 7.9 MiB persistent"
+    std::string getMemorySummary();
+
+private:
+    struct Resource {
+        std::string name;
+        FrameGraphTextureDesc desc;
+        sgl::TexturePtr importedTexture;
+        bool imported = false;
+        bool output = false;
+        bool clear = false;
+        sgl::Color clearColor;
+        int firstPass = -1, lastPass = -1; // Lifetime in the alive passes
+        int physicalIndex = -1;
+    };
+    struct Pass {
+        std::string name;
+        std::vector<FrameGraphResource> reads, writes;
+        bool alive = true;
+    };
+    struct PhysicalTexture {
+        FrameGraphTextureDesc desc;
+        sgl::TexturePtr texture;
+        sgl::FramebufferObjectPtr fbo;
+        sgl::RenderbufferObjectPtr stencilRbo; // Only if desc.stencil is set
+        sgl::RenderTargetPtr renderTarget;
+        int busyUntilPass = -1; // Last pass of the resource currently assigned (during compile)
+        int numUnusedFrames = 0;
+    };
+    int allocatePhysicalTexture(const FrameGraphTextureDesc &desc, int firstPass);
+
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    std::vector<PhysicalTexture> pool;
+    FrameGraphStatistics statistics;
+};
+
+#endif /* UTILS_FRAMEGRAPH_HPP_ */
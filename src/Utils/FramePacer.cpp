@@ -0,0 +1,165 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <algorithm>
+
+#include "Profiler.hpp"
+#include "FramePacer.hpp"
+
+FramePacer::FramePacer(int maxFramesInFlight) {
+    setMaxFramesInFlight(maxFramesInFlight);
+    calibrateClock();
+}
+
+FramePacer::~FramePacer() {
+    for (FrameInFlight &frame : framesInFlight) {
+        glDeleteSync(frame.fence);
+        freeQueries.push_back(frame.timestampQuery);
+    }
+    if (!freeQueries.empty()) {
+        glDeleteQueries(GLsizei(freeQueries.size()), &freeQueries.front());
+    }
+}
+
+void FramePacer::setMaxFramesInFlight(int frames) {
+    maxFramesInFlight = std::max(std::min(frames, 3), 1);
+}
+
+void FramePacer::calibrateClock() {
+    glGetInteger64v(GL_TIMESTAMP, &calibrationGpuTimeNs);
+    calibrationCpuTime = std::chrono::steady_clock::now();
+}
+
+void FramePacer::beginFrame() {
+    frameStartTimes.push_back(std::chrono::steady_clock::now());
+    if (frameStartTimes.size() > MAX_SAMPLES) {
+        frameStartTimes.pop_front();
+    }
+}
+
+void FramePacer::endFrame() {
+    FrameInFlight frame;
+    if (freeQueries.empty()) {
+        freeQueries.resize(1);
+        glGenQueries(1, &freeQueries.front());
+    }
+    frame.timestampQuery = freeQueries.back();
+    freeQueries.pop_back();
+    glQueryCounter(frame.timestampQuery, GL_TIMESTAMP);
+    frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame.hasInput = inputPending;
+    frame.inputTime = pendingInputTime;
+    inputPending = false;
+    framesInFlight.push_back(frame);
+
+    // Waiting at the end of the frame instead of at its start means the input of the next frame is polled after the
+    // wait, so it isn't stale by the time the frame is submitted
+    PROFILE_SCOPE("FramePacer::endFrame");
+    auto startTime = std::chrono::steady_clock::now();
+    retireFrames(size_t(maxFramesInFlight));
+    auto endTime = std::chrono::steady_clock::now();
+    totalWaitMs += std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    numWaitedFrames++;
+}
+
+void FramePacer::recordInput(std::chrono::steady_clock::time_point inputTime) {
+    if (!inputPending || inputTime < pendingInputTime) {
+        pendingInputTime = inputTime;
+    }
+    inputPending = true;
+}
+
+void FramePacer::retireFrames(size_t maxInFlight) {
+    while (!framesInFlight.empty()) {
+        FrameInFlight &frame = framesInFlight.front();
+        if (framesInFlight.size() >= maxInFlight) {
+            GLenum result;
+            do {
+                result = glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+            } while (result == GL_TIMEOUT_EXPIRED);
+        } else {
+            GLenum result = glClientWaitSync(frame.fence, 0, 0);
+            if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+                break;
+            }
+        }
+
+        if (frame.hasInput) {
+            GLint64 gpuTimeNs = 0;
+            glGetQueryObjecti64v(frame.timestampQuery, GL_QUERY_RESULT, &gpuTimeNs);
+            auto completionTime = calibrationCpuTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::nanoseconds(gpuTimeNs - calibrationGpuTimeNs));
+            latencySamplesMs.push_back(std::max(
+                    std::chrono::duration<double, std::milli>(completionTime - frame.inputTime).count(), 0.0));
+            if (latencySamplesMs.size() > MAX_SAMPLES) {
+                latencySamplesMs.pop_front();
+            }
+        }
+        glDeleteSync(frame.fence);
+        freeQueries.push_back(frame.timestampQuery);
+        framesInFlight.pop_front();
+    }
+}
+
+static double getPercentile(const std::vector<double> &sortedValues, double percentile) {
+    size_t idx = std::min(size_t(percentile * double(sortedValues.size())), sortedValues.size() - 1);
+    return sortedValues.at(idx);
+}
+
+FramePacerStats FramePacer::getStats() {
+    FramePacerStats stats;
+    if (frameStartTimes.size() >= 2) {
+        double elapsedSeconds = std::chrono::duration<double>(frameStartTimes.back() - frameStartTimes.front()).count();
+        stats.framesPerSecond = elapsedSeconds > 0.0 ? double(frameStartTimes.size() - 1) / elapsedSeconds : 0.0;
+    }
+    stats.meanWaitMs = numWaitedFrames > 0 ? totalWaitMs / double(numWaitedFrames) : 0.0;
+    stats.numLatencySamples = latencySamplesMs.size();
+    if (!latencySamplesMs.empty()) {
+        std::vector<double> sortedLatencies(latencySamplesMs.begin(), latencySamplesMs.end());
+        std::sort(sortedLatencies.begin(), sortedLatencies.end());
+        stats.latencyP50Ms = getPercentile(sortedLatencies, 0.5);
+        stats.latencyP95Ms = getPercentile(sortedLatencies, 0.95);
+        stats.latencyP99Ms = getPercentile(sortedLatencies, 0.99);
+        stats.latencyMaxMs = sortedLatencies.back();
+    }
+    return stats;
+}
+
+void FramePacer::resetStats() {
+    latencySamplesMs.clear();
+    frameStartTimes.clear();
+    totalWaitMs = 0.0;
+    numWaitedFrames = 0;
+    // The clocks drift apart over time
+    calibrateClock();
+}
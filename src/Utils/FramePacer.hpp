@@ -0,0 +1,108 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef UTILS_FRAMEPACER_HPP_
+#define UTILS_FRAMEPACER_HPP_
+
+#include <deque>
+#include <vector>
+#include <chrono>
+#include <GL/glew.h>
+
+struct FramePacerStats {
+    double framesPerSecond = 0.0;
+    double meanWaitMs = 0.0; // Time the CPU was blocked per frame
+    size_t numLatencySamples = 0;
+    // Input-to-completion latency percentiles
+    double latencyP50Ms = 0.0, latencyP95Ms = 0.0, latencyP99Ms = 0.0, latencyMaxMs = 0.0;
+};
+
+/**
+ * Limits the number of frames the driver may queue. Each frame ends with a fence, and a new frame waits until fewer
+ * than the maximum number of frames are in flight. One frame in flight has the lowest latency, but the CPU and the
+ * GPU don't overlap; three frames have the highest throughput.
+ *
+ * Input events are timestamped and assigned to the next frame that ends. The latency is the time until the GPU has
+ * finished that frame (i.e., without the wait for the buffer swap), which is read from a timestamp query and not
+ * from the time the fence is polled.
+ */
+class FramePacer {
+public:
+    FramePacer(int maxFramesInFlight = 2);
+    ~FramePacer();
+
+    // 1 to 3
+    void setMaxFramesInFlight(int frames);
+    inline int getMaxFramesInFlight() { return maxFramesInFlight; }
+
+    // Call when the frame starts (only used for the frame rate)
+    void beginFrame();
+    // Call after all commands of the frame (including the GUI) were submitted, before the buffer swap. Blocks while too
+    // many frames are in flight, so the input of the next frame is polled after the wait.
+    void endFrame();
+    // Input that influences the next frame (the earliest input counts until the frame ends)
+    void recordInput(std::chrono::steady_clock::time_point inputTime);
+
+    // Statistics of the frames since the last reset, at most the last MAX_SAMPLES
+    FramePacerStats getStats();
+    void resetStats();
+
+private:
+    struct FrameInFlight {
+        GLsync fence;
+        GLuint timestampQuery;
+        bool hasInput;
+        std::chrono::steady_clock::time_point inputTime;
+    };
+
+    // Retires all finished frames and waits for the oldest ones until fewer than maxInFlight are left
+    void retireFrames(size_t maxInFlight);
+    // Relates the GPU clock of the timestamp queries to the CPU clock
+    void calibrateClock();
+
+    static const size_t MAX_SAMPLES = 4096;
+    int maxFramesInFlight;
+    std::deque<FrameInFlight> framesInFlight;
+    std::vector<GLuint> freeQueries;
+    bool inputPending = false;
+    std::chrono::steady_clock::time_point pendingInputTime;
+    GLint64 calibrationGpuTimeNs = 0;
+    std::chrono::steady_clock::time_point calibrationCpuTime;
+
+    std::deque<double> latencySamplesMs;
+    std::deque<std::chrono::steady_clock::time_point> frameStartTimes;
+    double totalWaitMs = 0.0;
+    size_t numWaitedFrames = 0;
+};
+
+#endif /* UTILS_FRAMEPACER_HPP_ */
@@ -0,0 +1,135 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fstream>
+#include <algorithm>
+#include <Utils/File/Logfile.hpp>
+
+#include "Profiler.hpp"
+
+static const size_t PROFILER_THREAD_BUFFER_CAPACITY = 1 << 16;
+
+thread_local ProfilerThreadBuffer *Profiler::threadBuffer = nullptr;
+
+ProfilerThreadBuffer::ProfilerThreadBuffer(uint32_t threadId, size_t capacity)
+        : threadId(threadId), capacity(capacity), mask(capacity - 1), slots(new EventSlot[capacity]), writeIndex(0) {
+}
+
+void ProfilerThreadBuffer::copyEvents(std::vector<ProfilerEvent> &eventsOut) {
+    uint64_t endIdx = writeIndex.load(std::memory_order_acquire);
+    uint64_t startIdx = endIdx > capacity ? endIdx - capacity : 0;
+    size_t firstEventOut = eventsOut.size();
+    for (uint64_t idx = startIdx; idx < endIdx; idx++) {
+        EventSlot &slot = slots[idx & mask];
+        ProfilerEvent event;
+        event.name = slot.name.load(std::memory_order_relaxed);
+        event.startNs = slot.startNs.load(std::memory_order_relaxed);
+        event.durationNs = slot.durationNs.load(std::memory_order_relaxed);
+        eventsOut.push_back(event);
+    }
+
+    // Drop the events the owning thread may have overwritten while copying. The fence pairs with the one in push, so
+    // if a copied slot was (partly) overwritten by the event with the index i, the loaded write index is at least i.
+    // That event overwrites the index i - capacity, so the events below newEndIdx - capacity may be torn.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t newEndIdx = writeIndex.load(std::memory_order_relaxed) + 1;
+    if (newEndIdx > capacity && newEndIdx - capacity > startIdx) {
+        uint64_t numOverwritten = std::min(newEndIdx - capacity - startIdx, endIdx - startIdx);
+        eventsOut.erase(eventsOut.begin() + firstEventOut, eventsOut.begin() + firstEventOut + numOverwritten);
+    }
+}
+
+Profiler *Profiler::get() {
+    static Profiler profiler;
+    return &profiler;
+}
+
+Profiler::Profiler() : enabled(false), startTime(std::chrono::steady_clock::now()) {
+}
+
+ProfilerThreadBuffer *Profiler::registerThread() {
+    std::lock_guard<std::mutex> lock(threadBuffersMutex);
+    threadBuffers.push_back(std::unique_ptr<ProfilerThreadBuffer>(new ProfilerThreadBuffer(
+            uint32_t(threadBuffers.size()), PROFILER_THREAD_BUFFER_CAPACITY)));
+    return threadBuffers.back().get();
+}
+
+static void writeJsonString(std::ofstream &file, const char *str) {
+    file << '"';
+    for (const char *c = str; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            file << '\\';
+        }
+        file << *c;
+    }
+    file << '"';
+}
+
+bool Profiler::saveTrace(const std::string &filename) {
+    std::ofstream file(filename.c_str());
+    if (!file.is_open()) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in Profiler::saveTrace: Couldn't open file \""
+                + filename + "\" for writing.");
+        return false;
+    }
+    file << std::fixed;
+    file.precision(3);
+
+    std::vector<ProfilerThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(threadBuffersMutex);
+        for (std::unique_ptr<ProfilerThreadBuffer> &buffer : threadBuffers) {
+            buffers.push_back(buffer.get());
+        }
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool firstEvent = true;
+    std::vector<ProfilerEvent> events;
+    for (ProfilerThreadBuffer *buffer : buffers) {
+        events.clear();
+        buffer->copyEvents(events);
+        for (const ProfilerEvent &event : events) {
+            // Complete events ("X") with time stamps in microseconds
+            file << (firstEvent ? "\n" : ",\n") << "{\"name\":";
+            writeJsonString(file, event.name);
+            file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->getThreadId()
+                 << ",\"ts\":" << double(event.startNs) * 1e-3 << ",\"dur\":" << double(event.durationNs) * 1e-3 << "}";
+            firstEvent = false;
+        }
+    }
+    file << "\n]}\n";
+    file.close();
+
+    sgl::Logfile::get()->writeInfo(std::string() + "Saved profiler trace to \"" + filename + "\".");
+    return true;
+}
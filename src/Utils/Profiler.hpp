@@ -0,0 +1,146 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef UTILS_PROFILER_HPP_
+#define UTILS_PROFILER_HPP_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+/// Records the time spent in the enclosing scope. The name needs to be a string literal.
+#define PROFILE_SCOPE(name) ScopedProfilerEvent PROFILER_CONCAT(scopedProfilerEvent, __LINE__)(name)
+
+struct ProfilerEvent {
+    const char *name;
+    uint64_t startNs;
+    uint64_t durationNs;
+};
+
+/**
+ * Single producer ring buffer. Only the thread owning the buffer writes to it, and the buffer is read when the
+ * trace is saved. Old events are overwritten if the buffer is full. The slots are relaxed atomics, so reading them
+ * while the owning thread writes isn't a data race; events overwritten during the copy are dropped afterwards.
+ */
+class ProfilerThreadBuffer {
+public:
+    ProfilerThreadBuffer(uint32_t threadId, size_t capacity);
+    inline void push(const ProfilerEvent &event) {
+        uint64_t idx = writeIndex.load(std::memory_order_relaxed);
+        // A reader that sees the new contents of the slot also sees the index stored before (see copyEvents)
+        std::atomic_thread_fence(std::memory_order_release);
+        EventSlot &slot = slots[idx & mask];
+        slot.name.store(event.name, std::memory_order_relaxed);
+        slot.startNs.store(event.startNs, std::memory_order_relaxed);
+        slot.durationNs.store(event.durationNs, std::memory_order_relaxed);
+        writeIndex.store(idx + 1, std::memory_order_release);
+    }
+    // Copies the events currently stored in the buffer
+    void copyEvents(std::vector<ProfilerEvent> &eventsOut);
+    inline uint32_t getThreadId() { return threadId; }
+
+private:
+    struct EventSlot {
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> startNs;
+        std::atomic<uint64_t> durationNs;
+    };
+
+    uint32_t threadId;
+    uint64_t capacity, mask;
+    std::unique_ptr<EventSlot[]> slots;
+    std::atomic<uint64_t> writeIndex;
+};
+
+class Profiler {
+public:
+    static Profiler *get();
+
+    // When disabled, a profiled scope costs a single relaxed atomic load
+    inline bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    inline void setEnabled(bool _enabled) { enabled.store(_enabled, std::memory_order_relaxed); }
+
+    inline uint64_t getTimeNs() {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - startTime).count());
+    }
+    inline void addEvent(const ProfilerEvent &event) {
+        if (!threadBuffer) {
+            threadBuffer = registerThread();
+        }
+        threadBuffer->push(event);
+    }
+
+    // Writes all recorded events in the Chrome trace event format (chrome://tracing, Perfetto)
+    bool saveTrace(const std::string &filename);
+
+private:
+    Profiler();
+    ProfilerThreadBuffer *registerThread();
+
+    std::atomic<bool> enabled;
+    std::chrono::steady_clock::time_point startTime;
+    std::mutex threadBuffersMutex;
+    std::vector<std::unique_ptr<ProfilerThreadBuffer>> threadBuffers;
+    static thread_local ProfilerThreadBuffer *threadBuffer;
+};
+
+class ScopedProfilerEvent {
+public:
+    explicit ScopedProfilerEvent(const char *_name) : name(nullptr) {
+        if (Profiler::get()->isEnabled()) {
+            name = _name;
+            startNs = Profiler::get()->getTimeNs();
+        }
+    }
+    ~ScopedProfilerEvent() {
+        if (name) {
+            ProfilerEvent event;
+            event.name = name;
+            event.startNs = startNs;
+            event.durationNs = Profiler::get()->getTimeNs() - startNs;
+            Profiler::get()->addEvent(event);
+        }
+    }
+
+private:
+    const char *name;
+    uint64_t startNs;
+};
+
+#endif /* UTILS_PROFILER_HPP_ */
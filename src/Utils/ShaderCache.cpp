@@ -0,0 +1,216 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+
+#include <GL/glew.h>
+#include <Utils/AppSettings.hpp>
+#include <Utils/File/FileUtils.hpp>
+#include <Utils/File/Logfile.hpp>
+#include <Graphics/OpenGL/Shader.hpp>
+
+#include "ShaderCache.hpp"
+
+static const uint32_t PROGRAM_BINARY_MAGIC = 0x42505653u; // "SVPB"
+
+static uint64_t hashString(uint64_t hash, const std::string &str) {
+    // FNV-1a, the string is terminated with a zero byte so that "ab"+"c" and "a"+"bc" differ
+    for (size_t i = 0; i <= str.size(); i++) {
+        hash ^= i < str.size() ? uint64_t(uint8_t(str[i])) : 0ull;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static std::string getGLString(GLenum name) {
+    const GLubyte *str = glGetString(name);
+    return str ? std::string(reinterpret_cast<const char*>(str)) : std::string();
+}
+
+ShaderCache *ShaderCache::get() {
+    static ShaderCache instance;
+    return &instance;
+}
+
+ShaderCache::ShaderCache() {
+    driverString = getGLString(GL_VENDOR) + "|" + getGLString(GL_RENDERER) + "|" + getGLString(GL_VERSION);
+    GLint numBinaryFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numBinaryFormats);
+    binariesSupported = numBinaryFormats > 0;
+}
+
+void ShaderCache::setDirectory(const std::string &_directory) {
+    directory = _directory;
+    if (!directory.empty()) {
+        sgl::FileUtils::get()->ensureDirectoryExists(directory);
+    }
+}
+
+const std::string &ShaderCache::getShaderFileContent(const std::string &shaderId) {
+    // "LightMix.Fragment" is stored in "LightMix.glsl"
+    std::string filename = shaderId.substr(0, shaderId.find('.')) + ".glsl";
+    auto it = fileContents.find(filename);
+    if (it != fileContents.end()) {
+        return it->second;
+    }
+    std::ifstream file(sgl::AppSettings::get()->getDataDirectory() + "Shaders/" + filename, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return fileContents[filename] = content.str();
+}
+
+std::string ShaderCache::computeKey(const std::vector<std::string> &shaderIds, const ShaderDefines &defines) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = hashString(hash, driverString);
+    hash = hashString(hash, getShaderFileContent("GlobalDefines"));
+    for (const std::string &shaderId : shaderIds) {
+        hash = hashString(hash, shaderId);
+        hash = hashString(hash, getShaderFileContent(shaderId));
+    }
+    for (auto &define : defines) {
+        hash = hashString(hash, define.first);
+        hash = hashString(hash, define.second);
+    }
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash));
+    return key;
+}
+
+sgl::ShaderProgramPtr ShaderCache::getShaderProgram(
+        const std::vector<std::string> &shaderIds, const ShaderDefines &defines) {
+    auto startTime = std::chrono::steady_clock::now();
+    std::string key = computeKey(shaderIds, defines);
+    auto it = programs.find(key);
+    if (it != programs.end()) {
+        statistics.numMemoryHits++;
+        return it->second;
+    }
+
+    sgl::ShaderProgramPtr program;
+    bool useDiskCache = binariesSupported && !directory.empty();
+    std::string filename = directory + key + ".bin";
+    if (useDiskCache) {
+        program = loadProgramBinary(filename);
+    }
+    if (program) {
+        statistics.numDiskHits++;
+    } else {
+        program = compileProgram(shaderIds, defines);
+        statistics.numCompiled++;
+        if (useDiskCache) {
+            saveProgramBinary(program, filename);
+        }
+    }
+    programs.insert(std::make_pair(key, program));
+    statistics.loadTimeMs += std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - startTime).count();
+    return program;
+}
+
+sgl::ShaderProgramPtr ShaderCache::compileProgram(
+        const std::vector<std::string> &shaderIds, const ShaderDefines &defines) {
+    if (defines.empty()) {
+        return sgl::ShaderManager->getShaderProgram(shaderIds);
+    }
+
+    // The shader manager caches the compiled shader objects by their ID only, so the cache needs to be flushed
+    // both for compiling the variant and for restoring the default variant afterwards.
+    for (auto &define : defines) {
+        sgl::ShaderManager->addPreprocessorDefine(define.first, define.second);
+    }
+    sgl::ShaderManager->invalidateShaderCache();
+    sgl::ShaderProgramPtr program = sgl::ShaderManager->getShaderProgram(shaderIds);
+    for (auto &define : defines) {
+        sgl::ShaderManager->removePreprocessorDefine(define.first);
+    }
+    sgl::ShaderManager->invalidateShaderCache();
+    return program;
+}
+
+sgl::ShaderProgramPtr ShaderCache::loadProgramBinary(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return sgl::ShaderProgramPtr();
+    }
+    uint32_t magic = 0, binaryFormat = 0, binarySize = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(&binaryFormat), sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(&binarySize), sizeof(uint32_t));
+    if (!file || magic != PROGRAM_BINARY_MAGIC || binarySize == 0) {
+        return sgl::ShaderProgramPtr();
+    }
+    std::vector<char> binary(binarySize);
+    file.read(&binary.front(), binarySize);
+    if (!file) {
+        return sgl::ShaderProgramPtr();
+    }
+
+    sgl::ShaderProgramGL *programGL = new sgl::ShaderProgramGL();
+    sgl::ShaderProgramPtr program(programGL);
+    GLuint programID = programGL->getShaderProgramID();
+    glProgramBinary(programID, binaryFormat, &binary.front(), GLsizei(binarySize));
+    GLint linkStatus = GL_FALSE;
+    glGetProgramiv(programID, GL_LINK_STATUS, &linkStatus);
+    if (linkStatus != GL_TRUE) {
+        // The driver may reject binaries at any time, e.g. after an update not reflected in the version string
+        sgl::Logfile::get()->writeInfo(std::string() + "ShaderCache: Discarding outdated program binary \""
+                + filename + "\".");
+        return sgl::ShaderProgramPtr();
+    }
+    return program;
+}
+
+void ShaderCache::saveProgramBinary(sgl::ShaderProgramPtr &program, const std::string &filename) {
+    sgl::ShaderProgramGL *programGL = static_cast<sgl::ShaderProgramGL*>(program.get());
+    GLuint programID = programGL->getShaderProgramID();
+    GLint binarySize = 0;
+    glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+    if (binarySize <= 0) {
+        return;
+    }
+    std::vector<char> binary(binarySize);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(programID, binarySize, nullptr, &binaryFormat, &binary.front());
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in ShaderCache::saveProgramBinary: Couldn't open file \""
+                + filename + "\".");
+        return;
+    }
+    uint32_t header[3] = { PROGRAM_BINARY_MAGIC, uint32_t(binaryFormat), uint32_t(binarySize) };
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(&binary.front(), binarySize);
+}
@@ -0,0 +1,86 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef UTILS_SHADERCACHE_HPP_
+#define UTILS_SHADERCACHE_HPP_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+#include <Graphics/Shader/ShaderManager.hpp>
+
+/// Preprocessor defines used for specializing a shader variant at compile time (token -> value)
+typedef std::map<std::string, std::string> ShaderDefines;
+
+struct ShaderCacheStatistics {
+    int numMemoryHits = 0;
+    int numDiskHits = 0;
+    int numCompiled = 0;
+    double loadTimeMs = 0.0;
+};
+
+/**
+ * Wraps sgl::ShaderManager->getShaderProgram.
+ * - Linked programs are kept in memory, i.e., recreating a light manager doesn't compile or link anything.
+ * - Program binaries are stored on disk (glGetProgramBinary/glProgramBinary). The key is a hash of the shader
+ *   sources, the driver strings and the defines, so a changed shader or driver update results in a recompile.
+ * - Variants are specialized with #define directives instead of branching on uniforms at runtime.
+ */
+class ShaderCache {
+public:
+    static ShaderCache *get();
+
+    /// An empty directory disables the on-disk cache
+    void setDirectory(const std::string &directory);
+    sgl::ShaderProgramPtr getShaderProgram(
+            const std::vector<std::string> &shaderIds, const ShaderDefines &defines = ShaderDefines());
+    inline const ShaderCacheStatistics &getStatistics() { return statistics; }
+
+private:
+    ShaderCache();
+    std::string computeKey(const std::vector<std::string> &shaderIds, const ShaderDefines &defines);
+    const std::string &getShaderFileContent(const std::string &shaderId);
+    sgl::ShaderProgramPtr compileProgram(const std::vector<std::string> &shaderIds, const ShaderDefines &defines);
+    sgl::ShaderProgramPtr loadProgramBinary(const std::string &filename);
+    void saveProgramBinary(sgl::ShaderProgramPtr &program, const std::string &filename);
+
+    std::string directory;
+    std::string driverString;
+    bool binariesSupported;
+    std::map<std::string, sgl::ShaderProgramPtr> programs;
+    std::map<std::string, std::string> fileContents;
+    ShaderCacheStatistics statistics;
+};
+
+#endif /* UTILS_SHADERCACHE_HPP_ */
@@ -0,0 +1,156 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cstring>
+#include <Graphics/Renderer.hpp>
+#include <Graphics/OpenGL/GeometryBuffer.hpp>
+
+#include "StagingUploader.hpp"
+
+StagingUploader::StagingUploader(size_t budgetPerFrame) : budgetPerFrame(budgetPerFrame) {
+}
+
+StagingUploader::~StagingUploader() {
+    if (mappedSegment) {
+        glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        if (segmentFences[i]) {
+            glDeleteSync(segmentFences[i]);
+        }
+    }
+    if (stagingBuffer) {
+        glDeleteBuffers(1, &stagingBuffer);
+    }
+}
+
+void StagingUploader::setBudget(size_t bytesPerFrame) {
+    budgetPerFrame = bytesPerFrame;
+}
+
+bool StagingUploader::beginFrame() {
+    frameStarted = true;
+    if (segmentSize != budgetPerFrame) {
+        // The old buffer is only deleted by the driver once the GPU doesn't use it anymore
+        if (stagingBuffer) {
+            glDeleteBuffers(1, &stagingBuffer);
+        }
+        for (int i = 0; i < NUM_SEGMENTS; i++) {
+            if (segmentFences[i]) {
+                glDeleteSync(segmentFences[i]);
+                segmentFences[i] = 0;
+            }
+        }
+        segmentSize = budgetPerFrame;
+        glGenBuffers(1, &stagingBuffer);
+        glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+        glBufferData(GL_COPY_READ_BUFFER, GLsizeiptr(segmentSize * NUM_SEGMENTS), nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+
+    GLsync &fence = segmentFences[currentSegment];
+    if (fence) {
+        GLenum waitResult = glClientWaitSync(fence, 0, 0);
+        if (waitResult != GL_ALREADY_SIGNALED && waitResult != GL_CONDITION_SATISFIED) {
+            return false;
+        }
+        glDeleteSync(fence);
+        fence = 0;
+    }
+    return true;
+}
+
+bool StagingUploader::canUpload(size_t size) {
+    if (!frameStarted) {
+        segmentAvailable = beginFrame();
+    }
+    if (size > segmentSize) {
+        return uploadedBytes == 0;
+    }
+    // The bytes uploaded directly count towards the budget as well
+    return segmentAvailable && segmentOffset + size <= segmentSize && uploadedBytes + size <= budgetPerFrame;
+}
+
+sgl::GeometryBufferPtr StagingUploader::upload(const void *data, size_t size) {
+    uploadedBytes += size;
+    if (size > segmentSize || !segmentAvailable || segmentOffset + size > segmentSize) {
+        return sgl::Renderer->createGeometryBuffer(size, const_cast<void*>(data));
+    }
+
+    if (!mappedSegment) {
+        glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+        // The fence guarantees that the GPU is done with the segment, so the driver doesn't need to synchronize
+        mappedSegment = glMapBufferRange(
+                GL_COPY_READ_BUFFER, GLintptr(segmentSize * currentSegment), GLsizeiptr(segmentSize),
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        if (!mappedSegment) {
+            segmentAvailable = false;
+            return sgl::Renderer->createGeometryBuffer(size, const_cast<void*>(data));
+        }
+    }
+    memcpy(static_cast<uint8_t*>(mappedSegment) + segmentOffset, data, size);
+    sgl::GeometryBufferPtr geometryBuffer = sgl::Renderer->createGeometryBuffer(
+            size, sgl::VERTEX_BUFFER, sgl::BUFFER_STATIC);
+    GLuint buffer = static_cast<sgl::GeometryBufferGL*>(geometryBuffer.get())->getBuffer();
+    pendingCopies.push_back({buffer, segmentSize * currentSegment + segmentOffset, size});
+    segmentOffset += size;
+    return geometryBuffer;
+}
+
+void StagingUploader::endFrame() {
+    if (mappedSegment) {
+        glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        mappedSegment = nullptr;
+        for (const PendingCopy &copy : pendingCopies) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, copy.buffer);
+            glCopyBufferSubData(
+                    GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GLintptr(copy.stagingOffset), 0,
+                    GLsizeiptr(copy.size));
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        segmentFences[currentSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        currentSegment = (currentSegment + 1) % NUM_SEGMENTS;
+    }
+    pendingCopies.clear();
+    segmentOffset = 0;
+    frameStarted = false;
+    segmentAvailable = false;
+    uploadedBytesLastFrame = uploadedBytes;
+    totalUploadedBytes += uploadedBytes;
+    uploadedBytes = 0;
+}
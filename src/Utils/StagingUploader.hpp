@@ -0,0 +1,91 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef UTILS_STAGINGUPLOADER_HPP_
+#define UTILS_STAGINGUPLOADER_HPP_
+
+#include <vector>
+#include <cstddef>
+#include <GL/glew.h>
+#include <Graphics/Buffers/GeometryBuffer.hpp>
+
+/**
+ * Uploads vertex data through a staging buffer within a per-frame byte budget. The staging buffer is a ring of one
+ * segment per frame in flight. The data is written to the mapped segment of the frame and copied to the vertex
+ * buffers on the GPU at the end of the frame. A segment is only written again once the fence of its last frame has
+ * signaled, i.e., uploading never waits for the GPU. Nothing is uploaded in a frame whose segment is still in use.
+ */
+class StagingUploader {
+public:
+    explicit StagingUploader(size_t budgetPerFrame = 4 * 1024 * 1024);
+    ~StagingUploader();
+    // Takes effect in the next frame (the staging buffer is allocated again)
+    void setBudget(size_t bytesPerFrame);
+    inline size_t getBudget() { return budgetPerFrame; }
+
+    /**
+     * True if data of the passed size can still be uploaded in this frame. Data larger than the whole budget is
+     * uploaded directly (without staging) if nothing else was uploaded in the frame, so it can't starve.
+     */
+    bool canUpload(size_t size);
+    // Creates a vertex buffer with the passed data. Call canUpload first.
+    sgl::GeometryBufferPtr upload(const void *data, size_t size);
+    // Copies the data of this frame to the vertex buffers and starts the next frame
+    void endFrame();
+
+    inline size_t getUploadedBytesLastFrame() { return uploadedBytesLastFrame; }
+    inline size_t getTotalUploadedBytes() { return totalUploadedBytes; }
+
+private:
+    struct PendingCopy {
+        GLuint buffer;
+        size_t stagingOffset;
+        size_t size;
+    };
+    // False if the GPU still reads from the segment of this frame
+    bool beginFrame();
+
+    static const int NUM_SEGMENTS = 3;
+    size_t budgetPerFrame, segmentSize = 0;
+    GLuint stagingBuffer = 0;
+    GLsync segmentFences[NUM_SEGMENTS] = {};
+    int currentSegment = 0;
+    bool frameStarted = false, segmentAvailable = false;
+    void *mappedSegment = nullptr;
+    size_t segmentOffset = 0;
+    std::vector<PendingCopy> pendingCopies;
+
+    size_t uploadedBytes = 0, uploadedBytesLastFrame = 0, totalUploadedBytes = 0;
+};
+
+#endif /* UTILS_STAGINGUPLOADER_HPP_ */
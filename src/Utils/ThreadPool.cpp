@@ -0,0 +1,125 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(size_t numThreads) : nextTask(0), numRemainingTasks(0) {
+    if (numThreads == 0) {
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    for (size_t i = 1; i < numThreads; i++) {
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    workCondition.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(int numTasks, const std::function<void(int)> &task) {
+    if (numTasks <= 0) {
+        return;
+    }
+    if (workers.empty() || numTasks == 1) {
+        for (int i = 0; i < numTasks; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTask = &task;
+        currentNumTasks = numTasks;
+        nextTask = 0;
+        numRemainingTasks = numTasks;
+        generation++;
+    }
+    workCondition.notify_all();
+
+    runTasks(&task, numTasks);
+
+    // Workers that are still inside runTasks may not see the task counter of the next call
+    std::unique_lock<std::mutex> lock(mutex);
+    finishedCondition.wait(lock, [this]{ return numRemainingTasks == 0 && numActiveWorkers == 0; });
+    currentTask = nullptr;
+}
+
+void ThreadPool::runTasks(const std::function<void(int)> *task, int numTasks) {
+    while (true) {
+        int i = nextTask.fetch_add(1);
+        if (i >= numTasks) {
+            break;
+        }
+        (*task)(i);
+        if (numRemainingTasks.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            finishedCondition.notify_all();
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t lastGeneration = 0;
+    while (true) {
+        const std::function<void(int)> *task;
+        int numTasks;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workCondition.wait(lock, [&]{ return quit || (generation != lastGeneration && currentTask != nullptr); });
+            if (quit) {
+                return;
+            }
+            lastGeneration = generation;
+            task = currentTask;
+            numTasks = currentNumTasks;
+            numActiveWorkers++;
+        }
+
+        runTasks(task, numTasks);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        numActiveWorkers--;
+        if (numActiveWorkers == 0) {
+            finishedCondition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017-2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef UTILS_THREADPOOL_HPP_
+#define UTILS_THREADPOOL_HPP_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+/**
+ * Fixed set of worker threads for data parallel loops. The calling thread takes part in the work.
+ */
+class ThreadPool {
+public:
+    // numThreads: Total number of threads including the calling thread (0: number of hardware threads)
+    explicit ThreadPool(size_t numThreads = 0);
+    ~ThreadPool();
+
+    // Calls task(i) for all i in [0, numTasks) and returns when all calls have finished
+    void parallelFor(int numTasks, const std::function<void(int)> &task);
+    inline size_t getNumThreads() { return workers.size() + 1; }
+
+private:
+    void workerLoop();
+    void runTasks(const std::function<void(int)> *task, int numTasks);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable workCondition;
+    std::condition_variable finishedCondition;
+    const std::function<void(int)> *currentTask = nullptr;
+    int currentNumTasks = 0;
+    uint64_t generation = 0;
+    int numActiveWorkers = 0;
+    std::atomic<int> nextTask;
+    std::atomic<int> numRemainingTasks;
+    bool quit = false;
+};
+
+#endif /* UTILS_THREADPOOL_HPP_ */